@@ -0,0 +1,39 @@
+#!/usr/bin/python
+#
+# This example walks the association graph from a computer system to its
+# logical disks and further to the storage extents they are based on.
+#
+# To make this example work, modify following variables:
+#   hostname
+#   username
+#   password
+
+import lmiwbem
+
+
+hostname = 'hostname'
+username = 'username'
+password = 'password'
+
+# Connect to CIMOM.
+conn = lmiwbem.WBEMConnection()
+conn.connect(hostname, username, password)
+
+# Get the computer system instance names, which will be the starting points.
+systems = conn.EnumerateInstanceNames('PG_ComputerSystem', 'root/cimv2')
+
+# Walk 2 levels of the association graph.
+nodes, edges = conn.TraverseAssociatorNames(
+    systems,
+    Hops=[
+        {'AssocClass': 'CIM_SystemDevice', 'ResultClass': 'CIM_LogicalDisk'},
+        {'AssocClass': 'CIM_BasedOn', 'ResultClass': 'CIM_StorageExtent'}],
+    Depth=None)
+
+# Do something with the graph.
+print nodes
+for src, dst in edges:
+    print src, '->', dst
+
+# Disconnect from CIMOM.
+conn.disconnect()
@@ -28,12 +28,15 @@
 #include <boost/python/scope.hpp>
 #include "lmiwbem_config.h"
 #include "lmiwbem_exception.h"
+#include "obj/lmiwbem_batch.h"
 #include "obj/lmiwbem_connection.h"
 #ifdef HAVE_PEGASUS_LISTENER
 #  include "obj/lmiwbem_listener.h"
 #endif // HAVE_PEGASUS_LISTENER
 #ifdef HAVE_SLP
 #  include "obj/lmiwbem_slp.h"
+#  include "obj/lmiwbem_slp_connector.h"
+#  include "obj/lmiwbem_slp_discovery.h"
 #endif // HAVE_SLP
 #include "obj/lmiwbem_nocasedict.h"
 #include "obj/cim/lmiwbem_class.h"
@@ -49,7 +52,9 @@
 #include "obj/cim/lmiwbem_property.h"
 #include "obj/cim/lmiwbem_qualifier.h"
 #include "obj/cim/lmiwbem_types.h"
+#include "util/lmiwbem_census.h"
 #include "util/lmiwbem_convert.h"
+#include "util/lmiwbem_operation_stats.h"
 #include "util/lmiwbem_util.h"
 
 #include <list>
@@ -98,12 +103,38 @@ BOOST_PYTHON_MODULE(lmiwbem_core) {
         ":param string ns: namespace where to look for :py:class:`.CIMClass`-es\n"
         ":param string superclass: super class name\n"
         ":param subclass: either string containing sub class name of\n"
-        "\t:py:class:`.CIMClass` instance");
+        "\t:py:class:`.CIMClass` instance\n\n"
+        "If the class hierarchy of the namespace was retrieved by\n"
+        ":py:meth:`.WBEMConnection.RefreshClassHierarchy`, no CIM operation is\n"
+        "performed.");
     def("is_error",
         is_error,
         "Checks, if the input value equals to a CIM or connection error code.\n\n"
         ":param int value: integer to check\n"
         ":returns: True, if value equals to a error code; False otherwise");
+    bp::def("operation_stats",
+        operation_stats,
+        "Returns histograms of durations of phases of CIM operations performed\n"
+        "by all :py:class:`.WBEMConnection` objects in the process; see\n"
+        ":py:meth:`.WBEMConnection.stats`.\n\n"
+        ":returns: dictionary keyed by operation names; values are\n"
+        "\tdictionaries keyed by phase names\n"
+        ":rtype: dict");
+    bp::def("reset_operation_stats",
+        reset_operation_stats,
+        "Forgets process-wide operation phase histograms collected so far.");
+    def("object_census",
+        object_census,
+        "Returns counts and approximate memory usage of live native objects.\n"
+        "``bytes`` is memory of the native objects and their members,\n"
+        "``lazy_bytes`` is memory held by CIMOM data not converted to Python\n"
+        "objects yet. Sizes of Python objects referenced by the objects are\n"
+        "not included.\n\n"
+        ":returns: dictionary keyed by class names (``CIMInstance``,\n"
+        "\t``CIMInstanceName``, ``CIMProperty``, ``CIMQualifier``,\n"
+        "\t``CIMClass``, ``NocaseDict``); values are dictionaries with keys\n"
+        "\t``count``, ``bytes`` and ``lazy_bytes``\n"
+        ":rtype: dict");
 
     // Initialize Python classes
     MinutesFromUTC::init_type();
@@ -124,6 +155,7 @@ BOOST_PYTHON_MODULE(lmiwbem_core) {
 
     // Initialize own classes
     WBEMConnection::init_type();
+    WBEMBatch::init_type();
     NocaseDict::init_type();
     NocaseDictKeyIterator::init_type();
     NocaseDictValueIterator::init_type();
@@ -140,6 +172,7 @@ BOOST_PYTHON_MODULE(lmiwbem_core) {
     CIMConstants::init_type();
 #  ifdef HAVE_PEGASUS_LISTENER
     CIMIndicationListener::init_type();
+    CIMIndicationSpool::init_type();
 #  endif // HAVE_PEGASUS_LISTENER
 #  ifdef HAVE_PEGASUS_ENUMERATION_CONTEXT
     CIMEnumerationContext::init_type();
@@ -147,5 +180,7 @@ BOOST_PYTHON_MODULE(lmiwbem_core) {
 #  ifdef HAVE_SLP
     SLP::init_type();
     SLPResult::init_type();
+    SLPDiscovery::init_type();
+    SLPConnector::init_type();
 #  endif // HAVE_SLP
 }
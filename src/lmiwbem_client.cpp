@@ -21,10 +21,10 @@
 
 #include <config.h>
 #include <Pegasus/Common/SSLContext.h>
+#include <Pegasus/Client/CIMClientException.h>
 #include "lmiwbem_client.h"
-#include "lmiwbem_exception.h"
 #include "lmiwbem_gil.h"
-#include "obj/cim/lmiwbem_constants.h"
+#include "lmiwbem_trace.h"
 
 #include <cctype>
 
@@ -43,6 +43,8 @@ CIMClient::ScopedCIMClientTransaction::~ScopedCIMClientTransaction()
 CIMClient::CIMClient()
     : Pegasus::CIMClient()
     , m_url_info()
+    , m_cert_file()
+    , m_key_file()
     , m_is_connected(false)
     , m_verify_cert(true)
 {
@@ -56,11 +58,9 @@ void CIMClient::connect(
     const String &key_file,
     const String &trust_store)
 {
-    if (!m_url_info.set(uri)) {
-        throw_ConnectionError(
-            "Invalid locator",
-            CIMConstants::CON_ERR_INVALID_LOCATOR);
-    }
+    // May be called without the GIL; don't raise Python exception here.
+    if (!m_url_info.set(uri))
+        throw Pegasus::InvalidLocatorException(uri);
 
     if (!m_url_info.isHttps()) {
         Pegasus::CIMClient::connect(
@@ -87,6 +87,10 @@ void CIMClient::connect(
             password);
     }
     m_is_connected = true;
+    m_cert_file = cert_file;
+    m_key_file = key_file;
+
+    LMIWBEM_TRACE2(connect, m_url_info.hostname().c_str(), m_url_info.port());
 }
 
 void CIMClient::connectLocally()
@@ -94,12 +98,16 @@ void CIMClient::connectLocally()
     Pegasus::CIMClient::connectLocal();
     m_is_connected = true;
     m_url_info.set("localhost");
+
+    LMIWBEM_TRACE2(connect, m_url_info.hostname().c_str(), m_url_info.port());
 }
 
 void CIMClient::disconnect()
 {
     Pegasus::CIMClient::disconnect();
     m_is_connected = false;
+
+    LMIWBEM_TRACE1(disconnect, m_url_info.hostname().c_str());
 }
 
 bool CIMClient::isConnected() const
@@ -122,6 +130,16 @@ URLInfo CIMClient::getURLInfo() const
     return m_url_info;
 }
 
+String CIMClient::getCertFile() const
+{
+    return m_cert_file;
+}
+
+String CIMClient::getKeyFile() const
+{
+    return m_key_file;
+}
+
 String CIMClient::hostname() const
 {
     return m_url_info.hostname();
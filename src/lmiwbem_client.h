@@ -66,6 +66,8 @@ public:
     void setVerifyCertificate(bool verify = true);
     bool getVerifyCertificate() const;
     URLInfo getURLInfo() const;
+    String getCertFile() const;
+    String getKeyFile() const;
     String hostname() const;
 
 private:
@@ -82,6 +84,8 @@ private:
 #  endif // HAVE_PEGASUS_VERIFICATION_CALLBACK_WITH_DATA
 
     URLInfo m_url_info;
+    String m_cert_file;
+    String m_key_file;
     Mutex m_mutex;
     bool m_is_connected;
     bool m_verify_cert;
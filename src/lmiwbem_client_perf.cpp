@@ -0,0 +1,280 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include <algorithm>
+#include <sstream>
+#include <boost/python/dict.hpp>
+#include "lmiwbem_client_perf.h"
+#include "lmiwbem_exception.h"
+#include "lmiwbem_gil.h"
+#include "lmiwbem_trace.h"
+#include "util/lmiwbem_convert.h"
+#include "util/lmiwbem_util.h"
+
+ClientPerformanceData::Stats::Stats()
+    : count(0)
+    , round_trip_time(0)
+    , round_trip_time_min(0)
+    , round_trip_time_max(0)
+    , server_time_count(0)
+    , server_time(0)
+    , server_time_max(0)
+    , request_size(0)
+    , response_size(0)
+{
+}
+
+ClientPerformanceData::ScopedCallbacks::ScopedCallbacks(
+    ClientPerformanceData &perf_data)
+    : m_perf_data(perf_data)
+{
+}
+
+ClientPerformanceData::ScopedCallbacks::~ScopedCallbacks()
+{
+    m_perf_data.flushCallbacks();
+}
+
+ClientPerformanceData::ClientPerformanceData()
+    : Pegasus::ClientOpPerformanceDataHandler()
+    , m_mutex()
+    , m_classname()
+    , m_response_size(0)
+    , m_stats()
+    , m_callback()
+    , m_has_callback(false)
+    , m_pending()
+{
+}
+
+void ClientPerformanceData::handleClientOpPerformanceData(
+    const Pegasus::ClientOpPerformanceData &item)
+{
+    const String operation(operationName(item.operationType));
+    String classname;
+
+    {
+        ScopedMutex sm(m_mutex);
+        classname = m_classname;
+        m_response_size += item.responseSize;
+
+        Stats &stats = m_stats[key_t(operation, classname)];
+        if (stats.count == 0 || item.roundTripTime < stats.round_trip_time_min)
+            stats.round_trip_time_min = item.roundTripTime;
+        stats.round_trip_time_max = std::max(
+            stats.round_trip_time_max, item.roundTripTime);
+        stats.round_trip_time += item.roundTripTime;
+        stats.request_size += item.requestSize;
+        stats.response_size += item.responseSize;
+        ++stats.count;
+
+        if (item.serverTimeKnown) {
+            stats.server_time_max = std::max(
+                stats.server_time_max, item.serverTime);
+            stats.server_time += item.serverTime;
+            ++stats.server_time_count;
+        }
+
+        // Called within client transaction; the Python callback is called
+        // later by flushCallbacks().
+        if (m_has_callback) {
+            CallbackItem cb_item;
+            cb_item.operation = operation;
+            cb_item.classname = classname;
+            cb_item.round_trip_time = item.roundTripTime;
+            cb_item.server_time_known = item.serverTimeKnown;
+            cb_item.server_time = item.serverTime;
+            cb_item.request_size = item.requestSize;
+            cb_item.response_size = item.responseSize;
+            m_pending.push_back(cb_item);
+        }
+    }
+
+    LMIWBEM_TRACE5(client_perf,
+        operation.c_str(),
+        classname.c_str(),
+        item.roundTripTime,
+        item.requestSize,
+        item.responseSize);
+}
+
+void ClientPerformanceData::setClassname(const String &classname)
+{
+    ScopedMutex sm(m_mutex);
+    m_classname = classname;
+}
+
+String ClientPerformanceData::getClassname()
+{
+    ScopedMutex sm(m_mutex);
+    return m_classname;
+}
+
+Pegasus::Uint64 ClientPerformanceData::getResponseSize()
+{
+    ScopedMutex sm(m_mutex);
+    return m_response_size;
+}
+
+void ClientPerformanceData::setCallback(const bp::object &callback)
+{
+    if (!isnone(callback) && !iscallable(callback))
+        throw_TypeError("callback must be callable or None");
+
+    ScopedMutex sm(m_mutex);
+    m_callback = callback;
+    m_has_callback = !isnone(callback);
+    if (!m_has_callback)
+        m_pending.clear();
+}
+
+bp::object ClientPerformanceData::getCallback()
+{
+    ScopedMutex sm(m_mutex);
+    return m_callback;
+}
+
+void ClientPerformanceData::flushCallbacks()
+{
+    std::vector<CallbackItem> pending;
+    bp::object callback;
+
+    {
+        ScopedMutex sm(m_mutex);
+        if (m_pending.empty())
+            return;
+        pending.swap(m_pending);
+        callback = m_callback;
+    }
+
+    // WBEMConnection operations hold the GIL; acquiring it again is cheap.
+    ScopedGILAcquire sa;
+
+    if (isnone(callback))
+        return;
+
+    // May be called during propagation of Python exception; preserve it.
+    PyObject *type, *value, *traceback;
+    PyErr_Fetch(&type, &value, &traceback);
+
+    std::vector<CallbackItem>::const_iterator it;
+    for (it = pending.begin(); it != pending.end(); ++it)
+        callCallback(callback, *it);
+
+    PyErr_Restore(type, value, traceback);
+}
+
+ClientPerformanceData::stats_map_t ClientPerformanceData::getStats()
+{
+    ScopedMutex sm(m_mutex);
+    return m_stats;
+}
+
+void ClientPerformanceData::reset()
+{
+    ScopedMutex sm(m_mutex);
+    m_stats.clear();
+}
+
+String ClientPerformanceData::operationName(Pegasus::CIMOperationType type)
+{
+    switch (type) {
+    case Pegasus::CIMOPTYPE_INVOKE_METHOD:
+        return "InvokeMethod";
+    case Pegasus::CIMOPTYPE_GET_CLASS:
+        return "GetClass";
+    case Pegasus::CIMOPTYPE_GET_INSTANCE:
+        return "GetInstance";
+    case Pegasus::CIMOPTYPE_EXPORT_INDICATION:
+        return "ExportIndication";
+    case Pegasus::CIMOPTYPE_DELETE_CLASS:
+        return "DeleteClass";
+    case Pegasus::CIMOPTYPE_DELETE_INSTANCE:
+        return "DeleteInstance";
+    case Pegasus::CIMOPTYPE_CREATE_CLASS:
+        return "CreateClass";
+    case Pegasus::CIMOPTYPE_CREATE_INSTANCE:
+        return "CreateInstance";
+    case Pegasus::CIMOPTYPE_MODIFY_CLASS:
+        return "ModifyClass";
+    case Pegasus::CIMOPTYPE_MODIFY_INSTANCE:
+        return "ModifyInstance";
+    case Pegasus::CIMOPTYPE_ENUMERATE_CLASSES:
+        return "EnumerateClasses";
+    case Pegasus::CIMOPTYPE_ENUMERATE_CLASS_NAMES:
+        return "EnumerateClassNames";
+    case Pegasus::CIMOPTYPE_ENUMERATE_INSTANCES:
+        return "EnumerateInstances";
+    case Pegasus::CIMOPTYPE_ENUMERATE_INSTANCE_NAMES:
+        return "EnumerateInstanceNames";
+    case Pegasus::CIMOPTYPE_EXEC_QUERY:
+        return "ExecQuery";
+    case Pegasus::CIMOPTYPE_ASSOCIATORS:
+        return "Associators";
+    case Pegasus::CIMOPTYPE_ASSOCIATOR_NAMES:
+        return "AssociatorNames";
+    case Pegasus::CIMOPTYPE_REFERENCES:
+        return "References";
+    case Pegasus::CIMOPTYPE_REFERENCE_NAMES:
+        return "ReferenceNames";
+    case Pegasus::CIMOPTYPE_GET_PROPERTY:
+        return "GetProperty";
+    case Pegasus::CIMOPTYPE_SET_PROPERTY:
+        return "SetProperty";
+    case Pegasus::CIMOPTYPE_GET_QUALIFIER:
+        return "GetQualifier";
+    case Pegasus::CIMOPTYPE_SET_QUALIFIER:
+        return "SetQualifier";
+    case Pegasus::CIMOPTYPE_DELETE_QUALIFIER:
+        return "DeleteQualifier";
+    case Pegasus::CIMOPTYPE_ENUMERATE_QUALIFIERS:
+        return "EnumerateQualifiers";
+    default:
+        break;
+    }
+
+    // Pull operations and operations of newer Pegasus versions.
+    std::stringstream ss;
+    ss << "Operation" << static_cast<int>(type);
+    return ss.str();
+}
+
+void ClientPerformanceData::callCallback(
+    const bp::object &callback,
+    const CallbackItem &item)
+{
+    try {
+        bp::dict py_item;
+        py_item["operation"] = StringConv::asPyUnicode(item.operation);
+        py_item["classname"] = StringConv::asPyUnicode(item.classname);
+        py_item["round_trip_time"] = item.round_trip_time;
+        py_item["server_time"] = item.server_time_known ?
+            bp::object(item.server_time) : None;
+        py_item["request_size"] = item.request_size;
+        py_item["response_size"] = item.response_size;
+        callback(py_item);
+    } catch (const bp::error_already_set &) {
+        // Exceptions must not propagate out of the finished operation.
+        PyErr_Print();
+        PyErr_Clear();
+    }
+}
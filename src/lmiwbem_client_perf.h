@@ -0,0 +1,126 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_CLIENT_PERF_H
+#  define LMIWBEM_CLIENT_PERF_H
+
+#  include <map>
+#  include <utility>
+#  include <vector>
+#  include <boost/python/object.hpp>
+#  include <Pegasus/Client/ClientOpPerformanceDataHandler.h>
+#  include <Pegasus/Common/CIMOperationType.h>
+#  include "lmiwbem.h"
+#  include "lmiwbem_mutex.h"
+#  include "util/lmiwbem_string.h"
+
+namespace bp = boost::python;
+
+// Collects performance data reported by Pegasus client after each
+// operation: round trip time, server time and request/response sizes.
+// Statistics are kept per operation type and class name. Owned by
+// WBEMConnection, as it holds Python callback.
+class ClientPerformanceData: public Pegasus::ClientOpPerformanceDataHandler
+{
+public:
+    struct Stats
+    {
+        Stats();
+
+        Pegasus::Uint64 count;
+        Pegasus::Uint64 round_trip_time;
+        Pegasus::Uint64 round_trip_time_min;
+        Pegasus::Uint64 round_trip_time_max;
+        // Not every CIMOM reports server time.
+        Pegasus::Uint64 server_time_count;
+        Pegasus::Uint64 server_time;
+        Pegasus::Uint64 server_time_max;
+        Pegasus::Uint64 request_size;
+        Pegasus::Uint64 response_size;
+    };
+
+    // Calls the queued Python callbacks on destruction. Must outlive client
+    // transaction, so the callback doesn't run with the transaction mutex
+    // held.
+    class ScopedCallbacks
+    {
+    public:
+        ScopedCallbacks(ClientPerformanceData &perf_data);
+        ~ScopedCallbacks();
+
+    private:
+        ClientPerformanceData &m_perf_data;
+    };
+
+    // Operation name and class name
+    typedef std::pair<String, String> key_t;
+    typedef std::map<key_t, Stats> stats_map_t;
+
+    ClientPerformanceData();
+
+    virtual void handleClientOpPerformanceData(
+        const Pegasus::ClientOpPerformanceData &item);
+
+    // Class name of the running operation; set within a client transaction.
+    void setClassname(const String &classname);
+    String getClassname();
+
+    // Total size of responses received so far; not affected by reset().
+    Pegasus::Uint64 getResponseSize();
+
+    // Python callable called with a dictionary for every operation. Empty
+    // object disables the callback. Data reported by Pegasus are queued and
+    // passed to the callback by flushCallbacks().
+    void setCallback(const bp::object &callback);
+    bp::object getCallback();
+    void flushCallbacks();
+
+    stats_map_t getStats();
+    void reset();
+
+    static String operationName(Pegasus::CIMOperationType type);
+
+private:
+    struct CallbackItem
+    {
+        String operation;
+        String classname;
+        Pegasus::Uint64 round_trip_time;
+        bool server_time_known;
+        Pegasus::Uint64 server_time;
+        Pegasus::Uint64 request_size;
+        Pegasus::Uint64 response_size;
+    };
+
+    void callCallback(
+        const bp::object &callback,
+        const CallbackItem &item);
+
+    Mutex m_mutex;
+    String m_classname;
+    Pegasus::Uint64 m_response_size;
+    stats_map_t m_stats;
+    bp::object m_callback;
+    bool m_has_callback;
+    std::vector<CallbackItem> m_pending;
+};
+
+#endif // LMIWBEM_CLIENT_PERF_H
@@ -20,6 +20,9 @@
  * ***** END LICENSE BLOCK ***** */
 
 #include <config.h>
+#include <exception>
+#include <boost/python/errors.hpp>
+#include <boost/python/handle.hpp>
 #include <boost/python/object.hpp>
 #include <boost/python/str.hpp>
 #include <boost/python/tuple.hpp>
@@ -113,6 +116,11 @@ void throw_KeyError(const String &message)
     throw_core(PyExc_KeyError, message);
 }
 
+void throw_IndexError(const String &message)
+{
+    throw_core(PyExc_IndexError, message);
+}
+
 void throw_MemoryError(const String &message)
 {
     throw_core(PyExc_MemoryError, message);
@@ -195,3 +203,115 @@ void handle_all_exceptions(std::stringstream &prefix)
         throw_Exception(prefix.str());
     }
 }
+
+bp::object exception_as_object(std::stringstream &prefix)
+{
+    try {
+        handle_all_exceptions(prefix);
+    } catch (const bp::error_already_set &) {
+    }
+
+    PyObject *type;
+    PyObject *value;
+    PyObject *traceback;
+    PyErr_Fetch(&type, &value, &traceback);
+    PyErr_NormalizeException(&type, &value, &traceback);
+
+    Py_XDECREF(type);
+    Py_XDECREF(traceback);
+    if (!value)
+        return bp::object();
+
+    return bp::object(bp::handle<>(value));
+}
+
+CapturedException::CapturedException()
+    : m_type(EXC_NONE)
+    , m_code(0)
+    , m_message()
+{
+}
+
+void CapturedException::capture()
+{
+    // Keep the mapping in sync with handle_all_exceptions().
+    try {
+        throw;
+    } catch (const Pegasus::AlreadyConnectedException &e) {
+        m_type = EXC_CONNECTION_ERROR;
+        m_code = CIMConstants::CON_ERR_ALREADY_CONNECTED;
+        m_message = e.getMessage();
+    } catch (const Pegasus::NotConnectedException &e) {
+        m_type = EXC_CONNECTION_ERROR;
+        m_code = CIMConstants::CON_ERR_NOT_CONNECTED;
+        m_message = e.getMessage();
+    } catch (const Pegasus::InvalidLocatorException &e) {
+        m_type = EXC_CONNECTION_ERROR;
+        m_code = CIMConstants::CON_ERR_INVALID_LOCATOR;
+        m_message = e.getMessage();
+    } catch (const Pegasus::CannotCreateSocketException &e) {
+        m_type = EXC_CONNECTION_ERROR;
+        m_code = CIMConstants::CON_ERR_CANNOT_CREATE_SOCKET;
+        m_message = e.getMessage();
+    } catch (const Pegasus::CannotConnectException &e) {
+        m_type = EXC_CONNECTION_ERROR;
+        m_code = CIMConstants::CON_ERR_CANNOT_CONNECT;
+        m_message = e.getMessage();
+    } catch (const Pegasus::ConnectionTimeoutException &e) {
+        m_type = EXC_CONNECTION_ERROR;
+        m_code = CIMConstants::CON_ERR_CONNECTION_TIMEOUT;
+        m_message = e.getMessage();
+    } catch (const Pegasus::CIMClientHTTPErrorException &e) {
+        m_type = EXC_CONNECTION_ERROR;
+        m_code = static_cast<int>(e.getCode());
+        m_message = e.getMessage();
+    } catch (const Pegasus::CIMException &e) {
+        m_type = EXC_CIM_ERROR;
+        m_code = static_cast<int>(e.getCode());
+        m_message = e.getMessage();
+    } catch (const Pegasus::BindFailedException &e) {
+        m_type = EXC_CONNECTION_ERROR;
+        m_code = CIMConstants::CON_ERR_BIND;
+        m_message = e.getMessage();
+    } catch (const Pegasus::Exception &e) {
+        m_type = EXC_PEGASUS;
+        m_message = e.getMessage();
+    } catch (const std::exception &e) {
+        m_type = EXC_RUNTIME_ERROR;
+        m_message = e.what();
+    } catch (...) {
+        m_type = EXC_RUNTIME_ERROR;
+        m_message = "Unknown error";
+    }
+}
+
+bool CapturedException::isSet() const
+{
+    return m_type != EXC_NONE;
+}
+
+bp::object CapturedException::asPyObject() const
+{
+    switch (m_type) {
+    case EXC_CIM_ERROR:
+        return CIMErrorExc(m_code, bp::str(m_message));
+    case EXC_CONNECTION_ERROR:
+        return ConnectionErrorExc(m_code, bp::str(m_message));
+    case EXC_PEGASUS:
+        return CIMErrorExc(bp::str(String("Pegasus: ") + m_message));
+    case EXC_RUNTIME_ERROR:
+        return bp::object(bp::handle<>(bp::borrowed(PyExc_RuntimeError)))(
+            bp::str(m_message));
+    default:
+        return bp::object();
+    }
+}
+
+void CapturedException::raise() const
+{
+    bp::object exc(asPyObject());
+    PyErr_SetObject(
+        reinterpret_cast<PyObject*>(Py_TYPE(exc.ptr())),
+        exc.ptr());
+    bp::throw_error_already_set();
+}
@@ -23,6 +23,7 @@
 #  define LMIWBEM_EXCEPTION_H
 
 #  include <sstream>
+#  include <boost/python/object_fwd.hpp>
 #  include "lmiwbem.h"
 #  include "lmiwbem_traits.h"
 #  include "util/lmiwbem_string.h"
@@ -43,6 +44,7 @@ void throw_SLPError(const String &message, int code = 0);
 
 void throw_ValueError(const String &message);
 void throw_KeyError(const String &message);
+void throw_IndexError(const String &message);
 void throw_MemoryError(const String &message);
 void throw_StopIteration(const String &message);
 void throw_TypeError(const String &message);
@@ -61,4 +63,40 @@ void throw_TypeError_member(const String &member)
 void handle_all_exceptions(const String &prefix = String());
 void handle_all_exceptions(std::stringstream &prefix);
 
+// Same as handle_all_exceptions(), but the Python exception is returned
+// instead of being raised. Used, where errors of individual items of a bulk
+// operation are reported as values.
+bp::object exception_as_object(std::stringstream &prefix);
+
+// Exception caught in a thread running without the GIL. It is captured
+// natively and converted to a Python exception object later, when the GIL
+// is held.
+class CapturedException
+{
+public:
+    CapturedException();
+
+    // Captures currently handled exception; call from a catch block.
+    void capture();
+
+    bool isSet() const;
+    bp::object asPyObject() const;
+
+    // Raises the captured exception in Python; needs the GIL.
+    void raise() const;
+
+private:
+    enum Type {
+        EXC_NONE,
+        EXC_CIM_ERROR,
+        EXC_CONNECTION_ERROR,
+        EXC_PEGASUS,
+        EXC_RUNTIME_ERROR
+    };
+
+    Type m_type;
+    int m_code;
+    String m_message;
+};
+
 #endif // LMIWBEM_EXCEPTION_H
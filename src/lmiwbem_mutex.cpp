@@ -19,6 +19,8 @@
  *
  * ***** END LICENSE BLOCK ***** */
 
+#include <cerrno>
+#include <sys/time.h>
 #include "lmiwbem_mutex.h"
 
 Mutex::Mutex()
@@ -62,6 +64,60 @@ bool Mutex::isLocked() const
     return m_locked;
 }
 
+Condition::Condition()
+    : m_good(false)
+{
+    m_good = pthread_cond_init(&m_cond, NULL) == 0;
+}
+
+Condition::~Condition()
+{
+    pthread_cond_destroy(&m_cond);
+}
+
+bool Condition::wait(Mutex &m)
+{
+    if (!m_good || !m.m_good)
+        return false;
+
+    return pthread_cond_wait(&m_cond, &m.m_mutex) == 0;
+}
+
+bool Condition::timedWait(Mutex &m, unsigned int timeout)
+{
+    if (!m_good || !m.m_good)
+        return false;
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    struct timespec deadline;
+    deadline.tv_sec = now.tv_sec + timeout / 1000;
+    deadline.tv_nsec = now.tv_usec * 1000 + (timeout % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    return pthread_cond_timedwait(&m_cond, &m.m_mutex, &deadline) != ETIMEDOUT;
+}
+
+bool Condition::signal()
+{
+    if (!m_good)
+        return false;
+
+    return pthread_cond_signal(&m_cond) == 0;
+}
+
+bool Condition::broadcast()
+{
+    if (!m_good)
+        return false;
+
+    return pthread_cond_broadcast(&m_cond) == 0;
+}
+
 ScopedMutex::ScopedMutex(Mutex &m)
     : m_mutex(m)
 {
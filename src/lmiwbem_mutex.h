@@ -37,11 +37,32 @@ public:
     bool isLocked() const;
 
 private:
+    friend class Condition;
+
     bool m_good;
     bool m_locked;
     pthread_mutex_t m_mutex;
 };
 
+class Condition
+{
+public:
+    Condition();
+    ~Condition();
+
+    // Mutex needs to be locked by the caller.
+    bool wait(Mutex &m);
+    // Returns false, if the timeout (in milliseconds) expired.
+    bool timedWait(Mutex &m, unsigned int timeout);
+
+    bool signal();
+    bool broadcast();
+
+private:
+    bool m_good;
+    pthread_cond_t m_cond;
+};
+
 class ScopedMutex
 {
 public:
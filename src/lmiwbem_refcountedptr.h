@@ -100,9 +100,9 @@ public:
         m_value->set(new T(value));
     }
 
-    T *get() { return m_value->get(); }
+    T *get() const { return m_value->get(); }
 
-    bool empty() { return m_value == NULL || m_value->get() == NULL; }
+    bool empty() const { return m_value == NULL || m_value->get() == NULL; }
 
     void release()
     {
@@ -0,0 +1,33 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+
+#include <config.h>
+#include "lmiwbem_trace.h"
+
+#ifdef HAVE_USDT
+// Tracers look up the semaphores in .probes section.
+#  define LMIWBEM_TRACE_DEFINE_SEMAPHORE(name) \
+       unsigned short LMIWBEM_TRACE_SEMAPHORE(name) \
+           __attribute__((section(".probes"))) = 0;
+
+LMIWBEM_TRACE_PROBES(LMIWBEM_TRACE_DEFINE_SEMAPHORE)
+#endif // HAVE_USDT
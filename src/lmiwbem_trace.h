@@ -0,0 +1,111 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_TRACE_H
+#  define LMIWBEM_TRACE_H
+
+/* Static USDT probes of provider "lmiwbem", usable by SystemTap, bpftrace
+ * and similar tools. Probes are compiled in only, if configured with
+ * --with-usdt; otherwise, the macros expand to nothing and their arguments
+ * are not evaluated. Probe arguments need to be integers or pointers.
+ *
+ * Every probe has a semaphore, which is incremented by an attached tracer.
+ * Probe arguments are evaluated only while the semaphore is set, so the
+ * probes cost a single memory read, when nobody is tracing. Use
+ * LMIWBEM_TRACE_ENABLED() to guard any other work needed just by a probe.
+ *
+ * Probes:
+ *   operation_begin(char *operation)
+ *   operation_end(char *operation, char *classname)
+ *   client_perf(char *operation, char *classname, uint64 round_trip_us,
+ *               uint64 request_size, uint64 response_size)
+ *   connect(char *hostname, uint32 port)
+ *   disconnect(char *hostname)
+ *   instance_create(char *classname, uint32 properties, uint32 qualifiers)
+ *   instance_eval_begin(char *classname, size_t properties)
+ *   instance_eval_end(char *classname, size_t properties)
+ *   indication_consume(char *listener, char *classname, uint32 properties)
+ *
+ * New probes need to be added to LMIWBEM_TRACE_PROBES, too.
+ */
+
+#  ifdef HAVE_USDT
+#    define _SDT_HAS_SEMAPHORES 1
+#    include <sys/sdt.h>
+
+#    define LMIWBEM_TRACE_PROBES(X) \
+         X(operation_begin)         \
+         X(operation_end)           \
+         X(client_perf)             \
+         X(connect)                 \
+         X(disconnect)              \
+         X(instance_create)         \
+         X(instance_eval_begin)     \
+         X(instance_eval_end)       \
+         X(indication_consume)
+
+// Semaphores are defined in lmiwbem_trace.cpp; sys/sdt.h refers to them by
+// their unmangled names.
+#    define LMIWBEM_TRACE_SEMAPHORE(name) lmiwbem_##name##_semaphore
+#    define LMIWBEM_TRACE_DECLARE_SEMAPHORE(name) \
+         extern unsigned short LMIWBEM_TRACE_SEMAPHORE(name);
+
+extern "C" {
+LMIWBEM_TRACE_PROBES(LMIWBEM_TRACE_DECLARE_SEMAPHORE)
+}
+
+#    define LMIWBEM_TRACE_ENABLED(name) \
+         __builtin_expect(LMIWBEM_TRACE_SEMAPHORE(name) != 0, 0)
+#    define LMIWBEM_TRACE0(name) do { \
+         if (LMIWBEM_TRACE_ENABLED(name)) \
+             DTRACE_PROBE(lmiwbem, name); \
+     } while (0)
+#    define LMIWBEM_TRACE1(name, a1) do { \
+         if (LMIWBEM_TRACE_ENABLED(name)) \
+             DTRACE_PROBE1(lmiwbem, name, a1); \
+     } while (0)
+#    define LMIWBEM_TRACE2(name, a1, a2) do { \
+         if (LMIWBEM_TRACE_ENABLED(name)) \
+             DTRACE_PROBE2(lmiwbem, name, a1, a2); \
+     } while (0)
+#    define LMIWBEM_TRACE3(name, a1, a2, a3) do { \
+         if (LMIWBEM_TRACE_ENABLED(name)) \
+             DTRACE_PROBE3(lmiwbem, name, a1, a2, a3); \
+     } while (0)
+#    define LMIWBEM_TRACE4(name, a1, a2, a3, a4) do { \
+         if (LMIWBEM_TRACE_ENABLED(name)) \
+             DTRACE_PROBE4(lmiwbem, name, a1, a2, a3, a4); \
+     } while (0)
+#    define LMIWBEM_TRACE5(name, a1, a2, a3, a4, a5) do { \
+         if (LMIWBEM_TRACE_ENABLED(name)) \
+             DTRACE_PROBE5(lmiwbem, name, a1, a2, a3, a4, a5); \
+     } while (0)
+#  else
+#    define LMIWBEM_TRACE_ENABLED(name) 0
+#    define LMIWBEM_TRACE0(name) do { } while (0)
+#    define LMIWBEM_TRACE1(name, a1) do { } while (0)
+#    define LMIWBEM_TRACE2(name, a1, a2) do { } while (0)
+#    define LMIWBEM_TRACE3(name, a1, a2, a3) do { } while (0)
+#    define LMIWBEM_TRACE4(name, a1, a2, a3, a4) do { } while (0)
+#    define LMIWBEM_TRACE5(name, a1, a2, a3, a4, a5) do { } while (0)
+#  endif // HAVE_USDT
+
+#endif // LMIWBEM_TRACE_H
@@ -58,6 +58,7 @@ struct type_name
 
 DEF_TYPE_NAME(bool);
 DEF_TYPE_NAME(int);
+DEF_TYPE_NAME_TYPE(double, float);
 DEF_TYPE_NAME(CIMInstance);
 DEF_TYPE_NAME(CIMInstanceName);
 DEF_TYPE_NAME(CIMEnumerationContext);
@@ -20,18 +20,23 @@
  * ***** END LICENSE BLOCK ***** */
 
 #include <config.h>
+#include <sstream>
 #include <boost/python/class.hpp>
 #include <boost/python/dict.hpp>
+#include <boost/python/tuple.hpp>
 #include <Pegasus/Common/CIMClass.h>
 #include <Pegasus/Common/CIMProperty.h>
 #include <Pegasus/Common/CIMQualifier.h>
 #include <Pegasus/Common/CIMMethod.h>
+#include "lmiwbem_config.h"
+#include "lmiwbem_exception.h"
 #include "obj/lmiwbem_nocasedict.h"
 #include "obj/cim/lmiwbem_class.h"
 #include "obj/cim/lmiwbem_method.h"
 #include "obj/cim/lmiwbem_property.h"
 #include "obj/cim/lmiwbem_qualifier.h"
 #include "util/lmiwbem_convert.h"
+#include "util/lmiwbem_pickle.h"
 #include "util/lmiwbem_util.h"
 
 CIMClass::CIMClass()
@@ -97,6 +102,24 @@ void CIMClass::init_type()
             "copy()\n\n"
             ":returns: copy of the object itself\n"
             ":rtype: :py:class:`.CIMClass`")
+        .def("__reduce__", &CIMClass::reduce,
+            "__reduce__()\n\n"
+            ":returns: tuple used by :py:mod:`pickle` to serialize the object\n"
+            ":rtype: tuple")
+        .def("__getstate__", &CIMClass::getstate,
+            "__getstate__()\n\n"
+            ":returns: state of the object for :py:mod:`pickle`; unevaluated\n"
+            "\tmembers are encoded without creating Python objects\n"
+            ":rtype: tuple")
+        .def("__setstate__", &CIMClass::setstate,
+            "__setstate__(state)\n\n"
+            "Restores the object from state returned by :py:meth:`__getstate__`.\n\n"
+            ":param tuple state: state of the object")
+        .def("__sizeof__", &Census<CIMClass>::sizeOf,
+            "__sizeof__()\n\n"
+            ":returns: size of the object in bytes including native data and\n"
+            "\tunevaluated CIMOM data, but not referenced Python objects\n"
+            ":rtype: int")
         .add_property("classname",
             &CIMClass::getPyClassname,
             &CIMClass::setPyClassname,
@@ -128,29 +151,33 @@ bp::object CIMClass::create(const Pegasus::CIMClass &cls)
 {
     bp::object inst = CIMBase<CIMClass>::create();
     CIMClass &fake_this = CIMClass::asNative(inst);
+    fake_this.setPegasusCIMClass(cls);
 
+    return inst;
+}
+
+void CIMClass::setPegasusCIMClass(const Pegasus::CIMClass &cls)
+{
     // Store list of properties for lazy evaluation
-    fake_this.m_rc_class_properties.set(std::list<Pegasus::CIMConstProperty>());
+    m_rc_class_properties.set(std::list<Pegasus::CIMConstProperty>());
     Pegasus::Uint32 cnt = cls.getPropertyCount();
     for (Pegasus::Uint32 i = 0; i < cnt; ++i)
-        fake_this.m_rc_class_properties.get()->push_back(cls.getProperty(i));
+        m_rc_class_properties.get()->push_back(cls.getProperty(i));
 
     // Store list of qualifiersr for lazy evaluation
-    fake_this.m_rc_class_qualifiers.set(std::list<Pegasus::CIMConstQualifier>());
+    m_rc_class_qualifiers.set(std::list<Pegasus::CIMConstQualifier>());
     cnt = cls.getQualifierCount();
     for (Pegasus::Uint32 i = 0; i < cnt; ++i)
-        fake_this.m_rc_class_qualifiers.get()->push_back(cls.getQualifier(i));
+        m_rc_class_qualifiers.get()->push_back(cls.getQualifier(i));
 
     // Store list of methods for lazy evaluation
-    fake_this.m_rc_class_methods.set(std::list<Pegasus::CIMConstMethod>());
+    m_rc_class_methods.set(std::list<Pegasus::CIMConstMethod>());
     cnt = cls.getMethodCount();
     for (Pegasus::Uint32 i = 0; i < cnt; ++i)
-        fake_this.m_rc_class_methods.get()->push_back(cls.getMethod(i));
-
-    fake_this.m_classname = cls.getClassName().getString();
-    fake_this.m_super_classname = cls.getSuperClassName().getString();
+        m_rc_class_methods.get()->push_back(cls.getMethod(i));
 
-    return inst;
+    m_classname = cls.getClassName().getString();
+    m_super_classname = cls.getSuperClassName().getString();
 }
 
 bp::object CIMClass::create(const Pegasus::CIMObject &object)
@@ -289,6 +316,96 @@ bp::object CIMClass::copy()
     return py_inst;
 }
 
+bp::object CIMClass::reduce()
+{
+    return bp::make_tuple(CIMClass::type(), bp::tuple(), getstate());
+}
+
+bp::object CIMClass::getstate()
+{
+    return bp::make_tuple(PickleConv::asPyBytes(snapshotPegasusCIMClass()));
+}
+
+void CIMClass::setstate(const bp::object &state) try
+{
+    const bp::tuple py_state(PickleConv::asState(state, "CIMClass", 1));
+    setPegasusCIMClass(PickleConv::asPegasusCIMClass(py_state[0]));
+} catch (...) {
+    std::stringstream ss;
+    if (Config::isVerbose())
+        ss << "CIMClass.__setstate__()";
+    handle_all_exceptions(ss);
+}
+
+Pegasus::CIMClass CIMClass::snapshotPegasusCIMClass() const
+{
+    // Unlike asPegasusCIMClass(), unevaluated properties, qualifiers and
+    // methods are used as they are, without creating Python objects.
+    Pegasus::CIMClass peg_class(
+        (Pegasus::CIMName(m_classname)),
+        m_super_classname.empty() ?
+            Pegasus::CIMName() : Pegasus::CIMName(m_super_classname));
+
+    if (!m_rc_class_properties.empty()) {
+        const std::list<Pegasus::CIMConstProperty> &properties =
+            *m_rc_class_properties.get();
+        std::list<Pegasus::CIMConstProperty>::const_iterator it;
+        for (it = properties.begin(); it != properties.end(); ++it)
+            peg_class.addProperty(it->clone());
+    } else if (!isnone(m_properties)) {
+        const NocaseDict &cim_properties = NocaseDict::asNative(m_properties);
+        nocase_map_t::const_iterator it;
+        for (it = cim_properties.begin(); it != cim_properties.end(); ++it) {
+            CIMProperty &property = CIMProperty::asNative(it->second);
+            peg_class.addProperty(property.asPegasusCIMProperty());
+        }
+    }
+
+    if (!m_rc_class_qualifiers.empty()) {
+        const std::list<Pegasus::CIMConstQualifier> &qualifiers =
+            *m_rc_class_qualifiers.get();
+        std::list<Pegasus::CIMConstQualifier>::const_iterator it;
+        for (it = qualifiers.begin(); it != qualifiers.end(); ++it)
+            peg_class.addQualifier(it->clone());
+    } else if (!isnone(m_qualifiers)) {
+        const NocaseDict &cim_qualifiers = NocaseDict::asNative(m_qualifiers);
+        nocase_map_t::const_iterator it;
+        for (it = cim_qualifiers.begin(); it != cim_qualifiers.end(); ++it) {
+            CIMQualifier &qualifier = CIMQualifier::asNative(it->second);
+            peg_class.addQualifier(qualifier.asPegasusCIMQualifier());
+        }
+    }
+
+    if (!m_rc_class_methods.empty()) {
+        const std::list<Pegasus::CIMConstMethod> &methods =
+            *m_rc_class_methods.get();
+        std::list<Pegasus::CIMConstMethod>::const_iterator it;
+        for (it = methods.begin(); it != methods.end(); ++it)
+            peg_class.addMethod(it->clone());
+    } else if (!isnone(m_methods)) {
+        const NocaseDict &cim_methods = NocaseDict::asNative(m_methods);
+        nocase_map_t::const_iterator it;
+        for (it = cim_methods.begin(); it != cim_methods.end(); ++it) {
+            CIMMethod &method = CIMMethod::asNative(it->second);
+            peg_class.addMethod(method.asPegasusCIMMethod());
+        }
+    }
+
+    return peg_class;
+}
+
+std::size_t CIMClass::heapSize() const
+{
+    return MemSize::of(m_classname) + MemSize::of(m_super_classname);
+}
+
+std::size_t CIMClass::lazySize() const
+{
+    return MemSize::of(m_rc_class_properties) +
+        MemSize::of(m_rc_class_qualifiers) +
+        MemSize::of(m_rc_class_methods);
+}
+
 String CIMClass::getClassname() const
 {
     return m_classname;
@@ -27,6 +27,7 @@
 #  include "lmiwbem.h"
 #  include "lmiwbem_refcountedptr.h"
 #  include "obj/lmiwbem_cimbase.h"
+#  include "util/lmiwbem_census.h"
 #  include "util/lmiwbem_string.h"
 
 PEGASUS_BEGIN
@@ -38,7 +39,9 @@ PEGASUS_END
 
 namespace bp = boost::python;
 
-class CIMClass: public CIMBase<CIMClass>
+class CIMClass:
+    public CIMBase<CIMClass>,
+    public Census<CIMClass>
 {
 public:
     CIMClass();
@@ -69,6 +72,15 @@ public:
 
     bp::object copy();
 
+    bp::object reduce();
+    bp::object getstate();
+    void setstate(const bp::object &state);
+
+    // Memory owned by native members and by unevaluated Pegasus objects;
+    // see Census.
+    std::size_t heapSize() const;
+    std::size_t lazySize() const;
+
     String getClassname() const;
     String getSuperClassname() const;
     bp::object getPyClassname() const;
@@ -86,6 +98,9 @@ public:
     void setPyMethods(const bp::object &methods);
 
 private:
+    void setPegasusCIMClass(const Pegasus::CIMClass &cls);
+    Pegasus::CIMClass snapshotPegasusCIMClass() const;
+
     String m_classname;
     String m_super_classname;
     bp::object m_properties;
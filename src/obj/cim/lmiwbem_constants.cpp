@@ -91,4 +91,15 @@ void CIMConstants::init_type()
     bp::scope().attr("SLP_ERR_RETRY_UNICAST") = SLP_ERR_RETRY_UNICAST;
 #  endif // UNICAST_NOT_SUPPORTED
 #endif // HAVE_SLP
+
+#ifdef HAVE_PEGASUS_LISTENER
+    // Listener indication queue overflow policies
+    bp::scope().attr("LISTENER_OVERFLOW_BLOCK") = LISTENER_OVERFLOW_BLOCK;
+    bp::scope().attr("LISTENER_OVERFLOW_DROP_OLDEST") = LISTENER_OVERFLOW_DROP_OLDEST;
+    bp::scope().attr("LISTENER_OVERFLOW_DROP_NEWEST") = LISTENER_OVERFLOW_DROP_NEWEST;
+
+    // Listener indication ordering
+    bp::scope().attr("LISTENER_ORDER_BY_NAME") = LISTENER_ORDER_BY_NAME;
+    bp::scope().attr("LISTENER_ORDER_BY_SOURCE") = LISTENER_ORDER_BY_SOURCE;
+#endif // HAVE_PEGASUS_LISTENER
 }
@@ -101,6 +101,21 @@ public:
 #    endif // UNICAST_NOT_SUPPORTED
 #  endif // HAVE_SLP
     };
+
+#  ifdef HAVE_PEGASUS_LISTENER
+    enum ListenerOverflowPolicy {
+        // Indication queue overflow policies
+          LISTENER_OVERFLOW_BLOCK                     = 0
+        , LISTENER_OVERFLOW_DROP_OLDEST               = 1
+        , LISTENER_OVERFLOW_DROP_NEWEST               = 2
+    };
+
+    enum ListenerOrdering {
+        // Indication delivery ordering of listener dispatcher threads
+          LISTENER_ORDER_BY_NAME                      = 0
+        , LISTENER_ORDER_BY_SOURCE                    = 1
+    };
+#  endif // HAVE_PEGASUS_LISTENER
 };
 
 #endif // LMIWBEM_CONSTANTS_H
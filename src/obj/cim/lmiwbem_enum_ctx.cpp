@@ -23,11 +23,13 @@
 #include <boost/python/class.hpp>
 #include <Pegasus/Client/CIMEnumerationContext.h>
 #include "obj/cim/lmiwbem_enum_ctx.h"
+#include "util/lmiwbem_wql.h"
 
 CIMEnumerationContext::CIMEnumerationContext()
     : m_enum_ctx_ptr()
     , m_is_with_paths(true)
     , m_namespace()
+    , m_client_query()
 {
 }
 
@@ -103,6 +105,17 @@ void CIMEnumerationContext::setIsWithPaths(const bool is_with_paths)
     m_is_with_paths = is_with_paths;
 }
 
+boost::shared_ptr<WQLQuery> CIMEnumerationContext::getClientQuery() const
+{
+    return m_client_query;
+}
+
+void CIMEnumerationContext::setClientQuery(
+    const boost::shared_ptr<WQLQuery> &query)
+{
+    m_client_query = query;
+}
+
 void CIMEnumerationContext::clear()
 {
     if (!m_enum_ctx_ptr)
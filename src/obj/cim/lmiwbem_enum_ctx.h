@@ -30,6 +30,8 @@
 
 namespace bp = boost::python;
 
+class WQLQuery;
+
 class CIMEnumerationContext: public CIMBase<CIMEnumerationContext>
 {
 public:
@@ -56,12 +58,17 @@ public:
     void setNamespace(const String &ns);
     void setIsWithPaths(const bool is_with_paths);
 
+    // Client-side query applied to each pulled chunk of instances.
+    boost::shared_ptr<WQLQuery> getClientQuery() const;
+    void setClientQuery(const boost::shared_ptr<WQLQuery> &query);
+
     void clear();
 
 private:
     boost::shared_ptr<Pegasus::CIMEnumerationContext> m_enum_ctx_ptr;
     bool m_is_with_paths;
     String m_namespace;
+    boost::shared_ptr<WQLQuery> m_client_query;
 };
 
 #endif // LMIWBEM_ENUM_CTX_H
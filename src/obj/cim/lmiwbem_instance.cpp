@@ -25,7 +25,11 @@
 #include <boost/python/dict.hpp>
 #include <boost/python/list.hpp>
 #include <boost/python/str.hpp>
+#include <boost/python/tuple.hpp>
 #include <Pegasus/Common/CIMInstance.h>
+#include "lmiwbem_config.h"
+#include "lmiwbem_exception.h"
+#include "lmiwbem_trace.h"
 #include "obj/cim/lmiwbem_instance.h"
 #include "obj/cim/lmiwbem_instance_name.h"
 #include "obj/lmiwbem_nocasedict.h"
@@ -33,6 +37,7 @@
 #include "obj/cim/lmiwbem_qualifier.h"
 #include "obj/cim/lmiwbem_value.h"
 #include "util/lmiwbem_convert.h"
+#include "util/lmiwbem_pickle.h"
 #include "util/lmiwbem_util.h"
 
 namespace bp = boost::python;
@@ -46,6 +51,8 @@ CIMInstance::CIMInstance()
     , m_rc_inst_path()
     , m_rc_inst_properties()
     , m_rc_inst_qualifiers()
+    , m_property_usage()
+    , m_is_partial(false)
 {
 }
 
@@ -55,6 +62,8 @@ CIMInstance::CIMInstance(
     const bp::object &qualifiers,
     const bp::object &path,
     const bp::object &property_list)
+    : m_property_usage()
+    , m_is_partial(false)
 {
     m_classname = StringConv::asString(classname, "classname");
 
@@ -154,6 +163,24 @@ void CIMInstance::init_type()
             "copy()\n\n"
             ":returns: copy of the object itself\n"
             ":rtype: :py:class:`.CIMInstance`")
+        .def("__reduce__", &CIMInstance::reduce,
+            "__reduce__()\n\n"
+            ":returns: tuple used by :py:mod:`pickle` to serialize the object\n"
+            ":rtype: tuple")
+        .def("__getstate__", &CIMInstance::getstate,
+            "__getstate__()\n\n"
+            ":returns: state of the object for :py:mod:`pickle`; unevaluated\n"
+            "\tproperties are encoded without creating Python objects\n"
+            ":rtype: tuple")
+        .def("__setstate__", &CIMInstance::setstate,
+            "__setstate__(state)\n\n"
+            "Restores the object from state returned by :py:meth:`__getstate__`.\n\n"
+            ":param tuple state: state of the object")
+        .def("__sizeof__", &Census<CIMInstance>::sizeOf,
+            "__sizeof__()\n\n"
+            ":returns: size of the object in bytes including native data and\n"
+            "\tunevaluated CIMOM data, but not referenced Python objects\n"
+            ":rtype: int")
         .def("tomof", &CIMInstance::tomof,
             "tomof()\n\n"
             ":returns: MOF representation of the object itself\n"
@@ -169,7 +196,7 @@ void CIMInstance::init_type()
             "Property storing object path\n\n"
             ":rtype: :py:class:`.CIMInstanceName`")
         .add_property("properties",
-            &CIMInstance::getPyProperties,
+            &CIMInstance::getPyPropertiesTracked,
             &CIMInstance::setPyProperties,
             "Property storing instance properties\n\n"
             ":rtype: :py:class:`.NocaseDict`")
@@ -194,24 +221,35 @@ bp::object CIMInstance::create(const Pegasus::CIMInstance &instance)
 
     bp::object py_inst = CIMBase<CIMInstance>::create();
     CIMInstance &fake_this = CIMInstance::asNative(py_inst);
-    fake_this.m_classname = instance.getClassName().getString();
+    fake_this.setPegasusCIMInstance(instance);
+
+    return py_inst;
+}
+
+void CIMInstance::setPegasusCIMInstance(const Pegasus::CIMInstance &instance)
+{
+    m_classname = instance.getClassName().getString();
+    m_path = bp::object();
 
     // Store path for lazy evaluation
-    fake_this.m_rc_inst_path.set(instance.getPath());
+    m_rc_inst_path.set(instance.getPath());
 
     // Store list of properties for lazy evaluation
-    fake_this.m_rc_inst_properties.set(std::list<Pegasus::CIMConstProperty>());
+    m_rc_inst_properties.set(std::list<Pegasus::CIMConstProperty>());
     Pegasus::Uint32 cnt = instance.getPropertyCount();
     for (Pegasus::Uint32 i = 0; i < cnt; ++i)
-        fake_this.m_rc_inst_properties.get()->push_back(instance.getProperty(i));
+        m_rc_inst_properties.get()->push_back(instance.getProperty(i));
 
     // Store list of qualifiers for lazy evaluation
-    fake_this.m_rc_inst_qualifiers.set(std::list<Pegasus::CIMConstQualifier>());
+    m_rc_inst_qualifiers.set(std::list<Pegasus::CIMConstQualifier>());
     cnt = instance.getQualifierCount();
     for (Pegasus::Uint32 i = 0; i < cnt; ++i)
-        fake_this.m_rc_inst_qualifiers.get()->push_back(instance.getQualifier(i));
+        m_rc_inst_qualifiers.get()->push_back(instance.getQualifier(i));
 
-    return py_inst;
+    LMIWBEM_TRACE3(instance_create,
+        m_classname.c_str(),
+        instance.getPropertyCount(),
+        cnt);
 }
 
 bp::object CIMInstance::create(const Pegasus::CIMObject &object)
@@ -328,7 +366,7 @@ bp::object CIMInstance::repr()
 
 bp::object CIMInstance::getitem(const bp::object &key)
 {
-    evalProperties();
+    accessProperty(key);
 
     bp::object py_item = m_properties[key];
     if (isinstance(py_item, CIMProperty::type())) {
@@ -366,22 +404,27 @@ void CIMInstance::setitem(const bp::object &key, const bp::object &value)
 
 bp::object CIMInstance::len()
 {
+    accessAllProperties();
     return bp::object(bp::len(getPyProperties()));
 }
 
 bp::object CIMInstance::haskey(const bp::object &key)
 {
+    // Membership test doesn't refetch; the property is requested next time.
+    recordPropertyAccess(key);
     return getPyProperties().contains(key);
 }
 
 bp::object CIMInstance::keys()
 {
+    accessAllProperties();
     NocaseDict &cim_properties = NocaseDict::asNative(getPyProperties());
     return cim_properties.keys();
 }
 
 bp::object CIMInstance::values()
 {
+    accessAllProperties();
     NocaseDict &cim_properties = NocaseDict::asNative(getPyProperties());
     nocase_map_t::const_iterator it;
 
@@ -401,6 +444,7 @@ bp::object CIMInstance::values()
 
 bp::object CIMInstance::items()
 {
+    accessAllProperties();
     NocaseDict &cim_properties = NocaseDict::asNative(getPyProperties());
     nocase_map_t::const_iterator it;
 
@@ -425,18 +469,21 @@ bp::object CIMInstance::items()
 
 bp::object CIMInstance::iterkeys()
 {
+    accessAllProperties();
     NocaseDict &cim_properties = NocaseDict::asNative(getPyProperties());
     return cim_properties.iterkeys();
 }
 
 bp::object CIMInstance::itervalues()
 {
+    accessAllProperties();
     NocaseDict &cim_properties = NocaseDict::asNative(getPyProperties());
     return cim_properties.itervalues();
 }
 
 bp::object CIMInstance::iteritems()
 {
+    accessAllProperties();
     NocaseDict &cim_properties = NocaseDict::asNative(getPyProperties());
     return cim_properties.iteritems();
 }
@@ -460,6 +507,108 @@ bp::object CIMInstance::copy()
     return py_inst;
 }
 
+bp::object CIMInstance::reduce()
+{
+    return bp::make_tuple(CIMInstance::type(), bp::tuple(), getstate());
+}
+
+bp::object CIMInstance::getstate()
+{
+    // Path is stored as a string; instance XML doesn't carry it.
+    bp::object py_path;
+    if (!m_rc_inst_path.empty()) {
+        if (!CIMInstanceName::isUninitialized(*m_rc_inst_path.get()))
+            py_path = StringConv::asPyUnicode(m_rc_inst_path.get()->toString());
+    } else if (!isnone(m_path)) {
+        const CIMInstanceName &path = CIMInstanceName::asNative(m_path);
+        py_path = StringConv::asPyUnicode(
+            path.asPegasusCIMObjectPath().toString());
+    }
+
+    // Property list is stored only for evaluated properties; unevaluated
+    // ones will compute it again.
+    const bool evaluated = m_rc_inst_properties.empty();
+    return bp::make_tuple(
+        PickleConv::asPyBytes(snapshotPegasusCIMInstance()),
+        py_path,
+        evaluated,
+        evaluated ? m_property_list : bp::object());
+}
+
+void CIMInstance::setstate(const bp::object &state) try
+{
+    const bp::tuple py_state(PickleConv::asState(state, "CIMInstance", 4));
+    Pegasus::CIMInstance peg_instance(
+        PickleConv::asPegasusCIMInstance(py_state[0]));
+    if (!isnone(py_state[1])) {
+        peg_instance.setPath(Pegasus::CIMObjectPath(
+            StringConv::asString(py_state[1], "path")));
+    }
+
+    setPegasusCIMInstance(peg_instance);
+
+    if (Conv::as<bool>(py_state[2], "evaluated")) {
+        evalProperties();
+        m_property_list = py_state[3];
+    }
+} catch (...) {
+    std::stringstream ss;
+    if (Config::isVerbose())
+        ss << "CIMInstance.__setstate__()";
+    handle_all_exceptions(ss);
+}
+
+Pegasus::CIMInstance CIMInstance::snapshotPegasusCIMInstance() const
+{
+    // Unlike asPegasusCIMInstance(), unevaluated properties and qualifiers
+    // are used as they are, without creating Python objects.
+    Pegasus::CIMInstance peg_instance((Pegasus::CIMName(m_classname)));
+
+    if (!m_rc_inst_properties.empty()) {
+        const std::list<Pegasus::CIMConstProperty> &properties =
+            *m_rc_inst_properties.get();
+        std::list<Pegasus::CIMConstProperty>::const_iterator it;
+        for (it = properties.begin(); it != properties.end(); ++it)
+            peg_instance.addProperty(it->clone());
+    } else if (!isnone(m_properties)) {
+        const NocaseDict &cim_properties = NocaseDict::asNative(m_properties);
+        nocase_map_t::const_iterator it;
+        for (it = cim_properties.begin(); it != cim_properties.end(); ++it) {
+            CIMProperty &cim_property = CIMProperty::asNative(it->second);
+            peg_instance.addProperty(cim_property.asPegasusCIMProperty());
+        }
+    }
+
+    if (!m_rc_inst_qualifiers.empty()) {
+        const std::list<Pegasus::CIMConstQualifier> &qualifiers =
+            *m_rc_inst_qualifiers.get();
+        std::list<Pegasus::CIMConstQualifier>::const_iterator it;
+        for (it = qualifiers.begin(); it != qualifiers.end(); ++it)
+            peg_instance.addQualifier(it->clone());
+    } else if (!isnone(m_qualifiers)) {
+        const NocaseDict &cim_qualifiers = NocaseDict::asNative(m_qualifiers);
+        nocase_map_t::const_iterator it;
+        for (it = cim_qualifiers.begin(); it != cim_qualifiers.end(); ++it) {
+            CIMQualifier &cim_qualifier = CIMQualifier::asNative(it->second);
+            peg_instance.addQualifier(cim_qualifier.asPegasusCIMQualifier());
+        }
+    }
+
+    return peg_instance;
+}
+
+std::size_t CIMInstance::heapSize() const
+{
+    return MemSize::of(m_classname);
+}
+
+std::size_t CIMInstance::lazySize() const
+{
+    return MemSize::of(m_rc_inst_path) +
+        MemSize::of(m_rc_inst_properties) +
+        MemSize::of(m_rc_inst_qualifiers);
+}
+
 String CIMInstance::tomofContent(const bp::object &value)
 {
     std::stringstream ss;
@@ -486,6 +635,8 @@ String CIMInstance::tomofContent(const bp::object &value)
 
 bp::object CIMInstance::tomof()
 {
+    accessAllProperties();
+
     std::stringstream ss;
     ss << "instance of " << m_classname << " {\n";
 
@@ -540,6 +691,12 @@ bp::object CIMInstance::getPyProperties()
     return m_properties;
 }
 
+bp::object CIMInstance::getPyPropertiesTracked()
+{
+    accessAllProperties();
+    return getPyProperties();
+}
+
 bp::object CIMInstance::getPyQualifiers()
 {
     if (!m_rc_inst_qualifiers.empty()) {
@@ -611,36 +768,107 @@ void CIMInstance::evalProperties()
     if (m_rc_inst_properties.empty())
         return;
 
+    std::list<Pegasus::CIMConstProperty> &properties = *m_rc_inst_properties.get();
+    LMIWBEM_TRACE2(instance_eval_begin, m_classname.c_str(), properties.size());
+
     m_properties = NocaseDict::create();
     bp::list py_property_list;
     std::list<Pegasus::CIMConstProperty>::const_iterator it;
-    std::list<Pegasus::CIMConstProperty> &properties = *m_rc_inst_properties.get();
     for (it = properties.begin(); it != properties.end(); ++it) {
         bp::object py_prop_name(it->getName());
-        if (it->getValue().getType() == Pegasus::CIMTYPE_REFERENCE) {
-            // We got a property with CIMObjectPath value. Let's set its
-            // hostname which could be left out by Pegasus.
-            // FIXME: refactor using getHostname()
-            const CIMInstanceName &this_iname = getPath();
-            Pegasus::CIMProperty peg_property = it->clone();
-            Pegasus::CIMValue peg_value = peg_property.getValue();
-            Pegasus::CIMObjectPath peg_iname;
-            peg_value.get(peg_iname);
-            peg_iname.setHost(this_iname.getHostname());
-            peg_value.set(peg_iname);
-            peg_property.setValue(peg_value);
-
-            m_properties[py_prop_name] = CIMProperty::create(peg_property);
-        } else {
-            m_properties[py_prop_name] = CIMProperty::create(*it);
-        }
+        m_properties[py_prop_name] = createProperty(*it);
         py_property_list.append(py_prop_name);
     }
 
     m_property_list = py_property_list;
+
+    LMIWBEM_TRACE2(instance_eval_end, m_classname.c_str(), properties.size());
     m_rc_inst_properties.release();
 }
 
+bp::object CIMInstance::createProperty(const Pegasus::CIMConstProperty &property)
+{
+    if (property.getValue().getType() != Pegasus::CIMTYPE_REFERENCE)
+        return CIMProperty::create(property);
+
+    // We got a property with CIMObjectPath value. Let's set its
+    // hostname which could be left out by Pegasus.
+    // FIXME: refactor using getHostname()
+    const CIMInstanceName &this_iname = getPath();
+    Pegasus::CIMProperty peg_property = property.clone();
+    Pegasus::CIMValue peg_value = peg_property.getValue();
+    Pegasus::CIMObjectPath peg_iname;
+    peg_value.get(peg_iname);
+    peg_iname.setHost(this_iname.getHostname());
+    peg_value.set(peg_iname);
+    peg_property.setValue(peg_value);
+
+    return CIMProperty::create(peg_property);
+}
+
+void CIMInstance::setPropertyUsageTracker(const PropertyUsageTrackerPtr &tracker)
+{
+    m_property_usage = tracker;
+    m_is_partial = tracker && tracker->isPartial();
+}
+
+void CIMInstance::accessProperty(const bp::object &key)
+{
+    recordPropertyAccess(key);
+
+    // Property was not requested from CIMOM; fetch the whole instance.
+    if (m_property_usage && m_is_partial && !m_properties.contains(key))
+        refetchProperties();
+}
+
+void CIMInstance::recordPropertyAccess(const bp::object &key)
+{
+    evalProperties();
+
+    // Non-string keys are left to NocaseDict, which raises KeyError.
+    if (m_property_usage && isbasestring(key))
+        m_property_usage->access(StringConv::asString(key));
+}
+
+void CIMInstance::accessAllProperties()
+{
+    evalProperties();
+
+    if (!m_property_usage)
+        return;
+
+    m_property_usage->accessAll();
+
+    if (m_is_partial)
+        refetchProperties();
+}
+
+void CIMInstance::refetchProperties()
+{
+    if (isnone(getPyPath()))
+        throw_ValueError("Can't fetch missing properties of instance without path");
+
+    // Raises, if the refetch fails; the next access tries again.
+    const CIMInstanceName &path = CIMInstanceName::asNative(getPyPath());
+    Pegasus::CIMInstance peg_instance = m_property_usage->refetch(
+        path.asPegasusCIMObjectPath());
+    m_is_partial = false;
+
+    // Add only missing properties; the present ones could have been
+    // modified.
+    Pegasus::Uint32 cnt = peg_instance.getPropertyCount();
+    for (Pegasus::Uint32 i = 0; i < cnt; ++i) {
+        Pegasus::CIMConstProperty peg_property = peg_instance.getProperty(i);
+        bp::object py_prop_name(peg_property.getName());
+        if (m_properties.contains(py_prop_name))
+            continue;
+
+        m_properties[py_prop_name] = createProperty(peg_property);
+        if (!isnone(m_property_list))
+            m_property_list.attr("append")(py_prop_name);
+    }
+}
+
 void CIMInstance::updatePegasusCIMInstanceNamespace(
     Pegasus::CIMInstance &instance,
     const String &ns)
@@ -27,6 +27,8 @@
 #  include "lmiwbem.h"
 #  include "lmiwbem_refcountedptr.h"
 #  include "obj/lmiwbem_cimbase.h"
+#  include "util/lmiwbem_property_usage.h"
+#  include "util/lmiwbem_census.h"
 #  include "util/lmiwbem_string.h"
 
 PEGASUS_BEGIN
@@ -37,7 +39,9 @@ namespace bp = boost::python;
 
 class CIMInstanceName;
 
-class CIMInstance: public CIMBase<CIMInstance>
+class CIMInstance:
+    public CIMBase<CIMInstance>,
+    public Census<CIMInstance>
 {
 public:
     CIMInstance();
@@ -80,12 +84,22 @@ public:
 
     bp::object copy();
 
+    bp::object reduce();
+    bp::object getstate();
+    void setstate(const bp::object &state);
+
+    // Memory owned by native members and by unevaluated Pegasus objects;
+    // see Census.
+    std::size_t heapSize() const;
+    std::size_t lazySize() const;
+
     String getClassname() const;
     CIMInstanceName getPath();
     const CIMInstanceName &getPath() const;
     bp::object getPyClassname() const;
     bp::object getPyPath();
     bp::object getPyProperties();
+    bp::object getPyPropertiesTracked();
     bp::object getPyQualifiers();
     bp::object getPyPropertyList();
 
@@ -96,6 +110,9 @@ public:
     void setPyQualifiers(const bp::object &qualifiers);
     void setPyPropertyList(const bp::object &property_list);
 
+    // Records property access in adaptive PropertyList mode.
+    void setPropertyUsageTracker(const PropertyUsageTrackerPtr &tracker);
+
     static void updatePegasusCIMInstanceNamespace(
         Pegasus::CIMInstance &instance,
         const String &ns);
@@ -105,7 +122,15 @@ public:
     static bool isUninitialized(const Pegasus::CIMInstance &instance);
 
 private:
+    void setPegasusCIMInstance(const Pegasus::CIMInstance &instance);
+    Pegasus::CIMInstance snapshotPegasusCIMInstance() const;
     void evalProperties();
+    bp::object createProperty(const Pegasus::CIMConstProperty &property);
+
+    void accessProperty(const bp::object &key);
+    void recordPropertyAccess(const bp::object &key);
+    void accessAllProperties();
+    void refetchProperties();
 
     static String tomofContent(const bp::object &value);
 
@@ -118,6 +143,9 @@ private:
     RefCountedPtr<Pegasus::CIMObjectPath> m_rc_inst_path;
     RefCountedPtr<std::list<Pegasus::CIMConstProperty> > m_rc_inst_properties;
     RefCountedPtr<std::list<Pegasus::CIMConstQualifier> > m_rc_inst_qualifiers;
+
+    PropertyUsageTrackerPtr m_property_usage;
+    bool m_is_partial;
 };
 
 #endif // LMIWBEM_INSTANCE_H
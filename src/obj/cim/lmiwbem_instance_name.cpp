@@ -20,22 +20,43 @@
  * ***** END LICENSE BLOCK ***** */
 
 #include <config.h>
+#include <algorithm>
 #include <sstream>
 #include <boost/algorithm/string/replace.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/python/class.hpp>
 #include <boost/python/dict.hpp>
+#include <boost/python/tuple.hpp>
 #include <Pegasus/Common/CIMObjectPath.h>
 #include <Pegasus/Common/CIMValue.h>
+#include "lmiwbem_config.h"
+#include "lmiwbem_exception.h"
 #include "obj/lmiwbem_nocasedict.h"
 #include "obj/cim/lmiwbem_instance_name.h"
 #include "util/lmiwbem_convert.h"
+#include "util/lmiwbem_pickle.h"
 #include "util/lmiwbem_util.h"
 
+namespace {
+
+String quoted(const String &str)
+{
+    String escaped(str);
+    boost::replace_all(escaped, "\\", "\\\\");
+    boost::replace_all(escaped, "\"", "\\\"");
+    return "\"" + escaped + "\"";
+}
+
+} // unnamed namespace
+
 CIMInstanceName::CIMInstanceName()
     : m_classname()
     , m_namespace()
     , m_hostname()
     , m_keybindings()
+    , m_canonical_key()
+    , m_hash(0)
+    , m_rc_inst_name_keybindings()
 {
 }
 
@@ -48,6 +69,9 @@ CIMInstanceName::CIMInstanceName(
     , m_namespace()
     , m_hostname()
     , m_keybindings()
+    , m_canonical_key()
+    , m_hash(0)
+    , m_rc_inst_name_keybindings()
 {
     m_classname = StringConv::asString(cls, "classname");
     m_namespace = StringConv::asString(ns, "namespace");
@@ -89,6 +113,10 @@ void CIMInstanceName::init_type()
         .def("__ge__", &CIMInstanceName::ge)
         .def("__le__", &CIMInstanceName::le)
 #  endif // PY_MAJOR_VERSION
+        .def("__hash__", &CIMInstanceName::hash,
+            ":returns: hash computed from case-insensitive canonical form\n"
+            "\tof the object path\n"
+            ":rtype: int")
         .def("__str__", &CIMInstanceName::str,
             ":returns: serialized object\n"
             ":rtype: unicode")
@@ -133,6 +161,23 @@ void CIMInstanceName::init_type()
             "copy()\n\n"
             ":returns: copy of the object itself\n"
             ":rtype: :py:class:`.CIMInstanceName`")
+        .def("__reduce__", &CIMInstanceName::reduce,
+            "__reduce__()\n\n"
+            ":returns: tuple used by :py:mod:`pickle` to serialize the object\n"
+            ":rtype: tuple")
+        .def("__getstate__", &CIMInstanceName::getstate,
+            "__getstate__()\n\n"
+            ":returns: state of the object for :py:mod:`pickle`\n"
+            ":rtype: tuple")
+        .def("__setstate__", &CIMInstanceName::setstate,
+            "__setstate__(state)\n\n"
+            "Restores the object from state returned by :py:meth:`__getstate__`.\n\n"
+            ":param tuple state: state of the object")
+        .def("__sizeof__", &Census<CIMInstanceName>::sizeOf,
+            "__sizeof__()\n\n"
+            ":returns: size of the object in bytes including native data and\n"
+            "\tunevaluated CIMOM data, but not referenced Python objects\n"
+            ":rtype: int")
         .add_property("classname",
             &CIMInstanceName::getPyClassname,
             &CIMInstanceName::setPyClassname,
@@ -167,39 +212,44 @@ bp::object CIMInstanceName::create(
 
     bp::object py_inst = CIMBase<CIMInstanceName>::create();
     CIMInstanceName& fake_this = CIMInstanceName::asNative(py_inst);
+    fake_this.setPegasusCIMObjectPath(obj_path, ns, hostname);
 
-    fake_this.m_classname = obj_path.getClassName().getString();
-    fake_this.m_namespace = obj_path.getNameSpace().isNull() ? ns :
+    return py_inst;
+}
+
+void CIMInstanceName::setPegasusCIMObjectPath(
+    const Pegasus::CIMObjectPath &obj_path,
+    const String &ns,
+    const String &hostname)
+{
+    m_classname = obj_path.getClassName().getString();
+    m_namespace = obj_path.getNameSpace().isNull() ? ns :
         String(obj_path.getNameSpace().getString().getCString());
-    fake_this.m_hostname = obj_path.getHost() == Pegasus::String::EMPTY
+    m_hostname = obj_path.getHost() == Pegasus::String::EMPTY
         ? hostname : String(obj_path.getHost().getCString());
-    fake_this.m_keybindings = NocaseDict::create();
-
-    const Pegasus::Array<Pegasus::CIMKeyBinding> &peg_keybindings = obj_path.getKeyBindings();
-    const Pegasus::Uint32 cnt = peg_keybindings.size();
-    for (Pegasus::Uint32 i = 0; i < cnt; ++i) {
-        Pegasus::CIMKeyBinding peg_keybinding = peg_keybindings[i];
-
-        if (peg_keybinding.getType() == Pegasus::CIMKeyBinding::REFERENCE) {
-            // We got a keybinding with CIMObjectPath value. Let's set its
-            // hostname which could be left out by Pegasus.
-            Pegasus::CIMObjectPath peg_path(peg_keybinding.getValue());
-            if (peg_path.getHost() == Pegasus::String::EMPTY) {
-                peg_path.setHost(fake_this.m_hostname);
-                peg_keybinding.setValue(peg_path.toString());
-            }
-        }
-
-        bp::object py_value = keybindingToValue(peg_keybinding);
-
-        fake_this.m_keybindings[bp::object(peg_keybinding.getName())] = py_value;
-    }
-
-    return py_inst;
+    // Keybindings are converted to NocaseDict on demand. Object paths are
+    // mostly passed back to CIMOM without being inspected.
+    m_keybindings = bp::object();
+    m_canonical_key.clear();
+    m_hash = 0;
+    m_rc_inst_name_keybindings.set(obj_path.getKeyBindings());
 }
 
 Pegasus::CIMObjectPath CIMInstanceName::asPegasusCIMObjectPath() const
 {
+    CIMInstanceName *fake_this = const_cast<CIMInstanceName*>(this);
+    if (!fake_this->m_rc_inst_name_keybindings.empty()) {
+        // Keybindings were not evaluated, we can use Pegasus ones. Nested
+        // object paths get the hostname, as if they were evaluated.
+        return Pegasus::CIMObjectPath(
+            Pegasus::String(m_hostname),
+            Pegasus::CIMNamespaceName(m_namespace),
+            Pegasus::CIMName(m_classname),
+            keybindingsWithHostname(
+                *fake_this->m_rc_inst_name_keybindings.get(),
+                m_hostname));
+    }
+
     Pegasus::Array<Pegasus::CIMKeyBinding> peg_arr_keybindings;
 
     if (!isnone(m_keybindings)) {
@@ -278,13 +328,24 @@ int CIMInstanceName::cmp(const bp::object &other)
     int rval;
     if ((rval = m_classname.compare(cim_other.m_classname)) != 0 ||
         (rval = m_namespace.compare(cim_other.m_namespace)) != 0 ||
-        (rval = m_hostname.compare(cim_other.m_hostname)) != 0 ||
-        (rval = compare(m_keybindings, cim_other.m_keybindings)) != 0)
+        (rval = m_hostname.compare(cim_other.m_hostname)) != 0)
     {
         return rval;
     }
 
-    return 0;
+    if (!m_rc_inst_name_keybindings.empty() &&
+        !cim_other.m_rc_inst_name_keybindings.empty() &&
+        keybindingsEqual(
+            *m_rc_inst_name_keybindings.get(),
+            *cim_other.m_rc_inst_name_keybindings.get()))
+    {
+        return 0;
+    }
+
+    evalKeybindings();
+    cim_other.evalKeybindings();
+
+    return compare(m_keybindings, cim_other.m_keybindings);
 }
 #  else
 bool CIMInstanceName::eq(const bp::object &other)
@@ -294,10 +355,34 @@ bool CIMInstanceName::eq(const bp::object &other)
 
     CIMInstanceName &cim_other = CIMInstanceName::asNative(other);
 
-    return m_classname == cim_other.m_classname &&
-        m_namespace == cim_other.m_namespace &&
-        m_hostname  == cim_other.m_hostname  &&
-        compare(m_keybindings, cim_other.m_keybindings, Py_EQ);
+    if (!m_canonical_key.empty() && !cim_other.m_canonical_key.empty() &&
+        m_hash != cim_other.m_hash)
+    {
+        // Both objects have already been hashed, e.g. they are stored in
+        // a set or used as dictionary keys.
+        return false;
+    }
+
+    if (m_classname != cim_other.m_classname ||
+        m_namespace != cim_other.m_namespace ||
+        m_hostname  != cim_other.m_hostname)
+    {
+        return false;
+    }
+
+    if (!m_rc_inst_name_keybindings.empty() &&
+        !cim_other.m_rc_inst_name_keybindings.empty())
+    {
+        // Neither of the keybindings were evaluated, compare Pegasus ones.
+        return keybindingsEqual(
+            *m_rc_inst_name_keybindings.get(),
+            *cim_other.m_rc_inst_name_keybindings.get());
+    }
+
+    evalKeybindings();
+    cim_other.evalKeybindings();
+
+    return compare(m_keybindings, cim_other.m_keybindings, Py_EQ);
 }
 
 bool CIMInstanceName::gt(const bp::object &other)
@@ -307,6 +392,9 @@ bool CIMInstanceName::gt(const bp::object &other)
 
     CIMInstanceName &cim_other = CIMInstanceName::asNative(other);
 
+    evalKeybindings();
+    cim_other.evalKeybindings();
+
     return m_classname > cim_other.m_classname ||
         m_namespace > cim_other.m_namespace ||
         m_hostname  > cim_other.m_hostname  ||
@@ -320,6 +408,9 @@ bool CIMInstanceName::lt(const bp::object &other)
 
     CIMInstanceName &cim_other = CIMInstanceName::asNative(other);
 
+    evalKeybindings();
+    cim_other.evalKeybindings();
+
     return m_classname < cim_other.m_classname ||
         m_namespace < cim_other.m_namespace ||
         m_hostname  < cim_other.m_hostname  ||
@@ -337,20 +428,83 @@ bool CIMInstanceName::le(const bp::object &other)
 }
 #  endif // PY_MAJOR_VERSION
 
+long CIMInstanceName::hash()
+{
+    const String key = canonicalKey();
+    if (!m_canonical_key.empty())
+        return m_hash;
+
+    return static_cast<long>(boost::hash<std::string>()(key));
+}
+
+bp::object CIMInstanceName::reduce()
+{
+    return bp::make_tuple(CIMInstanceName::type(), bp::tuple(), getstate());
+}
+
+bp::object CIMInstanceName::getstate()
+{
+    // String form of the object path carries host, namespace, class name
+    // and keybindings; unevaluated keybindings are used as they are.
+    Pegasus::String path;
+    if (!m_classname.empty())
+        path = asPegasusCIMObjectPath().toString();
+    return bp::make_tuple(StringConv::asPyUnicode(path));
+}
+
+void CIMInstanceName::setstate(const bp::object &state) try
+{
+    const bp::tuple py_state(
+        PickleConv::asState(state, "CIMInstanceName", 1));
+    const String path(StringConv::asString(py_state[0], "path"));
+    if (path.empty())
+        return;
+
+    setPegasusCIMObjectPath(Pegasus::CIMObjectPath(path));
+} catch (...) {
+    std::stringstream ss;
+    if (Config::isVerbose())
+        ss << "CIMInstanceName.__setstate__()";
+    handle_all_exceptions(ss);
+}
+
 bp::object CIMInstanceName::copy()
 {
     bp::object py_inst = CIMBase<CIMInstanceName>::create();
     CIMInstanceName &cim_inst_name = CIMInstanceName::asNative(py_inst);
-    NocaseDict &cim_keybindings = NocaseDict::asNative(m_keybindings);
 
     cim_inst_name.m_classname = m_classname;
     cim_inst_name.m_namespace = m_namespace;
     cim_inst_name.m_hostname = m_hostname;
-    cim_inst_name.m_keybindings = cim_keybindings.copy();
+
+    if (!m_rc_inst_name_keybindings.empty()) {
+        // Pegasus::Array is copy-on-write; the copy will be evaluated on
+        // demand, too.
+        cim_inst_name.m_rc_inst_name_keybindings.set(
+            *m_rc_inst_name_keybindings.get());
+        cim_inst_name.m_canonical_key = m_canonical_key;
+        cim_inst_name.m_hash = m_hash;
+    } else {
+        NocaseDict &cim_keybindings = NocaseDict::asNative(m_keybindings);
+        cim_inst_name.m_keybindings = cim_keybindings.copy();
+    }
 
     return py_inst;
 }
 
+std::size_t CIMInstanceName::heapSize() const
+{
+    return MemSize::of(m_classname) +
+        MemSize::of(m_namespace) +
+        MemSize::of(m_hostname) +
+        MemSize::of(m_canonical_key);
+}
+
+std::size_t CIMInstanceName::lazySize() const
+{
+    return MemSize::of(m_rc_inst_name_keybindings);
+}
+
 String CIMInstanceName::asString() const
 {
     std::stringstream ss;
@@ -361,6 +515,9 @@ String CIMInstanceName::asString() const
         ss << m_namespace << ':';
     ss << m_classname << '.';
 
+    CIMInstanceName *fake_this = const_cast<CIMInstanceName*>(this);
+    fake_this->evalKeybindings();
+
     const NocaseDict &cim_keybindings = NocaseDict::asNative(m_keybindings);
     nocase_map_t::const_iterator it;
     for (it = cim_keybindings.begin(); it != cim_keybindings.end(); ++it) {
@@ -391,6 +548,9 @@ bp::object CIMInstanceName::str() const
 
 bp::object CIMInstanceName::repr() const
 {
+    CIMInstanceName *fake_this = const_cast<CIMInstanceName*>(this);
+    fake_this->evalKeybindings();
+
     std::stringstream ss;
     ss << "CIMInstanceName(classname=u'" << m_classname << "', keybindings="
        << ObjectConv::asString(m_keybindings);
@@ -403,61 +563,77 @@ bp::object CIMInstanceName::repr() const
 
 bp::object CIMInstanceName::getitem(const bp::object &key)
 {
+    evalKeybindings();
     return m_keybindings[key];
 }
 
 void CIMInstanceName::delitem(const bp::object &key)
 {
+    evalKeybindings();
     bp::delitem(m_keybindings, key);
 }
 
 void CIMInstanceName::setitem(const bp::object &key, const bp::object &value)
 {
+    evalKeybindings();
     m_keybindings[key] = value;
 }
 
 bp::object CIMInstanceName::len() const
 {
+    CIMInstanceName *fake_this = const_cast<CIMInstanceName*>(this);
+    if (!fake_this->m_rc_inst_name_keybindings.empty())
+        return bp::object(fake_this->m_rc_inst_name_keybindings.get()->size());
+
     return bp::object(bp::len(m_keybindings));
 }
 
 bp::object CIMInstanceName::haskey(const bp::object &key) const
 {
+    CIMInstanceName *fake_this = const_cast<CIMInstanceName*>(this);
+    fake_this->evalKeybindings();
+
     return m_keybindings.contains(key);
 }
 
 bp::object CIMInstanceName::keys()
 {
+    evalKeybindings();
     NocaseDict &cim_keybindings = NocaseDict::asNative(m_keybindings);
     return cim_keybindings.keys();
 }
 
 bp::object CIMInstanceName::values()
 {
+    evalKeybindings();
     NocaseDict &cim_keybindings = NocaseDict::asNative(m_keybindings);
     return cim_keybindings.values();
 }
 
 bp::object CIMInstanceName::items()
 {
+    evalKeybindings();
     NocaseDict &cim_keybindings = NocaseDict::asNative(m_keybindings);
     return cim_keybindings.items();
 }
 
 bp::object CIMInstanceName::iterkeys()
 {
+    evalKeybindings();
     NocaseDict &cim_keybindings = NocaseDict::asNative(m_keybindings);
     return cim_keybindings.iterkeys();
 }
 
 bp::object CIMInstanceName::itervalues()
 {
+    evalKeybindings();
     NocaseDict &cim_keybindings = NocaseDict::asNative(m_keybindings);
     return cim_keybindings.itervalues();
 }
 
 bp::object CIMInstanceName::iteritems()
 {
+    evalKeybindings();
     NocaseDict &cim_keybindings = NocaseDict::asNative(m_keybindings);
     return cim_keybindings.iteritems();
 }
@@ -492,47 +668,223 @@ bp::object CIMInstanceName::getPyHostname() const
     return StringConv::asPyUnicode(m_hostname);
 }
 
-bp::object CIMInstanceName::getPyKeybindings() const
+bp::object CIMInstanceName::getPyKeybindings()
 {
+    evalKeybindings();
     return m_keybindings;
 }
 
 void CIMInstanceName::setClassname(const String &classname)
 {
     m_classname = classname;
+    m_canonical_key.clear();
 }
 
 void CIMInstanceName::setNamespace(const String &namespace_)
 {
     m_namespace = namespace_;
+    m_canonical_key.clear();
 }
 
 void CIMInstanceName::setHostname(const String &hostname)
 {
     m_hostname = hostname;
+    m_canonical_key.clear();
 }
 
 void CIMInstanceName::setPyClassname(const bp::object &classname)
 {
     m_classname = StringConv::asString(classname, "classname");
+    m_canonical_key.clear();
 }
 
 void CIMInstanceName::setPyNamespace(const bp::object &namespace_)
 {
     m_namespace = StringConv::asString(namespace_, "namespace");
+    m_canonical_key.clear();
 }
 
 void CIMInstanceName::setPyHostname(const bp::object &hostname)
 {
     m_hostname = StringConv::asString(hostname, "hostname");
+    m_canonical_key.clear();
 }
 
 void CIMInstanceName::setPyKeybindings(const bp::object &keybindings)
 {
     m_keybindings = Conv::get<NocaseDict, bp::dict>(keybindings, "keybindings");
+    m_canonical_key.clear();
+
+    // Unref cached resource, it will never be used
+    m_rc_inst_name_keybindings.release();
+}
+
+void CIMInstanceName::evalKeybindings()
+{
+    if (m_rc_inst_name_keybindings.empty())
+        return;
+
+    m_keybindings = NocaseDict::create();
+    const Pegasus::Array<Pegasus::CIMKeyBinding> &peg_keybindings =
+        *m_rc_inst_name_keybindings.get();
+    const Pegasus::Uint32 cnt = peg_keybindings.size();
+    for (Pegasus::Uint32 i = 0; i < cnt; ++i) {
+        m_keybindings[bp::object(peg_keybindings[i].getName())] =
+            keybindingToValue(peg_keybindings[i], m_hostname);
+    }
+
+    m_canonical_key.clear();
+    m_rc_inst_name_keybindings.release();
+}
+
+String CIMInstanceName::canonicalKey()
+{
+    if (!m_canonical_key.empty())
+        return m_canonical_key;
+
+    if (!m_rc_inst_name_keybindings.empty()) {
+        m_canonical_key = canonicalKey(
+            m_hostname,
+            m_namespace,
+            m_classname,
+            *m_rc_inst_name_keybindings.get());
+        m_hash = static_cast<long>(boost::hash<std::string>()(m_canonical_key));
+        return m_canonical_key;
+    }
+
+    canonical_keybindings_t keybindings;
+    if (!isnone(m_keybindings)) {
+        const NocaseDict &cim_keybindings = NocaseDict::asNative(m_keybindings);
+        nocase_map_t::const_iterator it;
+        for (it = cim_keybindings.begin(); it != cim_keybindings.end(); ++it) {
+            String value;
+            if (isinstance(it->second, CIMInstanceName::type())) {
+                CIMInstanceName &cim_path = CIMInstanceName::asNative(it->second);
+                value = quoted(cim_path.canonicalKey());
+            } else if (isbasestring(it->second)) {
+                value = quoted(StringConv::asString(it->second));
+            } else {
+                value = ObjectConv::asString(it->second);
+            }
+
+            keybindings.push_back(std::make_pair(lowerCase(it->first), value));
+        }
+    }
+
+    return canonicalKey(m_hostname, m_namespace, m_classname, keybindings);
+}
+
+String CIMInstanceName::canonicalKey(
+    const String &hostname,
+    const String &ns,
+    const String &classname,
+    const Pegasus::Array<Pegasus::CIMKeyBinding> &keybindings)
+{
+    canonical_keybindings_t c_keybindings;
+    const Pegasus::Uint32 cnt = keybindings.size();
+    for (Pegasus::Uint32 i = 0; i < cnt; ++i) {
+        const Pegasus::CIMKeyBinding &keybinding = keybindings[i];
+
+        String value;
+        switch (keybinding.getType()) {
+        case Pegasus::CIMKeyBinding::STRING:
+            value = quoted(keybinding.getValue());
+            break;
+        case Pegasus::CIMKeyBinding::REFERENCE: {
+            // Mimic keybindingToValue(); nested object path gets hostname
+            // of the parent, if missing.
+            Pegasus::CIMObjectPath peg_path(keybinding.getValue());
+            updatePegasusCIMObjectPathHostname(peg_path, hostname);
+            value = quoted(canonicalKey(peg_path));
+            break;
+        }
+        default:
+            // Boolean and numeric values need to be formatted the same
+            // way, as if they were evaluated.
+            value = ObjectConv::asString(keybindingToValue(keybinding, hostname));
+            break;
+        }
+
+        c_keybindings.push_back(std::make_pair(
+            lowerCase(keybinding.getName().getString()), value));
+    }
+
+    return canonicalKey(hostname, ns, classname, c_keybindings);
+}
+
+String CIMInstanceName::canonicalKey(
+    const String &hostname,
+    const String &ns,
+    const String &classname,
+    canonical_keybindings_t &keybindings)
+{
+    std::sort(keybindings.begin(), keybindings.end());
+
+    std::stringstream ss;
+    ss << "//" << lowerCase(hostname) << '/' << lowerCase(ns) << ':'
+       << lowerCase(classname) << '.';
+
+    canonical_keybindings_t::const_iterator it;
+    for (it = keybindings.begin(); it != keybindings.end(); ++it) {
+        if (it != keybindings.begin())
+            ss << ',';
+        ss << it->first << '=' << it->second;
+    }
+
+    return ss.str();
 }
 
-bp::object CIMInstanceName::keybindingToValue(const Pegasus::CIMKeyBinding &keybinding)
+bool CIMInstanceName::keybindingsEqual(
+    const Pegasus::Array<Pegasus::CIMKeyBinding> &lhs,
+    const Pegasus::Array<Pegasus::CIMKeyBinding> &rhs)
+{
+    const Pegasus::Uint32 cnt = lhs.size();
+    if (cnt != rhs.size())
+        return false;
+
+    // Keybindings may come in any order. Pegasus compares names
+    // case-insensitively and values according to keybinding type.
+    for (Pegasus::Uint32 i = 0; i < cnt; ++i) {
+        Pegasus::Uint32 j = 0;
+        while (j < cnt && !(lhs[i] == rhs[j]))
+            ++j;
+        if (j == cnt)
+            return false;
+    }
+
+    return true;
+}
+
+Pegasus::Array<Pegasus::CIMKeyBinding> CIMInstanceName::keybindingsWithHostname(
+    const Pegasus::Array<Pegasus::CIMKeyBinding> &keybindings,
+    const String &hostname)
+{
+    Pegasus::Array<Pegasus::CIMKeyBinding> peg_keybindings(keybindings);
+    if (hostname.empty())
+        return peg_keybindings;
+
+    // Mimic keybindingToValue(); nested object path gets hostname of the
+    // parent, if missing.
+    const Pegasus::Uint32 cnt = peg_keybindings.size();
+    for (Pegasus::Uint32 i = 0; i < cnt; ++i) {
+        Pegasus::CIMKeyBinding &keybinding = peg_keybindings[i];
+        if (keybinding.getType() != Pegasus::CIMKeyBinding::REFERENCE)
+            continue;
+
+        Pegasus::CIMObjectPath peg_path(keybinding.getValue());
+        if (peg_path.getHost() != Pegasus::String::EMPTY)
+            continue;
+
+        updatePegasusCIMObjectPathHostname(peg_path, hostname);
+        keybinding.setValue(peg_path.toString());
+    }
+
+    return peg_keybindings;
+}
+
+bp::object CIMInstanceName::keybindingToValue(
+    const Pegasus::CIMKeyBinding &keybinding,
+    const String &hostname)
 {
     bp::object py_value;
 
@@ -559,7 +911,10 @@ bp::object CIMInstanceName::keybindingToValue(const Pegasus::CIMKeyBinding &keyb
         return None;
     }
     case Pegasus::CIMKeyBinding::REFERENCE:
-        return CIMInstanceName::create(Pegasus::CIMObjectPath(cim_value));
+        // We got a keybinding with CIMObjectPath value. Its hostname could
+        // be left out by Pegasus, so we use the one from parent path.
+        return CIMInstanceName::create(
+            Pegasus::CIMObjectPath(cim_value), String(), hostname);
     }
 
     return py_value;
@@ -595,3 +950,13 @@ bool CIMInstanceName::isUninitialized(const Pegasus::CIMObjectPath &path)
     // undefined or Null.
     return path.getClassName().isNull();
 }
+
+String CIMInstanceName::canonicalKey(const Pegasus::CIMObjectPath &path)
+{
+    return canonicalKey(
+        path.getHost(),
+        path.getNameSpace().isNull() ?
+            String() : String(path.getNameSpace().getString()),
+        path.getClassName().getString(),
+        path.getKeyBindings());
+}
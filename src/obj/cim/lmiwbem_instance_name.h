@@ -22,18 +22,21 @@
 #ifndef   LMIWBEM_INSTANCE_NAME_H
 #  define LMIWBEM_INSTANCE_NAME_H
 
+#  include <utility>
+#  include <vector>
 #  include <boost/python/object.hpp>
+#  include <Pegasus/Common/CIMObjectPath.h>
 #  include "lmiwbem.h"
+#  include "lmiwbem_refcountedptr.h"
 #  include "obj/lmiwbem_cimbase.h"
+#  include "util/lmiwbem_census.h"
 #  include "util/lmiwbem_string.h"
 
-PEGASUS_BEGIN
-class CIMObjectPath;
-PEGASUS_END
-
 namespace bp = boost::python;
 
-class CIMInstanceName: public CIMBase<CIMInstanceName>
+class CIMInstanceName:
+    public CIMBase<CIMInstanceName>,
+    public Census<CIMInstanceName>
 {
 public:
     CIMInstanceName();
@@ -60,6 +63,7 @@ public:
     bool ge(const bp::object &other);
     bool le(const bp::object &other);
 #  endif // PY_MAJOR_VERSION
+    long hash();
 
     String asString() const;
     bp::object str() const;
@@ -79,13 +83,22 @@ public:
 
     bp::object copy();
 
+    bp::object reduce();
+    bp::object getstate();
+    void setstate(const bp::object &state);
+
+    // Memory owned by native members and by unevaluated Pegasus objects;
+    // see Census.
+    std::size_t heapSize() const;
+    std::size_t lazySize() const;
+
     String getClassname() const;
     String getNamespace() const;
     String getHostname()  const;
     bp::object getPyClassname() const;
     bp::object getPyNamespace() const;
     bp::object getPyHostname() const;
-    bp::object getPyKeybindings() const;
+    bp::object getPyKeybindings();
 
     void setClassname(const String &classname);
     void setNamespace(const String &namespace_);
@@ -102,14 +115,50 @@ public:
         Pegasus::CIMObjectPath &path,
         const String &hostname);
     static bool isUninitialized(const Pegasus::CIMObjectPath &path);
+    static String canonicalKey(const Pegasus::CIMObjectPath &path);
 
 private:
-    static bp::object keybindingToValue(const Pegasus::CIMKeyBinding &keybinding);
+    typedef std::vector<std::pair<String, String> > canonical_keybindings_t;
+
+    void setPegasusCIMObjectPath(
+        const Pegasus::CIMObjectPath &obj_path,
+        const String &ns = String(),
+        const String &hostname = String());
+    void evalKeybindings();
+    String canonicalKey();
+
+    static String canonicalKey(
+        const String &hostname,
+        const String &ns,
+        const String &classname,
+        const Pegasus::Array<Pegasus::CIMKeyBinding> &keybindings);
+    static String canonicalKey(
+        const String &hostname,
+        const String &ns,
+        const String &classname,
+        canonical_keybindings_t &keybindings);
+
+    static bool keybindingsEqual(
+        const Pegasus::Array<Pegasus::CIMKeyBinding> &lhs,
+        const Pegasus::Array<Pegasus::CIMKeyBinding> &rhs);
+    static Pegasus::Array<Pegasus::CIMKeyBinding> keybindingsWithHostname(
+        const Pegasus::Array<Pegasus::CIMKeyBinding> &keybindings,
+        const String &hostname);
+    static bp::object keybindingToValue(
+        const Pegasus::CIMKeyBinding &keybinding,
+        const String &hostname);
 
     String m_classname;
     String m_namespace;
     String m_hostname;
     bp::object m_keybindings;
+
+    // Canonical key and hash are cached only while the keybindings are not
+    // evaluated; NocaseDict can be modified from Python at any time.
+    String m_canonical_key;
+    long m_hash;
+
+    RefCountedPtr<Pegasus::Array<Pegasus::CIMKeyBinding> > m_rc_inst_name_keybindings;
 };
 
 #endif // LMIWBEM_INSTANCE_NAME_H
@@ -132,6 +132,11 @@ void CIMProperty::init_type()
             "copy()\n\n"
             ":returns: copy of the object itself\n"
             ":rtype: :py:class:`.CIMProperty`")
+        .def("__sizeof__", &Census<CIMProperty>::sizeOf,
+            "__sizeof__()\n\n"
+            ":returns: size of the object in bytes including native data and\n"
+            "\tunevaluated CIMOM data, but not referenced Python objects\n"
+            ":rtype: int")
         .add_property("name",
             &CIMProperty::getPyName,
             &CIMProperty::setPyName,
@@ -351,6 +356,20 @@ bp::object CIMProperty::copy()
     return py_inst;
 }
 
+std::size_t CIMProperty::heapSize() const
+{
+    return MemSize::of(m_name) +
+        MemSize::of(m_type) +
+        MemSize::of(m_class_origin) +
+        MemSize::of(m_reference_class);
+}
+
+std::size_t CIMProperty::lazySize() const
+{
+    return MemSize::of(m_rc_prop_value) +
+        MemSize::of(m_rc_prop_qualifiers);
+}
+
 String CIMProperty::getName() const
 {
     return m_name;
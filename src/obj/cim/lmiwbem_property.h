@@ -27,6 +27,7 @@
 #  include "lmiwbem.h"
 #  include "lmiwbem_refcountedptr.h"
 #  include "obj/lmiwbem_cimbase.h"
+#  include "util/lmiwbem_census.h"
 #  include "util/lmiwbem_string.h"
 
 BOOST_PYTHON_BEGIN
@@ -38,7 +39,9 @@ BOOST_PYTHON_END
 
 namespace bp = boost::python;
 
-class CIMProperty: public CIMBase<CIMProperty>
+class CIMProperty:
+    public CIMBase<CIMProperty>,
+    public Census<CIMProperty>
 {
 public:
     CIMProperty();
@@ -75,6 +78,11 @@ public:
 
     bp::object copy();
 
+    // Memory owned by native members and by unevaluated Pegasus objects;
+    // see Census.
+    std::size_t heapSize() const;
+    std::size_t lazySize() const;
+
     String getName() const;
     String getType() const;
     String getClassOrigin() const;
@@ -108,6 +108,11 @@ void CIMQualifier::init_type()
             "copy()\n\n"
             ":returns: copy of the object itself\n"
             ":rtype: :py:class:`.CIMQualifier`")
+        .def("__sizeof__", &Census<CIMQualifier>::sizeOf,
+            "__sizeof__()\n\n"
+            ":returns: size of the object in bytes including native data and\n"
+            "\tunevaluated CIMOM data, but not referenced Python objects\n"
+            ":rtype: int")
         .def("tomof", &CIMQualifier::tomof,
             "tomof()\n\n"
             ":returns: MOF representation of the object itself\n"
@@ -337,6 +342,16 @@ bp::object CIMQualifier::copy()
     return py_inst;
 }
 
+std::size_t CIMQualifier::heapSize() const
+{
+    return MemSize::of(m_name) + MemSize::of(m_type);
+}
+
+std::size_t CIMQualifier::lazySize() const
+{
+    return 0;
+}
+
 String CIMQualifier::getName() const
 {
     return m_name;
@@ -25,6 +25,7 @@
 #  include <boost/python/object.hpp>
 #  include "lmiwbem.h"
 #  include "obj/lmiwbem_cimbase.h"
+#  include "util/lmiwbem_census.h"
 #  include "util/lmiwbem_string.h"
 
 BOOST_PYTHON_BEGIN
@@ -33,7 +34,9 @@ BOOST_PYTHON_END
 
 namespace bp = boost::python;
 
-class CIMQualifier: public CIMBase<CIMQualifier>
+class CIMQualifier:
+    public CIMBase<CIMQualifier>,
+    public Census<CIMQualifier>
 {
 public:
     CIMQualifier();
@@ -68,6 +71,11 @@ public:
 
     bp::object copy();
 
+    // Memory owned by native members and by unevaluated Pegasus objects;
+    // see Census.
+    std::size_t heapSize() const;
+    std::size_t lazySize() const;
+
     String getName() const;
     String getType() const;
     bool getIsPropagated()   const;
@@ -0,0 +1,297 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include <sstream>
+#include <boost/python/class.hpp>
+#include "lmiwbem_config.h"
+#include "lmiwbem_exception.h"
+#include "obj/lmiwbem_batch.h"
+#include "obj/lmiwbem_connection.h"
+#include "obj/cim/lmiwbem_instance_name.h"
+#include "util/lmiwbem_convert.h"
+#include "util/lmiwbem_util.h"
+
+BatchOperation::BatchOperation(Type type)
+    : type(type)
+    , ns()
+    , path()
+    , classname()
+    , local_only(false)
+    , include_qualifiers(false)
+    , include_class_origin(false)
+    , property_list()
+{
+}
+
+WBEMBatch::WBEMBatch(const bp::object &conn)
+    : m_conn(conn)
+    , m_operations()
+    , m_results()
+{
+    // Check the type early.
+    WBEMConnection::asNative(conn, "conn");
+}
+
+void WBEMBatch::init_type()
+{
+    CIMBase<WBEMBatch>::init_type(
+        bp::class_<WBEMBatch>("WBEMBatch", bp::no_init)
+        .def(bp::init<const bp::object &>((
+            bp::arg("conn")),
+            "Collects CIM operations and executes them over a single\n"
+            "connection, which is established once for the whole batch. Each\n"
+            "operation returns index of its result. The operations are\n"
+            "executed by :py:meth:`execute` or when leaving ``with`` block\n"
+            "without an exception::\n\n"
+            "\twith conn.batch() as b:\n"
+            "\t\tfor path in paths:\n"
+            "\t\t\tb.GetInstance(path)\n"
+            "\tinstances = b.results\n\n"
+            "Errors of individual operations don't abort the batch; the\n"
+            ":py:exc:`.CIMError` or :py:exc:`.ConnectionError` object is stored\n"
+            "as result of the failed operation instead.\n\n"
+            ":param WBEMConnection conn: connection used to execute the batch"))
+        .def("__repr__", &WBEMBatch::repr)
+        .def("__enter__", &WBEMBatch::enter)
+        .def("__exit__", &WBEMBatch::exit)
+        .def("__getitem__", &WBEMBatch::getitem)
+        .def("__len__", &WBEMBatch::len)
+        .def("GetInstance", &WBEMBatch::getInstance,
+            (bp::arg("InstanceName"),
+             bp::arg("namespace") = None,
+             bp::arg("LocalOnly") = true,
+             bp::arg("IncludeQualifiers") = false,
+             bp::arg("IncludeClassOrigin") = false,
+             bp::arg("PropertyList") = None),
+            "GetInstance(InstanceName, namespace=None, LocalOnly=True, "
+            "IncludeQualifiers=False, IncludeClassOrigin=False, PropertyList=None)\n\n"
+            "Adds GetInstance operation to the batch; see\n"
+            ":py:meth:`.WBEMConnection.GetInstance`.\n\n"
+            ":returns: index of the result")
+        .def("GetClass", &WBEMBatch::getClass,
+            (bp::arg("ClassName"),
+             bp::arg("namespace") = None,
+             bp::arg("LocalOnly") = true,
+             bp::arg("IncludeQualifiers") = true,
+             bp::arg("IncludeClassOrigin") = false,
+             bp::arg("PropertyList") = None),
+            "GetClass(ClassName, namespace=None, LocalOnly=True, "
+            "IncludeQualifiers=True, IncludeClassOrigin=False, PropertyList=None)\n\n"
+            "Adds GetClass operation to the batch; see\n"
+            ":py:meth:`.WBEMConnection.GetClass`.\n\n"
+            ":returns: index of the result")
+        .def("EnumerateInstanceNames", &WBEMBatch::enumerateInstanceNames,
+            (bp::arg("ClassName"),
+             bp::arg("namespace") = None),
+            "EnumerateInstanceNames(ClassName, namespace=None)\n\n"
+            "Adds EnumerateInstanceNames operation to the batch; see\n"
+            ":py:meth:`.WBEMConnection.EnumerateInstanceNames`.\n\n"
+            ":returns: index of the result")
+        .def("DeleteInstance", &WBEMBatch::deleteInstance,
+            (bp::arg("InstanceName")),
+            "DeleteInstance(InstanceName)\n\n"
+            "Adds DeleteInstance operation to the batch; see\n"
+            ":py:meth:`.WBEMConnection.DeleteInstance`. Result of the\n"
+            "operation is None.\n\n"
+            ":returns: index of the result")
+        .def("execute", &WBEMBatch::execute,
+            "execute()\n\n"
+            "Executes pending operations. Further operations can be added\n"
+            "and executed afterwards.\n\n"
+            ":returns: list of results of the executed operations\n"
+            ":raises: :py:exc:`.ConnectionError`, if the connection can't\n"
+            "\tbe established; the operations stay pending")
+        .add_property("conn", &WBEMBatch::getPyConnection,
+            "Property storing connection used to execute the batch.\n\n"
+            ":rtype: :py:class:`.WBEMConnection`")
+        .add_property("results", &WBEMBatch::getPyResults,
+            "Property storing list of results of the executed operations.\n\n"
+            ":rtype: list")
+        .add_property("pending", &WBEMBatch::getPending,
+            "Property storing number of operations waiting for execution.\n\n"
+            ":rtype: int"));
+}
+
+bp::object WBEMBatch::repr()
+{
+    std::stringstream ss;
+    ss << "WBEMBatch(results=" << bp::len(m_results)
+       << ", pending=" << m_operations.size() << ')';
+    return StringConv::asPyUnicode(ss.str());
+}
+
+bp::object WBEMBatch::enter(const bp::object &self)
+{
+    return self;
+}
+
+bool WBEMBatch::exit(
+    const bp::object &type,
+    const bp::object &value,
+    const bp::object &traceback)
+{
+    if (isnone(type))
+        execute();
+
+    // Don't suppress exceptions raised inside the with block.
+    return false;
+}
+
+int WBEMBatch::getInstance(
+    const bp::object &instance_name,
+    const bp::object &ns,
+    const bool local_only,
+    const bool include_qualifiers,
+    const bool include_class_origin,
+    const bp::object &property_list)
+{
+    const CIMInstanceName &cim_instance_name = CIMInstanceName::asNative(
+        instance_name, "InstanceName");
+
+    BatchOperation operation(BatchOperation::GET_INSTANCE);
+    operation.path = cim_instance_name.asPegasusCIMObjectPath();
+    if (isnone(ns) && !cim_instance_name.getNamespace().empty())
+        operation.ns = Pegasus::CIMNamespaceName(cim_instance_name.getNamespace());
+    else
+        operation.ns = namespaceName(ns);
+    operation.local_only = local_only;
+    operation.include_qualifiers = include_qualifiers;
+    operation.include_class_origin = include_class_origin;
+    operation.property_list = ListConv::asPegasusPropertyList(
+        property_list, "PropertyList");
+
+    return add(operation);
+}
+
+int WBEMBatch::getClass(
+    const bp::object &cls,
+    const bp::object &ns,
+    const bool local_only,
+    const bool include_qualifiers,
+    const bool include_class_origin,
+    const bp::object &property_list)
+{
+    BatchOperation operation(BatchOperation::GET_CLASS);
+    operation.classname = Pegasus::CIMName(
+        StringConv::asString(cls, "ClassName"));
+    operation.ns = namespaceName(ns);
+    operation.local_only = local_only;
+    operation.include_qualifiers = include_qualifiers;
+    operation.include_class_origin = include_class_origin;
+    operation.property_list = ListConv::asPegasusPropertyList(
+        property_list, "PropertyList");
+
+    return add(operation);
+}
+
+int WBEMBatch::enumerateInstanceNames(
+    const bp::object &cls,
+    const bp::object &ns)
+{
+    BatchOperation operation(BatchOperation::ENUMERATE_INSTANCE_NAMES);
+    operation.classname = Pegasus::CIMName(
+        StringConv::asString(cls, "ClassName"));
+    operation.ns = namespaceName(ns);
+
+    return add(operation);
+}
+
+int WBEMBatch::deleteInstance(const bp::object &instance_name)
+{
+    const CIMInstanceName &cim_instance_name = CIMInstanceName::asNative(
+        instance_name, "InstanceName");
+
+    BatchOperation operation(BatchOperation::DELETE_INSTANCE);
+    operation.path = cim_instance_name.asPegasusCIMObjectPath();
+    if (!cim_instance_name.getNamespace().empty())
+        operation.ns = Pegasus::CIMNamespaceName(cim_instance_name.getNamespace());
+    else
+        operation.ns = namespaceName(None);
+
+    return add(operation);
+}
+
+bp::object WBEMBatch::execute() try
+{
+    WBEMConnection &conn = WBEMConnection::asNative(m_conn);
+    bp::list py_results(conn.executeBatch(m_operations));
+    m_operations.clear();
+    m_results.extend(py_results);
+    return py_results;
+} catch (...) {
+    std::stringstream ss;
+    if (Config::isVerbose())
+        ss << "Batch(" << m_operations.size() << " operations)";
+    handle_all_exceptions(ss);
+    return None;
+}
+
+bp::object WBEMBatch::getitem(int index)
+{
+    const int cnt = bp::len(m_results);
+    if (index < 0)
+        index += cnt;
+
+    if (index >= cnt && index < cnt + static_cast<int>(m_operations.size()))
+        throw_IndexError("Operation has not been executed yet");
+    else if (index < 0 || index >= cnt)
+        throw_IndexError("Batch index out of range");
+
+    return m_results[index];
+}
+
+int WBEMBatch::len()
+{
+    return bp::len(m_results) + static_cast<int>(m_operations.size());
+}
+
+bp::object WBEMBatch::getPyConnection()
+{
+    return m_conn;
+}
+
+bp::object WBEMBatch::getPyResults()
+{
+    return m_results;
+}
+
+int WBEMBatch::getPending()
+{
+    return static_cast<int>(m_operations.size());
+}
+
+int WBEMBatch::add(const BatchOperation &operation)
+{
+    m_operations.push_back(operation);
+    return len() - 1;
+}
+
+Pegasus::CIMNamespaceName WBEMBatch::namespaceName(const bp::object &ns)
+{
+    if (isnone(ns)) {
+        WBEMConnection &conn = WBEMConnection::asNative(m_conn);
+        return Pegasus::CIMNamespaceName(
+            StringConv::asString(conn.getDefaultNamespace()));
+    }
+
+    return Pegasus::CIMNamespaceName(StringConv::asString(ns, "namespace"));
+}
@@ -0,0 +1,117 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_BATCH_H
+#  define LMIWBEM_BATCH_H
+
+#  include <vector>
+#  include <boost/python/list.hpp>
+#  include <Pegasus/Common/CIMName.h>
+#  include <Pegasus/Common/CIMObjectPath.h>
+#  include <Pegasus/Common/CIMPropertyList.h>
+#  include "lmiwbem.h"
+#  include "obj/lmiwbem_cimbase.h"
+
+namespace bp = boost::python;
+
+// Single operation of WBEMBatch. Parameters are converted to Pegasus types
+// when the operation is added, so the batch runs without touching Python
+// objects except for its results.
+struct BatchOperation
+{
+    enum Type {
+        GET_INSTANCE,
+        GET_CLASS,
+        ENUMERATE_INSTANCE_NAMES,
+        DELETE_INSTANCE
+    };
+
+    BatchOperation(Type type);
+
+    Type type;
+    Pegasus::CIMNamespaceName ns;
+    Pegasus::CIMObjectPath path;
+    Pegasus::CIMName classname;
+    bool local_only;
+    bool include_qualifiers;
+    bool include_class_origin;
+    Pegasus::CIMPropertyList property_list;
+};
+
+// Collects CIM operations and executes them over a single connection.
+// Each operation returns index of its result; errors of individual
+// operations are stored as results instead of being raised.
+class WBEMBatch: public CIMBase<WBEMBatch>
+{
+public:
+    WBEMBatch(const bp::object &conn);
+
+    static void init_type();
+
+    bp::object repr();
+
+    static bp::object enter(const bp::object &self);
+    bool exit(
+        const bp::object &type,
+        const bp::object &value,
+        const bp::object &traceback);
+
+    int getInstance(
+        const bp::object &instance_name,
+        const bp::object &ns,
+        const bool local_only,
+        const bool include_qualifiers,
+        const bool include_class_origin,
+        const bp::object &property_list);
+
+    int getClass(
+        const bp::object &cls,
+        const bp::object &ns,
+        const bool local_only,
+        const bool include_qualifiers,
+        const bool include_class_origin,
+        const bp::object &property_list);
+
+    int enumerateInstanceNames(
+        const bp::object &cls,
+        const bp::object &ns);
+
+    int deleteInstance(const bp::object &instance_name);
+
+    bp::object execute();
+
+    bp::object getitem(int index);
+    int len();
+
+    bp::object getPyConnection();
+    bp::object getPyResults();
+    int getPending();
+
+private:
+    int add(const BatchOperation &operation);
+    Pegasus::CIMNamespaceName namespaceName(const bp::object &ns);
+
+    bp::object m_conn;
+    std::vector<BatchOperation> m_operations;
+    bp::list m_results;
+};
+
+#endif // LMIWBEM_BATCH_H
@@ -0,0 +1,236 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include <algorithm>
+#include <Pegasus/Common/Exception.h>
+#include "lmiwbem_config.h"
+#include "lmiwbem_urlinfo.h"
+#include "obj/lmiwbem_bulk.h"
+#include "obj/lmiwbem_connection.h"
+#include "obj/cim/lmiwbem_constants.h"
+
+BulkTask::BulkTask()
+    : error()
+{
+}
+
+BulkTask::~BulkTask()
+{
+}
+
+bool BulkTask::isIdempotent() const
+{
+    return true;
+}
+
+BulkExecutor::BulkExecutor(WBEMConnection &conn, unsigned int concurrency)
+    : m_connect_locally(conn.m_connect_locally)
+    , m_url(conn.m_url)
+    , m_username(conn.m_username)
+    , m_password(conn.m_password)
+    , m_cert_file(conn.m_cert_file)
+    , m_key_file(conn.m_key_file)
+    , m_trust_store(Config::defaultTrustStore())
+    , m_verify_cert(conn.m_client.getVerifyCertificate())
+    , m_timeout(conn.m_client.getTimeout())
+    , m_accept_languages(conn.m_client.getRequestAcceptLanguages())
+    , m_concurrency(std::max(concurrency, 1U))
+    , m_hostname()
+    , m_mutex()
+    , m_tasks(NULL)
+    , m_next(0)
+    , m_connect_error()
+    , m_clients()
+{
+    URLInfo url_info;
+    if (m_connect_locally) {
+        url_info.set("localhost");
+        m_hostname = url_info.hostname();
+        return;
+    }
+
+    // Explicitly connected WBEMConnection may talk to other URL than the
+    // one passed to its constructor, with other certificate and key.
+    if (conn.m_client.isConnected()) {
+        m_url = conn.m_client.getURLInfo().url();
+        m_cert_file = conn.m_client.getCertFile();
+        m_key_file = conn.m_client.getKeyFile();
+    }
+
+    // Workers connect without the GIL; report invalid URL here.
+    if (m_url.empty())
+        throw_ValueError("WBEMConnection constructed without url parameter");
+    else if (!url_info.set(m_url))
+        throw_ConnectionError(
+            "Invalid locator",
+            CIMConstants::CON_ERR_INVALID_LOCATOR);
+    m_hostname = url_info.hostname();
+}
+
+BulkExecutor::~BulkExecutor()
+{
+    std::vector<CIMClientPtr>::iterator it;
+    for (it = m_clients.begin(); it != m_clients.end(); ++it)
+        (*it)->disconnect();
+}
+
+String BulkExecutor::hostname() const
+{
+    return m_hostname;
+}
+
+void BulkExecutor::run(const std::vector<BulkTask*> &tasks)
+{
+    m_tasks = &tasks;
+    m_next = 0;
+
+    // The calling thread is one of the workers.
+    const std::size_t cnt = std::min(
+        static_cast<std::size_t>(m_concurrency), tasks.size());
+    std::vector<pthread_t> workers;
+    for (std::size_t i = 1; i < cnt; ++i) {
+        pthread_t worker;
+        if (pthread_create(&worker, NULL, &BulkExecutor::work, this) != 0)
+            break;
+        workers.push_back(worker);
+    }
+
+    workLoop();
+
+    std::vector<pthread_t>::iterator it;
+    for (it = workers.begin(); it != workers.end(); ++it)
+        pthread_join(*it, NULL);
+
+    // No worker could connect; fail the tasks, which were not run.
+    for (std::size_t i = m_next; i < tasks.size(); ++i)
+        tasks[i]->error = m_connect_error;
+
+    m_tasks = NULL;
+}
+
+void *BulkExecutor::work(void *executor)
+{
+    static_cast<BulkExecutor*>(executor)->workLoop();
+    return NULL;
+}
+
+void BulkExecutor::workLoop()
+{
+    CIMClientPtr client(acquireClient());
+
+    // Connection taken from the pool may have been closed by the CIMOM.
+    bool reused = client->isConnected();
+    while (true) {
+        if (!client->isConnected()) {
+            // Connect before taking a task; if this worker can't connect,
+            // the tasks are left to the others.
+            try {
+                connect(*client);
+            } catch (...) {
+                {
+                    ScopedMutex sm(m_mutex);
+                    m_connect_error.capture();
+                }
+                releaseClient(client);
+                return;
+            }
+        }
+
+        BulkTask *task;
+        {
+            ScopedMutex sm(m_mutex);
+            if (m_next == m_tasks->size())
+                break;
+            task = (*m_tasks)[m_next++];
+        }
+
+        try {
+            task->run(*client);
+        } catch (const Pegasus::CIMException &e) {
+            // Error reported by the CIMOM; the connection is still usable.
+            task->error.capture();
+        } catch (...) {
+            client->disconnect();
+            if (!reused || !task->isIdempotent())
+                task->error.capture();
+            else
+                retry(*client, *task);
+        }
+        reused = false;
+    }
+
+    releaseClient(client);
+}
+
+void BulkExecutor::connect(CIMClient &client)
+{
+    if (m_connect_locally) {
+        client.connectLocally();
+        return;
+    }
+
+    client.connect(
+        m_url,
+        m_username,
+        m_password,
+        m_cert_file,
+        m_key_file,
+        m_trust_store);
+}
+
+void BulkExecutor::retry(CIMClient &client, BulkTask &task)
+{
+    // Retry only once, over a new connection.
+    try {
+        connect(client);
+        task.run(client);
+    } catch (const Pegasus::CIMException &e) {
+        task.error.capture();
+    } catch (...) {
+        task.error.capture();
+        client.disconnect();
+    }
+}
+
+BulkExecutor::CIMClientPtr BulkExecutor::acquireClient()
+{
+    {
+        ScopedMutex sm(m_mutex);
+        if (!m_clients.empty()) {
+            CIMClientPtr client(m_clients.back());
+            m_clients.pop_back();
+            return client;
+        }
+    }
+
+    CIMClientPtr client(new CIMClient);
+    client->setVerifyCertificate(m_verify_cert);
+    client->setTimeout(m_timeout);
+    client->setRequestAcceptLanguages(m_accept_languages);
+    return client;
+}
+
+void BulkExecutor::releaseClient(const CIMClientPtr &client)
+{
+    ScopedMutex sm(m_mutex);
+    m_clients.push_back(client);
+}
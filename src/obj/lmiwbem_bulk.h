@@ -0,0 +1,108 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_BULK_H
+#  define LMIWBEM_BULK_H
+
+#  include <cstddef>
+#  include <vector>
+#  include <pthread.h>
+#  include <boost/shared_ptr.hpp>
+#  include "lmiwbem.h"
+#  include "lmiwbem_client.h"
+#  include "lmiwbem_exception.h"
+#  include "lmiwbem_mutex.h"
+#  include "util/lmiwbem_string.h"
+
+class WBEMConnection;
+
+// Single CIM operation of a bulk call. Parameters are converted to Pegasus
+// types beforehand; run() is called without the GIL.
+class BulkTask
+{
+public:
+    BulkTask();
+    virtual ~BulkTask();
+
+    virtual void run(CIMClient &client) = 0;
+
+    // Idempotent task is run once more, if it fails on a pooled connection,
+    // which the CIMOM may have closed meanwhile.
+    virtual bool isIdempotent() const;
+
+    CapturedException error;
+};
+
+// Runs independent CIM operations over a bounded number of parallel
+// connections to the CIMOM of a WBEMConnection. Each worker thread takes
+// its own client from the executor's pool, so the operations don't
+// serialize on the connection. Pooled clients stay connected between run()
+// calls and are disconnected, when the executor is destroyed.
+class BulkExecutor
+{
+public:
+    // Connection parameters are copied from conn; needs the GIL.
+    BulkExecutor(WBEMConnection &conn, unsigned int concurrency);
+    ~BulkExecutor();
+
+    // Runs all the tasks and waits for them. Errors are stored in the
+    // tasks. Call without the GIL.
+    void run(const std::vector<BulkTask*> &tasks);
+
+    // Host name of the CIMOM, as CIMClient::hostname() reports it.
+    String hostname() const;
+
+private:
+    typedef boost::shared_ptr<CIMClient> CIMClientPtr;
+
+    static void *work(void *executor);
+    void workLoop();
+    void connect(CIMClient &client);
+    void retry(CIMClient &client, BulkTask &task);
+
+    CIMClientPtr acquireClient();
+    void releaseClient(const CIMClientPtr &client);
+
+    bool m_connect_locally;
+    String m_url;
+    String m_username;
+    String m_password;
+    String m_cert_file;
+    String m_key_file;
+    String m_trust_store;
+    bool m_verify_cert;
+    Pegasus::Uint32 m_timeout;
+    Pegasus::AcceptLanguageList m_accept_languages;
+    unsigned int m_concurrency;
+    String m_hostname;
+
+    // Guard the members below.
+    Mutex m_mutex;
+    const std::vector<BulkTask*> *m_tasks;
+    std::size_t m_next;
+    // Set, if a worker could not connect; the remaining tasks fail with the
+    // same error instead of waiting for connection timeout one by one.
+    CapturedException m_connect_error;
+    // Clients not used by any worker
+    std::vector<CIMClientPtr> m_clients;
+};
+
+#endif // LMIWBEM_BULK_H
@@ -20,6 +20,11 @@
  * ***** END LICENSE BLOCK ***** */
 
 #include <config.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
 #include <boost/python/dict.hpp>
 #include <boost/python/list.hpp>
 #include <boost/python/object.hpp>
@@ -27,29 +32,319 @@
 #include <boost/python/tuple.hpp>
 #include <Pegasus/Common/CIMName.h>
 #include <Pegasus/Common/CIMPropertyList.h>
+#include <Pegasus/Client/CIMClientException.h>
 #include "lmiwbem_config.h"
 #include "lmiwbem_exception.h"
 #include "lmiwbem_make_method.h"
+#include "lmiwbem_gil.h"
+#include "lmiwbem_trace.h"
+#include "obj/lmiwbem_batch.h"
+#include "obj/lmiwbem_bulk.h"
 #include "obj/lmiwbem_connection.h"
 #include "obj/lmiwbem_nocasedict.h"
 #include "obj/cim/lmiwbem_class.h"
 #include "obj/cim/lmiwbem_class_name.h"
+#include "obj/cim/lmiwbem_constants.h"
 #include "obj/cim/lmiwbem_instance.h"
 #include "obj/cim/lmiwbem_instance_name.h"
 #include "obj/cim/lmiwbem_value.h"
 #include "util/lmiwbem_convert.h"
 #include "util/lmiwbem_util.h"
+#include "util/lmiwbem_wql.h"
 
 namespace bp = boost::python;
 
-WBEMConnection::ScopedConnection::ScopedConnection(WBEMConnection *conn)
+namespace {
+
+// Single step of association traversal; see TraverseAssociatorNames().
+struct AssociationHop
+{
+    Pegasus::CIMName assoc_class;
+    Pegasus::CIMName result_class;
+    String role;
+    String result_role;
+};
+
+void setPropertyUsageTracker(
+    const bp::object &instances,
+    const PropertyUsageTrackerPtr &tracker)
+{
+    const int cnt = bp::len(instances);
+    for (int i = 0; i < cnt; ++i)
+        CIMInstance::asNative(instances[i]).setPropertyUsageTracker(tracker);
+}
+
+// GetInstance of a single instance; see GetInstances().
+class GetInstanceTask: public BulkTask
+{
+public:
+    GetInstanceTask()
+        : BulkTask()
+        , ns()
+        , path()
+        , local_only(true)
+        , include_qualifiers(false)
+        , include_class_origin(false)
+        , property_list()
+        , instance()
+    {
+    }
+
+    virtual void run(CIMClient &client)
+    {
+        instance = client.getInstance(
+            ns,
+            path,
+            local_only,
+            include_qualifiers,
+            include_class_origin,
+            property_list);
+
+        // CIMClient::getInstance() does not set the CIMObjectPath member in
+        // CIMInstance. We need to do that manually.
+        instance.setPath(path);
+    }
+
+    Pegasus::CIMNamespaceName ns;
+    Pegasus::CIMObjectPath path;
+    bool local_only;
+    bool include_qualifiers;
+    bool include_class_origin;
+    Pegasus::CIMPropertyList property_list;
+    Pegasus::CIMInstance instance;
+};
+
+// Creates Pegasus::Array of method parameters from **kwargs.
+Pegasus::Array<Pegasus::CIMParamValue> asPegasusParamValues(const bp::dict &params)
+{
+    Pegasus::Array<Pegasus::CIMParamValue> peg_params;
+    bp::list py_keys = params.keys();
+    const int keys_cnt = bp::len(py_keys);
+    for (int i = 0; i < keys_cnt; ++i) {
+        String c_param_name = StringConv::asString(py_keys[i]);
+        peg_params.append(
+            Pegasus::CIMParamValue(
+                c_param_name,
+                CIMValue::asPegasusCIMValue(params[py_keys[i]]),
+                true /* isTyped */));
+    }
+
+    return peg_params;
+}
+
+// Creates tuple containing method's return value and NocaseDict of its
+// output parameters.
+bp::object asPyMethodResult(
+    const Pegasus::CIMValue &rval,
+    const Pegasus::Array<Pegasus::CIMParamValue> &out_params)
+{
+    bp::object py_rparams = NocaseDict::create();
+    const Pegasus::Uint32 cnt = out_params.size();
+    for (Pegasus::Uint32 i = 0; i < cnt; ++i) {
+        py_rparams[bp::object(out_params[i].getParameterName())] =
+            CIMValue::asLMIWbemCIMValue(out_params[i].getValue());
+    }
+
+    return bp::make_tuple(
+        CIMValue::asLMIWbemCIMValue(rval),
+        py_rparams);
+}
+
+// InvokeMethod of a single method; see InvokeMethods().
+class InvokeMethodTask: public BulkTask
+{
+public:
+    InvokeMethodTask()
+        : BulkTask()
+        , ns()
+        , path()
+        , method()
+        , in_params()
+        , rval()
+        , out_params()
+    {
+    }
+
+    virtual void run(CIMClient &client)
+    {
+        rval = client.invokeMethod(
+            ns,
+            path,
+            method,
+            in_params,
+            out_params);
+    }
+
+    // The CIMOM may have executed the method already.
+    virtual bool isIdempotent() const
+    {
+        return false;
+    }
+
+    Pegasus::CIMNamespaceName ns;
+    Pegasus::CIMObjectPath path;
+    Pegasus::CIMName method;
+    Pegasus::Array<Pegasus::CIMParamValue> in_params;
+    Pegasus::CIMValue rval;
+    Pegasus::Array<Pegasus::CIMParamValue> out_params;
+};
+
+// AssociatorNames of a single graph node; see TraverseAssociatorNames().
+class AssociatorNamesTask: public BulkTask
+{
+public:
+    AssociatorNamesTask()
+        : BulkTask()
+        , hop(NULL)
+        , path()
+        , associator_names()
+    {
+    }
+
+    virtual void run(CIMClient &client)
+    {
+        associator_names = client.associatorNames(
+            path.getNameSpace(),
+            path,
+            hop->assoc_class,
+            hop->result_class,
+            hop->role,
+            hop->result_role);
+    }
+
+    const AssociationHop *hop;
+    Pegasus::CIMObjectPath path;
+    Pegasus::Array<Pegasus::CIMObjectPath> associator_names;
+};
+
+// Call from a catch block. Returns true, if the exception was not reported
+// by the CIMOM, but by the connection.
+bool isConnectionError()
+{
+    try {
+        throw;
+    } catch (const Pegasus::CIMException &) {
+        return false;
+    } catch (const Pegasus::CIMClientHTTPErrorException &) {
+        return false;
+    } catch (const Pegasus::Exception &) {
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bp::object asPyClassNameList(const std::vector<String> &classnames)
+{
+    bp::list py_classnames;
+    std::vector<String>::const_iterator it;
+    for (it = classnames.begin(); it != classnames.end(); ++it)
+        py_classnames.append(StringConv::asPyUnicode(*it));
+    return py_classnames;
+}
+
+} // unnamed namespace
+
+WBEMConnection::ScopedConnection::ScopedConnection(
+    WBEMConnection *conn,
+    bool idempotent)
     : m_conn(conn)
     , m_conn_orig_state(m_conn->m_client.isConnected())
+    , m_idempotent(idempotent)
+    , m_reused(false)
+    , m_succeeded(false)
 {
+    if (m_conn_orig_state && m_conn->m_connected_tmp &&
+        time(NULL) - m_conn->m_last_used >= static_cast<time_t>(m_conn->m_keep_alive))
+    {
+        // Kept alive connection was idle for too long; the server may have
+        // closed it already. Reconnect.
+        m_conn->m_client.disconnect();
+        m_conn->m_connected_tmp = false;
+        m_conn_orig_state = false;
+    }
+
     if (m_conn_orig_state) {
         // We are already connected, nothing to do here.
+        m_reused = m_conn->m_connected_tmp;
+        return;
+    }
+
+    connect();
+}
+
+WBEMConnection::ScopedConnection::~ScopedConnection()
+{
+    if (!m_succeeded) {
+        // Don't keep connection established by us after failure. Explicitly
+        // established connection is left to the user.
+        if (!m_conn_orig_state || m_conn->m_connected_tmp) {
+            if (m_conn->m_client.isConnected())
+                m_conn->m_client.disconnect();
+            m_conn->m_connected_tmp = false;
+        }
+        return;
+    }
+
+    if (m_conn_orig_state && !m_conn->m_connected_tmp)
         return;
-    } else if (m_conn->m_connect_locally) {
+
+    if (m_conn->m_keep_alive > 0 && !m_conn->m_connect_locally) {
+        m_conn->m_connected_tmp = true;
+        m_conn->m_last_used = time(NULL);
+    } else {
+        m_conn->m_client.disconnect();
+        m_conn->m_connected_tmp = false;
+    }
+}
+
+void WBEMConnection::ScopedConnection::succeed()
+{
+    m_succeeded = true;
+}
+
+bool WBEMConnection::ScopedConnection::succeeded() const
+{
+    return m_succeeded;
+}
+
+bool WBEMConnection::ScopedConnection::retry()
+{
+    if (!m_reused)
+        return false;
+
+    try {
+        throw;
+    } catch (const Pegasus::CIMException &) {
+        // Error reported by the CIMOM; the connection works.
+        return false;
+    } catch (const Pegasus::CIMClientHTTPErrorException &) {
+        return false;
+    } catch (const Pegasus::ConnectionTimeoutException &) {
+        // The CIMOM may still be processing the request.
+        return false;
+    } catch (const Pegasus::NotConnectedException &) {
+        // The request was not sent; retry below.
+    } catch (const Pegasus::Exception &) {
+        // Broken connection; the CIMOM may have executed the request.
+        if (!m_idempotent)
+            return false;
+    } catch (...) {
+        return false;
+    }
+
+    // Retry only once, over a new connection.
+    m_reused = false;
+    m_conn->m_client.disconnect();
+    m_conn->m_connected_tmp = false;
+    m_conn_orig_state = false;
+    connect();
+    return true;
+}
+
+void WBEMConnection::ScopedConnection::connect()
+{
+    if (m_conn->m_connect_locally) {
         m_conn->m_client.connectLocally();
         return;
     } else if (m_conn->m_url.empty()) {
@@ -82,15 +377,144 @@ WBEMConnection::ScopedConnection::ScopedConnection(WBEMConnection *conn)
     }
 }
 
-WBEMConnection::ScopedConnection::~ScopedConnection()
+WBEMConnection::OperationTimer::OperationTimer(
+    WBEMConnection *conn,
+    const char *operation)
+    : m_conn(conn)
+    , m_prev(conn->m_op_timer)
+    , m_operation(operation)
+    , m_stopwatch()
+    , m_phase(OperationStats::PHASE_CONVERSION)
+    , m_durations()
+    , m_measured()
+    , m_classname()
+    , m_namespace()
+    , m_object_count(0)
+    , m_response_size(0)
 {
-    if (!m_conn_orig_state)
-        m_conn->m_client.disconnect();
+    m_conn->m_op_timer = this;
+    if (m_conn->m_slow_log.isEnabled())
+        m_response_size = m_conn->m_perf_data.getResponseSize();
+}
+
+WBEMConnection::OperationTimer::~OperationTimer()
+{
+    enter(m_phase);
+
+    m_conn->m_op_stats.record(m_operation, m_durations, m_measured);
+    OperationStats::global().record(m_operation, m_durations, m_measured);
+    m_conn->m_op_timer = m_prev;
+
+    if (m_conn->m_slow_log.isEnabled())
+        logSlowOperation();
+}
+
+const char *WBEMConnection::OperationTimer::operation() const
+{
+    return m_operation;
+}
+
+void WBEMConnection::OperationTimer::setTarget(
+    const String &ns,
+    const String &classname)
+{
+    m_namespace = ns;
+    m_classname = classname;
+}
+
+void WBEMConnection::OperationTimer::setObjectCount(Pegasus::Uint64 count)
+{
+    m_object_count = count;
+}
+
+void WBEMConnection::OperationTimer::logSlowOperation()
+{
+    Pegasus::Uint64 duration = 0;
+    for (int i = 0; i < OperationStats::PHASES; ++i)
+        duration += m_durations[i];
+    if (duration < m_conn->m_slow_log.getThreshold())
+        return;
+
+    SlowOperationLog::Record record;
+    record.operation = m_operation;
+    record.classname = m_classname;
+    record.ns = m_namespace;
+    record.hostname = m_conn->m_client.hostname();
+    record.timestamp = time(NULL);
+    record.duration = duration;
+    for (int i = 0; i < OperationStats::PHASES; ++i)
+        record.phases[i] = m_durations[i];
+    record.object_count = m_object_count;
+    record.response_size =
+        m_conn->m_perf_data.getResponseSize() - m_response_size;
+
+    m_conn->m_slow_log.append(record);
+}
+
+void WBEMConnection::OperationTimer::enter(OperationStats::Phase phase)
+{
+    m_durations[m_phase] += m_stopwatch.elapsedUs();
+    m_measured[m_phase] = true;
+    m_phase = phase;
+    m_stopwatch.restart();
 }
 
 WBEMConnection::ScopedTransaction::ScopedTransaction(WBEMConnection *conn)
-    : m_sct(conn->m_client)
+    : m_conn(enterPhase(conn, OperationStats::PHASE_MUTEX_WAIT))
+    , m_perf_callbacks(conn->m_perf_data)
+    , m_sct(conn->m_client)
+{
+    enterPhase(m_conn, OperationStats::PHASE_CALL);
+    LMIWBEM_TRACE1(operation_begin, operationName());
+}
+
+WBEMConnection::ScopedTransaction::~ScopedTransaction()
+{
+    LMIWBEM_TRACE2(operation_end,
+        operationName(),
+        m_conn->m_perf_data.getClassname().c_str());
+
+    m_conn->m_perf_data.setClassname(String());
+    enterPhase(m_conn, OperationStats::PHASE_CONSTRUCTION);
+}
+
+const char *WBEMConnection::ScopedTransaction::operationName() const
 {
+    return m_conn->m_op_timer ? m_conn->m_op_timer->operation() : "";
+}
+
+WBEMConnection *WBEMConnection::ScopedTransaction::enterPhase(
+    WBEMConnection *conn,
+    OperationStats::Phase phase)
+{
+    if (conn->m_op_timer)
+        conn->m_op_timer->enter(phase);
+    return conn;
+}
+
+WBEMConnection::PropertyRefetcher::PropertyRefetcher(WBEMConnection *conn)
+    : m_conn(conn)
+{
+}
+
+Pegasus::Array<Pegasus::CIMInstance>
+WBEMConnection::PropertyRefetcher::fetchInstances(
+    const InstanceRequest &request)
+{
+    return m_conn->refetchInstances(request);
+}
+
+Pegasus::CIMInstance WBEMConnection::PropertyRefetcher::fetchInstance(
+    const Pegasus::CIMObjectPath &path,
+    const bool local_only,
+    const bool include_qualifiers,
+    const bool include_class_origin)
+{
+    return m_conn->refetchInstance(
+        path,
+        local_only,
+        include_qualifiers,
+        include_class_origin);
 }
 
 WBEMConnection::WBEMConnection(
@@ -102,6 +526,8 @@ WBEMConnection::WBEMConnection(
     const bp::object &connect_locally)
     : m_connected_tmp(false)
     , m_connect_locally(false)
+    , m_keep_alive(0)
+    , m_last_used(0)
     , m_url()
     , m_username()
     , m_password()
@@ -109,7 +535,17 @@ WBEMConnection::WBEMConnection(
     , m_key_file()
     , m_default_namespace(Config::defaultNamespace())
     , m_client()
+    , m_adaptive_property_list(false)
+    , m_property_usage()
+    , m_instance_fetcher(new PropertyRefetcher(this))
+    , m_class_hierarchy()
+    , m_perf_data()
+    , m_op_timer(NULL)
+    , m_op_stats()
+    , m_slow_log()
 {
+    m_client.registerClientOpPerformanceDataHandler(m_perf_data);
+
     m_connect_locally = Conv::as<bool>(connect_locally, "connect_locally");
 
     // We are constructing with local connection flag; disregard other
@@ -152,6 +588,7 @@ WBEMConnection::WBEMConnection(
 WBEMConnection::~WBEMConnection()
 {
     m_client.disconnect();
+    m_client.deregisterClientOpPerformanceDataHandler();
 }
 
 void WBEMConnection::init_type()
@@ -259,6 +696,113 @@ void WBEMConnection::init_type_base(WBEMConnection::WBEMConnectionClass &cls)
         &WBEMConnection::setCredentials,
         "Property storing user credentials.\n\n"
         ":rtype: tuple containing username and password")
+    .add_property("adaptive_property_list",
+        &WBEMConnection::getAdaptivePropertyList,
+        &WBEMConnection::setAdaptivePropertyList,
+        "Property storing adaptive PropertyList flag. If set to True,\n"
+        "EnumerateInstances, GetInstance and Associators called without\n"
+        "PropertyList record, which properties of returned instances are\n"
+        "read. Subsequent calls from the same place of a script request only\n"
+        "those properties. If a property, which was not requested, is accessed,\n"
+        "the operation is run once more without PropertyList and all its\n"
+        "instances get the missing properties. Errors of the repeated\n"
+        "operation are raised on the property access.\n"
+        "Setting the flag to False forgets all the recorded properties. Default\n"
+        "value is False.\n\n"
+        ":rtype: bool")
+    .add_property("keep_alive",
+        &WBEMConnection::getKeepAlive,
+        &WBEMConnection::setKeepAlive,
+        "Property storing idle timeout in seconds of automatically\n"
+        "established connections. If the connection was not explicitly\n"
+        "connected, CIM operations connect to the CIMOM and, if the timeout\n"
+        "is non-zero, the connection is kept open for subsequent operations\n"
+        "instead of disconnecting after each of them. Connection idle for\n"
+        "longer than the timeout or after a failed operation is\n"
+        "re-established. If an operation fails on a kept alive connection due\n"
+        "to connection error, it is retried once over a new connection.\n"
+        "Operations modifying the CIMOM's state (CreateInstance,\n"
+        "ModifyInstance, DeleteInstance, InvokeMethod, pulls) are retried\n"
+        "only, if the request was not sent.\n"
+        "Default value is 0.\n\n"
+        ":rtype: int")
+    .add_property("performance_data_callback",
+        &WBEMConnection::getPerformanceDataCallback,
+        &WBEMConnection::setPerformanceDataCallback,
+        "Property storing callable, which is called after every CIM operation\n"
+        "with a dictionary containing keys ``operation``, ``classname``,\n"
+        "``round_trip_time``, ``server_time``, ``request_size`` and\n"
+        "``response_size``; see :py:meth:`performance_data`. Default value\n"
+        "is None.\n\n"
+        ":rtype: callable")
+    .def("performance_data", &WBEMConnection::getPerformanceData,
+        "performance_data()\n\n"
+        "Returns performance data reported by the client for CIM operations\n"
+        "performed so far. Times are in microseconds, sizes in bytes. Server\n"
+        "time is known only, if the CIMOM reports it; server_time_count is the\n"
+        "number of such operations. Comparing server time with round trip time\n"
+        "tells, whether the time was spent in the CIMOM or in the network and\n"
+        "the client.\n\n"
+        ":returns: dictionary keyed by (operation, class name) tuples; values\n"
+        "\tare dictionaries with keys ``count``, ``round_trip_time``,\n"
+        "\t``round_trip_time_min``, ``round_trip_time_max``,\n"
+        "\t``server_time_count``, ``server_time``, ``server_time_max``,\n"
+        "\t``request_size`` and ``response_size``\n"
+        ":rtype: dict")
+    .def("reset_performance_data", &WBEMConnection::resetPerformanceData,
+        "reset_performance_data()\n\n"
+        "Forgets performance data collected so far.")
+    .def("stats", &WBEMConnection::getStats,
+        "stats()\n\n"
+        "Returns histograms of durations of phases of CIM operations performed\n"
+        "by this connection: ``conversion`` of arguments, ``mutex_wait`` for\n"
+        "the client, Pegasus ``call`` and ``construction`` of returned\n"
+        "objects. Durations are in microseconds; bucket upper bounds are\n"
+        "powers of two. Process-wide aggregate is returned by\n"
+        ":py:func:`lmiwbem.operation_stats`.\n\n"
+        ":returns: dictionary keyed by operation names; values are\n"
+        "\tdictionaries keyed by phase names with values being dictionaries\n"
+        "\twith keys ``count``, ``total_us``, ``max_us`` and ``buckets``\n"
+        ":rtype: dict")
+    .def("reset_stats", &WBEMConnection::resetStats,
+        "reset_stats()\n\n"
+        "Forgets operation phase histograms collected so far.")
+    .add_property("slow_operation_threshold",
+        &WBEMConnection::getSlowOperationThreshold,
+        &WBEMConnection::setSlowOperationThreshold,
+        "Property storing duration in milliseconds, above which CIM operations\n"
+        "are recorded in the slow operation log; see\n"
+        ":py:meth:`slow_operations`. Value 0 disables the log. Default value\n"
+        "is 0.\n\n"
+        ":rtype: float")
+    .add_property("slow_operation_log_size",
+        &WBEMConnection::getSlowOperationLogSize,
+        &WBEMConnection::setSlowOperationLogSize,
+        "Property storing maximum number of records in the slow operation log;\n"
+        "the oldest records are dropped. Default value is 100.\n\n"
+        ":rtype: int")
+    .add_property("slow_operation_callback",
+        &WBEMConnection::getSlowOperationCallback,
+        &WBEMConnection::setSlowOperationCallback,
+        "Property storing callable, which is called with a record of every\n"
+        "slow operation; see :py:meth:`slow_operations`. Default value is\n"
+        "None.\n\n"
+        ":rtype: callable")
+    .def("slow_operations", &WBEMConnection::getSlowOperations,
+        "slow_operations()\n\n"
+        "Returns CIM operations, which took longer than\n"
+        ":py:attr:`slow_operation_threshold`, oldest first. Failed operations\n"
+        "are recorded too. Durations are in microseconds, sizes in bytes.\n\n"
+        ":returns: list of dictionaries with keys ``operation``,\n"
+        "\t``classname``, ``namespace``, ``hostname``, ``time`` (seconds\n"
+        "\tsince the epoch), ``duration``, ``phases`` (dictionary keyed by\n"
+        "\tphase names; see :py:meth:`stats`), ``object_count`` (number of\n"
+        "\treturned objects of enumeration operations) and\n"
+        "\t``response_size``\n"
+        ":rtype: list")
+    .def("clear_slow_operations", &WBEMConnection::clearSlowOperations,
+        "clear_slow_operations()\n\n"
+        "Removes all records from the slow operation log.")
     .def("CreateInstance", &WBEMConnection::createInstance,
         (bp::arg("NewInstance"),
          bp::arg("ns") = None),
@@ -304,10 +848,11 @@ void WBEMConnection::init_type_base(WBEMConnection::WBEMConnectionClass &cls)
          bp::arg("DeepInheritance") = true,
          bp::arg("IncludeQualifiers") = false,
          bp::arg("IncludeClassOrigin") = false,
-         bp::arg("PropertyList") = None),
+         bp::arg("PropertyList") = None,
+         bp::arg("ClientQuery") = None),
         "EnumerateInstances(ClassName, namespace=None, LocalOnly=True, "
         "DeepInheritance=True, IncludeQualifiers=False, IncludeClassOrigin=False, "
-        "PropertyList=None)\n\n"
+        "PropertyList=None, ClientQuery=None)\n\n"
         "Enumerates instances of a given class name.\n\n"
         ":param str ClassName: String containing class name of instances to be\n"
         "\tretrieved.\n"
@@ -332,6 +877,13 @@ void WBEMConnection::init_type_base(WBEMConnection::WBEMConnectionClass &cls)
         "\tincluded in the response. If the PropertyList input parameter is an empty\n"
         "\tlist, no properties are included in the response. If the PropertyList input\n"
         "\tparameter is None, no additional filtering is defined. Default value is None.\n"
+        ":param str ClientQuery: if not None, WQL query which is evaluated by the\n"
+        "\tclient against the retrieved instances. Only matching instances are\n"
+        "\treturned and only the selected properties are present in them. Supported\n"
+        "\tis ``SELECT * | prop[, prop ...] FROM class [WHERE condition]``, where the\n"
+        "\tcondition can contain comparison of a property with a literal, ``IS [NOT]\n"
+        "\tNULL``, ``AND``, ``OR``, ``NOT`` and parentheses. Class name in ``FROM``\n"
+        "\tclause is not checked. Default value is None.\n"
         ":returns: List of :py:class:`.CIMInstance` objects\n"
         ":raises: :py:exc:`.CIMError`, :py:exc:`.ConnectionError`\n\n"
         "**Example:** :ref:`example_enumerate_instances`")
@@ -384,6 +936,36 @@ void WBEMConnection::init_type_base(WBEMConnection::WBEMConnectionClass &cls)
         ":returns: :py:class:`.CIMInstance` object\n"
         ":raises: :py:exc:`.CIMError`, :py:exc:`.ConnectionError`\n\n"
         "**Example:** :ref:`example_get_instance`")
+    .def("GetInstances",
+        &WBEMConnection::getInstances,
+        (bp::arg("InstanceNames"),
+         bp::arg("namespace") = None,
+         bp::arg("LocalOnly") = true,
+         bp::arg("IncludeQualifiers") = false,
+         bp::arg("IncludeClassOrigin") = false,
+         bp::arg("PropertyList") = None,
+         bp::arg("Concurrency") = 4),
+        "GetInstances(InstanceNames, namespace=None, LocalOnly=True, "
+        "IncludeQualifiers=False, IncludeClassOrigin=False, PropertyList=None, "
+        "Concurrency=4)\n\n"
+        "Fetches a list of :py:class:`.CIMInstance` objects. The GetInstance\n"
+        "operations run over up to Concurrency parallel connections to the\n"
+        "CIMOM with the GIL released. An error of a single operation doesn't\n"
+        "abort the others; the :py:exc:`.CIMError` or :py:exc:`.ConnectionError`\n"
+        "object is returned in place of the instance instead.\n\n"
+        ":param list InstanceNames: list of :py:class:`.CIMInstanceName` objects\n"
+        ":param str namespace: string containing namespace, from which the\n"
+        "\tinstances should be retrieved. If None, namespace of each instance\n"
+        "\tname or default namespace is used. Default value is None.\n"
+        ":param bool LocalOnly: see :py:meth:`GetInstance`\n"
+        ":param bool IncludeQualifiers: see :py:meth:`GetInstance`\n"
+        ":param bool IncludeClassOrigin: see :py:meth:`GetInstance`\n"
+        ":param list PropertyList: see :py:meth:`GetInstance`\n"
+        ":param int Concurrency: maximum number of parallel connections.\n"
+        "\tDefault value is 4.\n"
+        ":returns: list of :py:class:`.CIMInstance` objects or errors in the\n"
+        "\torder of InstanceNames\n"
+        ":raises: :py:exc:`.ValueError`")
     .def("EnumerateClasses", &WBEMConnection::enumerateClasses,
         (bp::arg("namespace") = None,
          bp::arg("ClassName") = None,
@@ -464,6 +1046,25 @@ void WBEMConnection::init_type_base(WBEMConnection::WBEMConnectionClass &cls)
         ":returns: tuple containing method's return value and output parameters\n"
         ":raises: :py:exc:`.CIMError`, :py:exc:`.ConnectionError`\n\n"
         "**Example:** :ref:`example_invoke_method`")
+    .def("InvokeMethods",
+        &WBEMConnection::invokeMethods,
+        (bp::arg("Calls"),
+         bp::arg("Concurrency") = 4),
+        "InvokeMethods(Calls, Concurrency=4)\n\n"
+        "Executes multiple methods. Parameters of all the calls are converted\n"
+        "first, then the calls run over up to Concurrency parallel connections\n"
+        "to the CIMOM with the GIL released. An error of a single call doesn't\n"
+        "abort the others; the :py:exc:`.CIMError` or :py:exc:`.ConnectionError`\n"
+        "object is returned in place of its result instead.\n\n"
+        ":param list Calls: list of (ObjectName, MethodName, params) tuples,\n"
+        "\twhere ObjectName is :py:class:`.CIMInstanceName`, MethodName is\n"
+        "\tstring containing method name and params is dictionary of\n"
+        "\tparameters passed to the method or None\n"
+        ":param int Concurrency: maximum number of parallel connections.\n"
+        "\tDefault value is 4.\n"
+        ":returns: list of tuples containing method's return value and output\n"
+        "\tparameters or errors in the order of Calls\n"
+        ":raises: :py:exc:`.ValueError`")
     .def("GetClass", &WBEMConnection::getClass,
         (bp::arg("ClassName"),
          bp::arg("namespace") = None,
@@ -647,7 +1248,108 @@ void WBEMConnection::init_type_base(WBEMConnection::WBEMConnectionClass &cls)
         ":returns: list of association :py:class:`.CIMInstanceName` objects with an input\n"
         "\tinstance\n"
         ":raises: :py:exc:`.CIMError`, :py:exc:`.ConnectionError`\n\n"
-        "**Example:** :ref:`example_reference_names`");
+        "**Example:** :ref:`example_reference_names`")
+    .def("TraverseAssociatorNames", &WBEMConnection::traverseAssociatorNames,
+        (bp::arg("ObjectNames"),
+         bp::arg("Hops"),
+         bp::arg("Depth") = None,
+         bp::arg("Concurrency") = 4),
+        "TraverseAssociatorNames(ObjectNames, Hops, Depth=None, Concurrency=4)\n\n"
+        "Walks association graph breadth-first starting from input instance names\n"
+        "and returns all the reached :py:class:`.CIMInstanceName` objects together\n"
+        "with the associations between them. Nodes of each level of the graph are\n"
+        "expanded by AssociatorNames operations issued concurrently over up to\n"
+        "Concurrency parallel connections, as in :py:meth:`GetInstances`. Instance\n"
+        "names are deduplicated natively, before any Python object is created.\n\n"
+        ":param ObjectNames: :py:class:`.CIMInstanceName` or list of them specifying\n"
+        "\tthe starting CIM objects.\n"
+        ":param list Hops: list of dictionaries, one per traversal level. Each\n"
+        "\tdictionary may contain keys ``AssocClass``, ``ResultClass``, ``Role`` and\n"
+        "\t``ResultRole`` with the same meaning as for :py:meth:`AssociatorNames`.\n"
+        "\tIf there are more levels than hops, the last hop is used for the remaining\n"
+        "\tlevels.\n"
+        ":param int Depth: number of levels to traverse. If None, the length of Hops\n"
+        "\tis used. Default value is None.\n"
+        ":param int Concurrency: maximum number of parallel connections. Default\n"
+        "\tvalue is 4.\n"
+        ":returns: tuple containing list of unique :py:class:`.CIMInstanceName`\n"
+        "\tobjects (nodes) and list of tuples of source and associated\n"
+        "\t:py:class:`.CIMInstanceName` objects (edges)\n"
+        ":raises: :py:exc:`.CIMError`, :py:exc:`.ConnectionError`\n\n"
+        "**Example:** :ref:`example_traverse_associator_names`")
+    .def("RefreshClassHierarchy", &WBEMConnection::refreshClassHierarchy,
+        (bp::arg("namespace") = None),
+        "RefreshClassHierarchy(namespace=None)\n\n"
+        "Retrieves class hierarchy of a namespace by a single deep\n"
+        "EnumerateClasses operation and replaces the previously retrieved one.\n"
+        "The hierarchy is used by :py:meth:`IsSubclass`,\n"
+        ":py:meth:`GetClassAncestors`, :py:meth:`GetClassDescendants`,\n"
+        ":py:meth:`GetCommonSuperclass` and :py:func:`.is_subclass`, which then\n"
+        "answer without any further CIM operation. Call this method, when the\n"
+        "schema of the namespace changes.\n\n"
+        ":param str namespace: string containing namespace. If None, default\n"
+        "\tnamespace is used. Default value is None.\n"
+        ":raises: :py:exc:`.CIMError`, :py:exc:`.ConnectionError`")
+    .def("IsSubclass", &WBEMConnection::isSubclass,
+        (bp::arg("SuperClass"),
+         bp::arg("SubClass"),
+         bp::arg("namespace") = None),
+        "IsSubclass(SuperClass, SubClass, namespace=None)\n\n"
+        "Checks, if a class is a subclass of another one. Class names are\n"
+        "matched case insensitively. Class hierarchy of the namespace is\n"
+        "retrieved on the first call; see :py:meth:`RefreshClassHierarchy`.\n\n"
+        ":param str SuperClass: string containing super class name\n"
+        ":param SubClass: string containing class name or :py:class:`.CIMClass`\n"
+        ":param str namespace: string containing namespace. If None, default\n"
+        "\tnamespace is used. Default value is None.\n"
+        ":returns: True, if SubClass is SuperClass or derives from it; False\n"
+        "\totherwise, also if any of the classes is not present in the namespace\n"
+        ":rtype: bool\n"
+        ":raises: :py:exc:`.CIMError`, :py:exc:`.ConnectionError`")
+    .def("GetClassAncestors", &WBEMConnection::getClassAncestors,
+        (bp::arg("ClassName"),
+         bp::arg("namespace") = None),
+        "GetClassAncestors(ClassName, namespace=None)\n\n"
+        "Returns super classes of a class. Class hierarchy of the namespace\n"
+        "is retrieved on the first call; see :py:meth:`RefreshClassHierarchy`.\n\n"
+        ":param str ClassName: string containing class name\n"
+        ":param str namespace: string containing namespace. If None, default\n"
+        "\tnamespace is used. Default value is None.\n"
+        ":returns: list of class names ordered from the direct super class up\n"
+        "\tto the root class\n"
+        ":raises: :py:exc:`.CIMError`, :py:exc:`.ConnectionError`")
+    .def("GetClassDescendants", &WBEMConnection::getClassDescendants,
+        (bp::arg("ClassName"),
+         bp::arg("namespace") = None,
+         bp::arg("DeepInheritance") = true),
+        "GetClassDescendants(ClassName, namespace=None, DeepInheritance=True)\n\n"
+        "Returns subclasses of a class. Class hierarchy of the namespace is\n"
+        "retrieved on the first call; see :py:meth:`RefreshClassHierarchy`.\n\n"
+        ":param str ClassName: string containing class name\n"
+        ":param str namespace: string containing namespace. If None, default\n"
+        "\tnamespace is used. Default value is None.\n"
+        ":param bool DeepInheritance: if True, all the subclasses are returned;\n"
+        "\totherwise only direct subclasses. Default value is True.\n"
+        ":returns: list of class names\n"
+        ":raises: :py:exc:`.CIMError`, :py:exc:`.ConnectionError`")
+    .def("GetCommonSuperclass", &WBEMConnection::getCommonSuperclass,
+        (bp::arg("ClassNames"),
+         bp::arg("namespace") = None),
+        "GetCommonSuperclass(ClassNames, namespace=None)\n\n"
+        "Returns the most derived class, which all the classes are derived\n"
+        "from or equal to. Class hierarchy of the namespace is retrieved on the\n"
+        "first call; see :py:meth:`RefreshClassHierarchy`.\n\n"
+        ":param list ClassNames: list of strings containing class names\n"
+        ":param str namespace: string containing namespace. If None, default\n"
+        "\tnamespace is used. Default value is None.\n"
+        ":returns: string containing class name or None, if the classes do not\n"
+        "\tshare any super class\n"
+        ":raises: :py:exc:`.CIMError`, :py:exc:`.ConnectionError`")
+    .def("batch", &WBEMConnection::batch,
+        "batch()\n\n"
+        "Creates :py:class:`.WBEMBatch`, which executes collected CIM\n"
+        "operations over a single connection.\n\n"
+        ":returns: :py:class:`.WBEMBatch` object");
 }
 
 String WBEMConnection::repr() const
@@ -709,6 +1411,7 @@ void WBEMConnection::connect(
             c_key_file,
             Config::defaultTrustStore());
         m_connect_locally = false;
+        m_connected_tmp = false;
     } catch (...) {
         std::stringstream ss;
         if (Config::isVerbose()) {
@@ -725,6 +1428,7 @@ void WBEMConnection::connectLocally() try
 {
     m_client.connectLocally();
     m_connect_locally = true;
+    m_connected_tmp = false;
 } catch (...) {
     std::stringstream ss;
     if (Config::isVerbose())
@@ -732,9 +1436,28 @@ void WBEMConnection::connectLocally() try
     handle_all_exceptions(ss);
 }
 
+void WBEMConnection::connectNative(const String &trust_store)
+{
+    m_client.connect(
+        m_url,
+        m_username,
+        m_password,
+        m_cert_file,
+        m_key_file,
+        trust_store);
+    m_connect_locally = false;
+    m_connected_tmp = false;
+}
+
+String WBEMConnection::getURL() const
+{
+    return m_url;
+}
+
 void WBEMConnection::disconnect()
 {
     m_client.disconnect();
+    m_connected_tmp = false;
 }
 
 bool WBEMConnection::isConnected() const
@@ -838,10 +1561,132 @@ void WBEMConnection::setCredentials(const bp::object &creds)
     m_password = StringConv::asString(py_creds_tpl[1], "password");
 }
 
+bool WBEMConnection::getAdaptivePropertyList() const
+{
+    return m_adaptive_property_list;
+}
+
+void WBEMConnection::setAdaptivePropertyList(bool adaptive)
+{
+    m_adaptive_property_list = adaptive;
+    if (!m_adaptive_property_list)
+        m_property_usage.clear();
+}
+
+unsigned int WBEMConnection::getKeepAlive() const
+{
+    return m_keep_alive;
+}
+
+void WBEMConnection::setKeepAlive(unsigned int keep_alive)
+{
+    m_keep_alive = keep_alive;
+
+    // Close kept alive connection, which is not wanted anymore.
+    if (m_keep_alive == 0 && m_connected_tmp)
+        disconnect();
+}
+
+bp::object WBEMConnection::getPerformanceDataCallback()
+{
+    return m_perf_data.getCallback();
+}
+
+void WBEMConnection::setPerformanceDataCallback(const bp::object &callback)
+{
+    m_perf_data.setCallback(callback);
+}
+
+bp::object WBEMConnection::getPerformanceData()
+{
+    const ClientPerformanceData::stats_map_t stats(m_perf_data.getStats());
+
+    bp::dict py_perf_data;
+    ClientPerformanceData::stats_map_t::const_iterator it;
+    for (it = stats.begin(); it != stats.end(); ++it) {
+        const ClientPerformanceData::Stats &op_stats = it->second;
+        bp::dict py_stats;
+        py_stats["count"] = op_stats.count;
+        py_stats["round_trip_time"] = op_stats.round_trip_time;
+        py_stats["round_trip_time_min"] = op_stats.round_trip_time_min;
+        py_stats["round_trip_time_max"] = op_stats.round_trip_time_max;
+        py_stats["server_time_count"] = op_stats.server_time_count;
+        py_stats["server_time"] = op_stats.server_time;
+        py_stats["server_time_max"] = op_stats.server_time_max;
+        py_stats["request_size"] = op_stats.request_size;
+        py_stats["response_size"] = op_stats.response_size;
+
+        py_perf_data[bp::make_tuple(
+            StringConv::asPyUnicode(it->first.first),
+            StringConv::asPyUnicode(it->first.second))] = py_stats;
+    }
+
+    return py_perf_data;
+}
+
+void WBEMConnection::resetPerformanceData()
+{
+    m_perf_data.reset();
+}
+
+bp::object WBEMConnection::getStats()
+{
+    return OperationStats::asPyDict(m_op_stats.snapshot());
+}
+
+void WBEMConnection::resetStats()
+{
+    m_op_stats.reset();
+}
+
+double WBEMConnection::getSlowOperationThreshold() const
+{
+    return m_slow_log.getThreshold() / 1000.0;
+}
+
+void WBEMConnection::setSlowOperationThreshold(double threshold)
+{
+    if (threshold < 0)
+        throw_ValueError("slow_operation_threshold must not be negative");
+
+    m_slow_log.setThreshold(static_cast<Pegasus::Uint64>(threshold * 1000));
+}
+
+unsigned int WBEMConnection::getSlowOperationLogSize() const
+{
+    return m_slow_log.getSize();
+}
+
+void WBEMConnection::setSlowOperationLogSize(unsigned int size)
+{
+    m_slow_log.setSize(size);
+}
+
+bp::object WBEMConnection::getSlowOperationCallback() const
+{
+    return m_slow_log.getCallback();
+}
+
+void WBEMConnection::setSlowOperationCallback(const bp::object &callback)
+{
+    m_slow_log.setCallback(callback);
+}
+
+bp::object WBEMConnection::getSlowOperations()
+{
+    return m_slow_log.getPyRecords();
+}
+
+void WBEMConnection::clearSlowOperations()
+{
+    m_slow_log.clear();
+}
+
 bp::object WBEMConnection::createInstance(
     const bp::object &instance,
     const bp::object &ns) try
 {
+    OperationTimer timer(this, "CreateInstance");
     CIMInstance &cim_inst = CIMInstance::asNative(instance, "NewInstance");
 
     String c_ns(m_default_namespace);
@@ -860,7 +1705,10 @@ bp::object WBEMConnection::createInstance(
     Pegasus::CIMNamespaceName peg_new_inst_name_ns(c_ns);
     Pegasus::CIMInstance peg_inst = cim_inst.asPegasusCIMInstance();
 
-    ScopedTransactionBegin();
+    ScopedTransactionBeginNoRetry();
+    setOperationTarget(
+        peg_new_inst_name_ns.getString(),
+        peg_inst.getClassName().getString());
     peg_new_inst_name = m_client.createInstance(
         peg_new_inst_name_ns,
         peg_inst);
@@ -888,6 +1736,7 @@ bp::object WBEMConnection::createInstance(
 
 void WBEMConnection::deleteInstance(const bp::object &object_path) try
 {
+    OperationTimer timer(this, "DeleteInstance");
     const CIMInstanceName &cim_inst_name = CIMInstanceName::asNative(
         object_path, "InstanceName");
     Pegasus::CIMObjectPath peg_path = cim_inst_name.asPegasusCIMObjectPath();
@@ -897,7 +1746,8 @@ void WBEMConnection::deleteInstance(const bp::object &object_path) try
         c_ns = peg_path.getNameSpace().getString();
     Pegasus::CIMNamespaceName peg_ns(c_ns);
 
-    ScopedTransactionBegin()
+    ScopedTransactionBeginNoRetry()
+    setOperationTarget(peg_ns.getString(), peg_path.getClassName().getString());
     m_client.deleteInstance(
         peg_ns,
         peg_path);
@@ -918,6 +1768,7 @@ void WBEMConnection::modifyInstance(
     const bool include_qualifiers,
     const bp::object &property_list) try
 {
+    OperationTimer timer(this, "ModifyInstance");
     CIMInstance &cim_inst = CIMInstance::asNative(
         instance, "ModifiedInstance");
     CIMInstanceName &cim_inst_name = CIMInstanceName::asNative(
@@ -929,7 +1780,8 @@ void WBEMConnection::modifyInstance(
         ListConv::asPegasusPropertyList(
             property_list, "PropertyList"));
 
-    ScopedTransactionBegin();
+    ScopedTransactionBeginNoRetry();
+    setOperationTarget(peg_ns.getString(), peg_inst.getClassName().getString());
     m_client.modifyInstance(
         peg_ns,
         peg_inst,
@@ -956,13 +1808,22 @@ bp::object WBEMConnection::enumerateInstances(
     const bool deep_inheritance,
     const bool include_qualifiers,
     const bool include_class_origin,
-    const bp::object &property_list) try
+    const bp::object &property_list,
+    const bp::object &client_query) try
 {
+    OperationTimer timer(this, "EnumerateInstances");
     String c_cls(StringConv::asString(cls, "cls"));
     String c_ns(m_default_namespace);
     if (!isnone(ns))
         c_ns = StringConv::asString(ns, "namespace");
 
+    // Parse the query before the request is sent to CIMOM.
+    boost::shared_ptr<WQLQuery> wql_query;
+    if (!isnone(client_query)) {
+        wql_query.reset(new WQLQuery(
+            StringConv::asString(client_query, "ClientQuery")));
+    }
+
     Pegasus::Array<Pegasus::CIMInstance> peg_instances;
     Pegasus::CIMNamespaceName peg_ns(c_ns);
     Pegasus::CIMName peg_name(c_cls);
@@ -970,7 +1831,29 @@ bp::object WBEMConnection::enumerateInstances(
         ListConv::asPegasusPropertyList(
             property_list, "PropertyList"));
 
+    // Client query may need properties which were not read by the caller;
+    // don't restrict the PropertyList in such case.
+    PropertyUsageTrackerPtr tracker;
+    if (m_adaptive_property_list && isnone(property_list) && !wql_query) {
+        PropertyUsagePtr usage(m_property_usage.get(
+            "EnumerateInstances", c_ns, c_cls));
+        peg_property_list = usage->nextPropertyList();
+
+        InstanceRequest request(InstanceRequest::ENUMERATE_INSTANCES, peg_ns);
+        request.classname = peg_name;
+        request.deep_inheritance = deep_inheritance;
+        request.local_only = local_only;
+        request.include_qualifiers = include_qualifiers;
+        request.include_class_origin = include_class_origin;
+        tracker.reset(new PropertyUsageTracker(
+            usage,
+            m_instance_fetcher,
+            peg_property_list,
+            request));
+    }
+
     ScopedTransactionBegin();
+    setOperationTarget(peg_ns.getString(), peg_name.getString());
     peg_instances = m_client.enumerateInstances(
         peg_ns,
         peg_name,
@@ -980,9 +1863,17 @@ bp::object WBEMConnection::enumerateInstances(
         include_class_origin,
         peg_property_list);
     ScopedTransactionEnd();
+    timer.setObjectCount(peg_instances.size());
 
-    return ListConv::asPyCIMInstanceList(
-        peg_instances, c_ns, m_client.hostname());
+    if (wql_query)
+        peg_instances = wql_query->apply(peg_instances);
+
+    bp::object py_instances(ListConv::asPyCIMInstanceList(
+        peg_instances, c_ns, m_client.hostname()));
+    if (tracker)
+        setPropertyUsageTracker(py_instances, tracker);
+
+    return py_instances;
 } catch (...) {
     std::stringstream ss;
     if (Config::isVerbose()) {
@@ -1004,6 +1895,7 @@ bp::object WBEMConnection::enumerateInstanceNames(
     const bp::object &cls,
     const bp::object &ns) try
 {
+    OperationTimer timer(this, "EnumerateInstanceNames");
     String c_cls(StringConv::asString(cls, "cls"));
     String c_ns(m_default_namespace);
     if (!isnone(ns))
@@ -1014,10 +1906,12 @@ bp::object WBEMConnection::enumerateInstanceNames(
     Pegasus::CIMName peg_name(c_cls);
 
     ScopedTransactionBegin();
+    setOperationTarget(peg_ns.getString(), peg_name.getString());
     peg_instance_names = m_client.enumerateInstanceNames(
         peg_ns,
         peg_name);
     ScopedTransactionEnd();
+    timer.setObjectCount(peg_instance_names.size());
 
     return ListConv::asPyCIMInstanceNameList(
         peg_instance_names, c_ns, m_client.hostname());
@@ -1042,6 +1936,7 @@ bp::object WBEMConnection::invokeMethod(
     const bp::tuple &args,
     const bp::dict  &kwds) try
 {
+    OperationTimer timer(this, "InvokeMethod");
     if (bp::len(args) != 2)
         throw_TypeError("InvokeMethod() takes at least 2 arguments");
 
@@ -1057,24 +1952,14 @@ bp::object WBEMConnection::invokeMethod(
 
     Pegasus::CIMValue peg_rval;
     Pegasus::Array<Pegasus::CIMParamValue> peg_out_params;
-    Pegasus::Array<Pegasus::CIMParamValue> peg_in_params;
-
-    // Create Pegasus::Array from **kwargs
-    bp::list py_keys = kwds.keys();
-    const int keys_cnt = bp::len(py_keys);
-    for (int i = 0; i < keys_cnt; ++i) {
-        String c_param_name = StringConv::asString(py_keys[i]);
-        peg_in_params.append(
-            Pegasus::CIMParamValue(
-                c_param_name,
-                CIMValue::asPegasusCIMValue(kwds[py_keys[i]]),
-                true /* isTyped */));
-    }
+    Pegasus::Array<Pegasus::CIMParamValue> peg_in_params(
+        asPegasusParamValues(kwds));
 
     Pegasus::CIMNamespaceName peg_ns(c_ns);
     Pegasus::CIMName peg_name(c_method);
 
-    ScopedTransactionBegin();
+    ScopedTransactionBeginNoRetry();
+    setOperationTarget(peg_ns.getString(), peg_path.getClassName().getString());
     peg_rval = m_client.invokeMethod(
         peg_ns,
         peg_path,
@@ -1083,17 +1968,7 @@ bp::object WBEMConnection::invokeMethod(
         peg_out_params);
     ScopedTransactionEnd();
 
-    // Create a NocaseDict of method's return parameters
-    bp::object py_rparams = NocaseDict::create();
-    const Pegasus::Uint32 cnt = peg_out_params.size();
-    for (Pegasus::Uint32 i = 0; i < cnt; ++i) {
-        py_rparams[bp::object(peg_out_params[i].getParameterName())] =
-            CIMValue::asLMIWbemCIMValue(peg_out_params[i].getValue());
-    }
-
-    return bp::make_tuple(
-        CIMValue::asLMIWbemCIMValue(peg_rval),
-        py_rparams);
+    return asPyMethodResult(peg_rval, peg_out_params);
 } catch (...) {
     std::stringstream ss;
     if (Config::isVerbose()) {
@@ -1110,6 +1985,75 @@ bp::object WBEMConnection::invokeMethod(
     return None;
 }
 
+bp::object WBEMConnection::invokeMethods(
+    const bp::object &calls,
+    const bp::object &concurrency) try
+{
+    OperationTimer timer(this, "InvokeMethods");
+    bp::list py_calls(Conv::get<bp::list>(calls, "Calls"));
+    Pegasus::Uint32 c_concurrency = Conv::as<Pegasus::Uint32>(
+        concurrency, "Concurrency");
+    if (c_concurrency == 0)
+        throw_ValueError("Concurrency must be positive number");
+
+    // Connection parameters are checked here, with the GIL held.
+    BulkExecutor executor(*this, c_concurrency);
+
+    // All the parameters are marshalled here, with the GIL held.
+    const int cnt = bp::len(py_calls);
+    std::vector<InvokeMethodTask> tasks(cnt);
+    std::vector<BulkTask*> task_ptrs(cnt);
+    for (int i = 0; i < cnt; ++i) {
+        bp::tuple py_call(Conv::get<bp::tuple>(py_calls[i], "Calls[i]"));
+        const int call_len = bp::len(py_call);
+        if (call_len != 2 && call_len != 3)
+            throw_ValueError("Calls must contain (ObjectName, MethodName[, params]) tuples");
+
+        const CIMInstanceName &cim_inst_name = CIMInstanceName::asNative(
+            py_call[0], "ObjectName");
+        InvokeMethodTask &task = tasks[i];
+        task.path = cim_inst_name.asPegasusCIMObjectPath();
+        task.method = Pegasus::CIMName(
+            StringConv::asString(py_call[1], "MethodName"));
+
+        String c_ns(m_default_namespace);
+        if (!task.path.getNameSpace().isNull())
+            c_ns = task.path.getNameSpace().getString();
+        task.ns = Pegasus::CIMNamespaceName(c_ns);
+
+        if (call_len == 3 && !isnone(py_call[2])) {
+            bp::dict py_params(Conv::get<bp::dict>(py_call[2], "params"));
+            task.in_params = asPegasusParamValues(py_params);
+        }
+
+        task_ptrs[i] = &task;
+    }
+
+    timer.enter(OperationStats::PHASE_CALL);
+    {
+        ScopedGILRelease sr;
+        executor.run(task_ptrs);
+    }
+    timer.enter(OperationStats::PHASE_CONSTRUCTION);
+    timer.setObjectCount(cnt);
+
+    bp::list py_results;
+    for (int i = 0; i < cnt; ++i) {
+        if (tasks[i].error.isSet())
+            py_results.append(tasks[i].error.asPyObject());
+        else
+            py_results.append(asPyMethodResult(tasks[i].rval, tasks[i].out_params));
+    }
+
+    return py_results;
+} catch (...) {
+    std::stringstream ss;
+    if (Config::isVerbose())
+        ss << "InvokeMethods()";
+    handle_all_exceptions(ss);
+    return None;
+}
+
 bp::object WBEMConnection::getInstance(
     const bp::object &instance_name,
     const bp::object &ns,
@@ -1118,6 +2062,7 @@ bp::object WBEMConnection::getInstance(
     const bool include_class_origin,
     const bp::object &property_list) try
 {
+    OperationTimer timer(this, "GetInstance");
     CIMInstanceName &cim_instance_name = CIMInstanceName::asNative(
         instance_name, "InstanceName");
     String c_ns(m_default_namespace);
@@ -1132,7 +2077,28 @@ bp::object WBEMConnection::getInstance(
     Pegasus::CIMPropertyList peg_property_list(
         ListConv::asPegasusPropertyList(property_list, "PropertyList"));
 
+    PropertyUsageTrackerPtr tracker;
+    if (m_adaptive_property_list && isnone(property_list)) {
+        PropertyUsagePtr usage(m_property_usage.get(
+            "GetInstance", c_ns, cim_instance_name.getClassname()));
+        peg_property_list = usage->nextPropertyList();
+
+        InstanceRequest request(InstanceRequest::GET_INSTANCE, peg_ns);
+        request.path = peg_object_path;
+        request.local_only = local_only;
+        request.include_qualifiers = include_qualifiers;
+        request.include_class_origin = include_class_origin;
+        tracker.reset(new PropertyUsageTracker(
+            usage,
+            m_instance_fetcher,
+            peg_property_list,
+            request));
+    }
+
     ScopedTransactionBegin();
+    setOperationTarget(
+        peg_ns.getString(),
+        peg_object_path.getClassName().getString());
     peg_instance = m_client.getInstance(
         peg_ns,
         peg_object_path,
@@ -1146,7 +2112,11 @@ bp::object WBEMConnection::getInstance(
     // CIMInstance. We need to do that manually.
     peg_instance.setPath(peg_object_path);
 
-    return CIMInstance::create(peg_instance);
+    bp::object py_instance(CIMInstance::create(peg_instance));
+    if (tracker && !isnone(py_instance))
+        CIMInstance::asNative(py_instance).setPropertyUsageTracker(tracker);
+
+    return py_instance;
 } catch (...) {
     std::stringstream ss;
     if (Config::isVerbose()) {
@@ -1159,6 +2129,180 @@ bp::object WBEMConnection::getInstance(
     return None;
 }
 
+bp::object WBEMConnection::getInstances(
+    const bp::object &instance_names,
+    const bp::object &ns,
+    const bool local_only,
+    const bool include_qualifiers,
+    const bool include_class_origin,
+    const bp::object &property_list,
+    const bp::object &concurrency) try
+{
+    OperationTimer timer(this, "GetInstances");
+    bp::list py_instance_names(Conv::get<bp::list>(instance_names, "InstanceNames"));
+    Pegasus::Uint32 c_concurrency = Conv::as<Pegasus::Uint32>(
+        concurrency, "Concurrency");
+    if (c_concurrency == 0)
+        throw_ValueError("Concurrency must be positive number");
+
+    // Connection parameters are checked here, with the GIL held.
+    BulkExecutor executor(*this, c_concurrency);
+
+    Pegasus::CIMPropertyList peg_property_list(
+        ListConv::asPegasusPropertyList(property_list, "PropertyList"));
+
+    const int cnt = bp::len(py_instance_names);
+    std::vector<GetInstanceTask> tasks(cnt);
+    std::vector<BulkTask*> task_ptrs(cnt);
+    for (int i = 0; i < cnt; ++i) {
+        const CIMInstanceName &cim_instance_name = CIMInstanceName::asNative(
+            py_instance_names[i], "InstanceNames");
+        String c_ns(m_default_namespace);
+        if (!cim_instance_name.getNamespace().empty())
+            c_ns = cim_instance_name.getNamespace();
+        if (!isnone(ns))
+            c_ns = StringConv::asString(ns, "namespace");
+
+        GetInstanceTask &task = tasks[i];
+        task.ns = Pegasus::CIMNamespaceName(c_ns);
+        task.path = cim_instance_name.asPegasusCIMObjectPath();
+        task.local_only = local_only;
+        task.include_qualifiers = include_qualifiers;
+        task.include_class_origin = include_class_origin;
+        task.property_list = peg_property_list;
+        task_ptrs[i] = &task;
+    }
+
+    timer.enter(OperationStats::PHASE_CALL);
+    {
+        ScopedGILRelease sr;
+        executor.run(task_ptrs);
+    }
+    timer.enter(OperationStats::PHASE_CONSTRUCTION);
+    timer.setObjectCount(cnt);
+
+    bp::list py_instances;
+    for (int i = 0; i < cnt; ++i) {
+        if (tasks[i].error.isSet())
+            py_instances.append(tasks[i].error.asPyObject());
+        else
+            py_instances.append(CIMInstance::create(tasks[i].instance));
+    }
+
+    return py_instances;
+} catch (...) {
+    std::stringstream ss;
+    if (Config::isVerbose())
+        ss << "GetInstances()";
+    handle_all_exceptions(ss);
+    return None;
+}
+
+Pegasus::Array<Pegasus::CIMInstance> WBEMConnection::refetchInstances(
+    const InstanceRequest &request) try
+{
+    OperationTimer timer(this, "Refetch");
+    Pegasus::Array<Pegasus::CIMInstance> peg_instances;
+    Pegasus::Array<Pegasus::CIMObject> peg_objects;
+
+    ScopedTransactionBegin();
+    setOperationTarget(
+        request.ns.getString(),
+        request.type == InstanceRequest::ENUMERATE_INSTANCES ?
+            request.classname.getString() :
+            request.path.getClassName().getString());
+    switch (request.type) {
+    case InstanceRequest::GET_INSTANCE:
+        peg_instances.clear();
+        peg_instances.append(m_client.getInstance(
+            request.ns,
+            request.path,
+            request.local_only,
+            request.include_qualifiers,
+            request.include_class_origin,
+            Pegasus::CIMPropertyList()));
+        peg_instances[0].setPath(request.path);
+        break;
+    case InstanceRequest::ENUMERATE_INSTANCES:
+        peg_instances = m_client.enumerateInstances(
+            request.ns,
+            request.classname,
+            request.deep_inheritance,
+            request.local_only,
+            request.include_qualifiers,
+            request.include_class_origin,
+            Pegasus::CIMPropertyList());
+        break;
+    case InstanceRequest::ASSOCIATORS:
+        peg_objects = m_client.associators(
+            request.ns,
+            request.path,
+            request.assoc_class,
+            request.result_class,
+            request.role,
+            request.result_role,
+            request.include_qualifiers,
+            request.include_class_origin,
+            Pegasus::CIMPropertyList());
+        break;
+    }
+    ScopedTransactionEnd();
+
+    const Pegasus::Uint32 cnt = peg_objects.size();
+    for (Pegasus::Uint32 i = 0; i < cnt; ++i)
+        peg_instances.append(Pegasus::CIMInstance(peg_objects[i]));
+
+    timer.setObjectCount(peg_instances.size());
+    return peg_instances;
+} catch (...) {
+    std::stringstream ss;
+    if (Config::isVerbose()) {
+        ss << "Refetch(";
+        if (Config::isVerboseMore())
+            ss << '\'' << request.path.toString() << '\'';
+        ss << ')';
+    }
+    handle_all_exceptions(ss);
+    return Pegasus::Array<Pegasus::CIMInstance>();
+}
+
+Pegasus::CIMInstance WBEMConnection::refetchInstance(
+    const Pegasus::CIMObjectPath &path,
+    const bool local_only,
+    const bool include_qualifiers,
+    const bool include_class_origin) try
+{
+    OperationTimer timer(this, "RefetchInstance");
+    Pegasus::CIMNamespaceName peg_ns(m_default_namespace);
+    if (!path.getNameSpace().isNull())
+        peg_ns = path.getNameSpace();
+
+    Pegasus::CIMInstance peg_instance;
+
+    ScopedTransactionBegin();
+    setOperationTarget(peg_ns.getString(), path.getClassName().getString());
+    peg_instance = m_client.getInstance(
+        peg_ns,
+        path,
+        local_only,
+        include_qualifiers,
+        include_class_origin,
+        Pegasus::CIMPropertyList());
+    ScopedTransactionEnd();
+
+    return peg_instance;
+} catch (...) {
+    std::stringstream ss;
+    if (Config::isVerbose()) {
+        ss << "GetInstance(";
+        if (Config::isVerboseMore())
+            ss << '\'' << path.toString() << '\'';
+        ss << ')';
+    }
+    handle_all_exceptions(ss);
+    return Pegasus::CIMInstance();
+}
+
 bp::object WBEMConnection::enumerateClasses(
     const bp::object &ns,
     const bp::object &cls,
@@ -1167,6 +2311,7 @@ bp::object WBEMConnection::enumerateClasses(
     const bool include_qualifiers,
     const bool include_class_origin) try
 {
+    OperationTimer timer(this, "EnumerateClasses");
     String c_ns(m_default_namespace);
     if (!isnone(ns))
         c_ns = StringConv::asString(ns, "namespace");
@@ -1181,6 +2326,7 @@ bp::object WBEMConnection::enumerateClasses(
     Pegasus::CIMNamespaceName peg_ns(c_ns);
 
     ScopedTransactionBegin();
+    setOperationTarget(peg_ns.getString(), peg_classname.getString());
     peg_classes = m_client.enumerateClasses(
         peg_ns,
         peg_classname,
@@ -1189,6 +2335,7 @@ bp::object WBEMConnection::enumerateClasses(
         include_qualifiers,
         include_class_origin);
     ScopedTransactionEnd();
+    timer.setObjectCount(peg_classes.size());
 
     return ListConv::asPyCIMClassList(peg_classes);
 } catch (...) {
@@ -1212,6 +2359,7 @@ bp::object WBEMConnection::enumerateClassNames(
     const bp::object &cls,
     const bool deep_inheritance) try
 {
+    OperationTimer timer(this, "EnumerateClassNames");
     String c_ns(m_default_namespace);
     if (!isnone(ns))
         c_ns = StringConv::asString(ns, "namespace");
@@ -1226,11 +2374,13 @@ bp::object WBEMConnection::enumerateClassNames(
     Pegasus::CIMNamespaceName peg_ns(c_ns);
 
     ScopedTransactionBegin();
+    setOperationTarget(peg_ns.getString(), peg_classname.getString());
     peg_classnames = m_client.enumerateClassNames(
         peg_ns,
         peg_classname,
         deep_inheritance);
     ScopedTransactionEnd();
+    timer.setObjectCount(peg_classnames.size());
 
     // We do not create lmiwbem.CIMClassName objects here; we try to mimic pywbem.
     bp::list py_class_names;
@@ -1261,6 +2411,7 @@ bp::object WBEMConnection::execQuery(
     const bp::object &query,
     const bp::object &ns) try
 {
+    OperationTimer timer(this, "ExecQuery");
     String c_query_lang = StringConv::asString(query_lang, "QueryLanguage");
     String c_query = StringConv::asString(query, "Query");
     String c_ns(m_default_namespace);
@@ -1278,6 +2429,7 @@ bp::object WBEMConnection::execQuery(
         peg_query_lang,
         peg_query);
     ScopedTransactionEnd();
+    timer.setObjectCount(peg_instances.size());
 
     return ListConv::asPyCIMInstanceList(
         peg_instances, c_ns, m_client.hostname());
@@ -1303,6 +2455,7 @@ bp::object WBEMConnection::getClass(
     const bool include_class_origin,
     const bp::object &property_list) try
 {
+    OperationTimer timer(this, "GetClass");
     String c_cls(StringConv::asString(cls, "ClassName"));
     String c_ns(m_default_namespace);
     if (!isnone(ns))
@@ -1316,6 +2469,7 @@ bp::object WBEMConnection::getClass(
             property_list, "PropertyList"));
 
     ScopedTransactionBegin()
+    setOperationTarget(peg_ns.getString(), peg_name.getString());
     peg_class = m_client.getClass(
         peg_ns,
         peg_name,
@@ -1353,6 +2507,7 @@ bp::object WBEMConnection::getAssociators(
     const bool include_class_origin,
     const bp::object property_list) try
 {
+    OperationTimer timer(this, "Associators");
     const CIMInstanceName &cim_inst_name = CIMInstanceName::asNative(
         object_path, "ObjectName");
     Pegasus::CIMObjectPath peg_path = cim_inst_name.asPegasusCIMObjectPath();
@@ -1388,7 +2543,29 @@ bp::object WBEMConnection::getAssociators(
     if (!c_result_class.empty())
         peg_result_class = Pegasus::CIMName(c_result_class);
 
+    PropertyUsageTrackerPtr tracker;
+    if (m_adaptive_property_list && isnone(property_list)) {
+        PropertyUsagePtr usage(m_property_usage.get(
+            "Associators", c_ns, cim_inst_name.getClassname()));
+        peg_property_list = usage->nextPropertyList();
+
+        InstanceRequest request(InstanceRequest::ASSOCIATORS, peg_ns);
+        request.path = peg_path;
+        request.assoc_class = peg_assoc_class;
+        request.result_class = peg_result_class;
+        request.role = c_role;
+        request.result_role = c_result_role;
+        request.include_qualifiers = include_qualifiers;
+        request.include_class_origin = include_class_origin;
+        tracker.reset(new PropertyUsageTracker(
+            usage,
+            m_instance_fetcher,
+            peg_property_list,
+            request));
+    }
+
     ScopedTransactionBegin();
+    setOperationTarget(peg_ns.getString(), peg_path.getClassName().getString());
     peg_associators = m_client.associators(
         peg_ns,
         peg_path,
@@ -1400,9 +2577,14 @@ bp::object WBEMConnection::getAssociators(
         include_class_origin,
         peg_property_list);
     ScopedTransactionEnd();
+    timer.setObjectCount(peg_associators.size());
 
-    return ListConv::asPyCIMInstanceList(
-        peg_associators, c_ns, m_client.hostname());
+    bp::object py_associators(ListConv::asPyCIMInstanceList(
+        peg_associators, c_ns, m_client.hostname()));
+    if (tracker)
+        setPropertyUsageTracker(py_associators, tracker);
+
+    return py_associators;
 } catch (...) {
     std::stringstream ss;
     if (Config::isVerbose()) {
@@ -1422,6 +2604,7 @@ bp::object WBEMConnection::getAssociatorNames(
     const bp::object &role,
     const bp::object &result_role) try
 {
+    OperationTimer timer(this, "AssociatorNames");
     const CIMInstanceName &cim_inst_name = CIMInstanceName::asNative(
         object_path, "ObjectName");
     Pegasus::CIMObjectPath peg_path = cim_inst_name.asPegasusCIMObjectPath();
@@ -1454,6 +2637,7 @@ bp::object WBEMConnection::getAssociatorNames(
         peg_result_class = Pegasus::CIMName(c_result_class);
 
     ScopedTransactionBegin();
+    setOperationTarget(peg_ns.getString(), peg_path.getClassName().getString());
     peg_associator_names = m_client.associatorNames(
         peg_ns,
         peg_path,
@@ -1462,6 +2646,7 @@ bp::object WBEMConnection::getAssociatorNames(
         c_role,
         c_result_role);
     ScopedTransactionEnd();
+    timer.setObjectCount(peg_associator_names.size());
 
     return ListConv::asPyCIMInstanceNameList(
         peg_associator_names, c_ns, m_client.hostname());
@@ -1485,6 +2670,7 @@ bp::object WBEMConnection::getReferences(
     const bool include_class_origin,
     const bp::object &property_list) try
 {
+    OperationTimer timer(this, "References");
     const CIMInstanceName &cim_inst_name = CIMInstanceName::asNative(
         object_path, "ObjectName");
     Pegasus::CIMObjectPath peg_path = cim_inst_name.asPegasusCIMObjectPath();
@@ -1511,6 +2697,7 @@ bp::object WBEMConnection::getReferences(
         peg_result_class = Pegasus::CIMName(c_result_class);
 
     ScopedTransactionBegin();
+    setOperationTarget(peg_ns.getString(), peg_path.getClassName().getString());
     peg_references = m_client.references(
         peg_ns,
         peg_path,
@@ -1520,6 +2707,7 @@ bp::object WBEMConnection::getReferences(
         include_class_origin,
         peg_property_list);
     ScopedTransactionEnd();
+    timer.setObjectCount(peg_references.size());
 
     return ListConv::asPyCIMInstanceList(
         peg_references, c_ns, m_client.hostname());
@@ -1540,6 +2728,7 @@ bp::object WBEMConnection::getReferenceNames(
     const bp::object &result_class,
     const bp::object &role) try
 {
+    OperationTimer timer(this, "ReferenceNames");
     const CIMInstanceName &cim_inst_name = CIMInstanceName::asNative(
         object_path, "ObjectName");
     Pegasus::CIMObjectPath peg_path = cim_inst_name.asPegasusCIMObjectPath();
@@ -1562,12 +2751,14 @@ bp::object WBEMConnection::getReferenceNames(
         peg_result_class = Pegasus::CIMName(c_result_class);
 
     ScopedTransactionBegin();
+    setOperationTarget(peg_ns.getString(), peg_path.getClassName().getString());
     peg_reference_names = m_client.referenceNames(
         peg_ns,
         peg_path,
         peg_result_class,
         c_role);
     ScopedTransactionEnd();
+    timer.setObjectCount(peg_reference_names.size());
 
     return ListConv::asPyCIMInstanceNameList(
         peg_reference_names, c_ns, m_client.hostname());
@@ -1582,3 +2773,420 @@ bp::object WBEMConnection::getReferenceNames(
     handle_all_exceptions(ss);
     return None;
 }
+
+bp::object WBEMConnection::traverseAssociatorNames(
+    const bp::object &object_names,
+    const bp::object &hops,
+    const bp::object &depth,
+    const bp::object &concurrency) try
+{
+    OperationTimer timer(this, "TraverseAssociatorNames");
+    bp::list py_object_names;
+    if (islist(object_names))
+        py_object_names = bp::list(object_names);
+    else
+        py_object_names.append(object_names);
+
+    bp::list py_hops(Conv::get<bp::list>(hops, "Hops"));
+    const int hops_cnt = bp::len(py_hops);
+    if (hops_cnt == 0)
+        throw_ValueError("Hops must contain at least one hop");
+
+    std::vector<AssociationHop> c_hops(hops_cnt);
+    for (int i = 0; i < hops_cnt; ++i) {
+        bp::dict py_hop(Conv::get<bp::dict>(py_hops[i], "hop"));
+        bp::object py_assoc_class(py_hop.get("AssocClass"));
+        bp::object py_result_class(py_hop.get("ResultClass"));
+        bp::object py_role(py_hop.get("Role"));
+        bp::object py_result_role(py_hop.get("ResultRole"));
+
+        if (!isnone(py_assoc_class)) {
+            c_hops[i].assoc_class = Pegasus::CIMName(
+                StringConv::asString(py_assoc_class, "AssocClass"));
+        }
+        if (!isnone(py_result_class)) {
+            c_hops[i].result_class = Pegasus::CIMName(
+                StringConv::asString(py_result_class, "ResultClass"));
+        }
+        if (!isnone(py_role))
+            c_hops[i].role = StringConv::asString(py_role, "Role");
+        if (!isnone(py_result_role))
+            c_hops[i].result_role = StringConv::asString(py_result_role, "ResultRole");
+    }
+
+    int c_depth = hops_cnt;
+    if (!isnone(depth)) {
+        c_depth = Conv::as<int>(depth, "Depth");
+        if (c_depth < 0)
+            throw_ValueError("Depth must not be negative");
+    }
+
+    Pegasus::Uint32 c_concurrency = Conv::as<Pegasus::Uint32>(
+        concurrency, "Concurrency");
+    if (c_concurrency == 0)
+        throw_ValueError("Concurrency must be positive number");
+
+    // Connection parameters are checked here, with the GIL held.
+    BulkExecutor executor(*this, c_concurrency);
+
+    std::vector<Pegasus::CIMObjectPath> peg_start_paths;
+    const int start_cnt = bp::len(py_object_names);
+    for (int i = 0; i < start_cnt; ++i) {
+        const CIMInstanceName &cim_inst_name = CIMInstanceName::asNative(
+            py_object_names[i], "ObjectNames");
+        Pegasus::CIMObjectPath peg_path = cim_inst_name.asPegasusCIMObjectPath();
+        CIMInstanceName::updatePegasusCIMObjectPathNamespace(
+            peg_path, m_default_namespace);
+        peg_start_paths.push_back(peg_path);
+    }
+
+    // Graph nodes are indexed by canonical form of the object path.
+    std::vector<Pegasus::CIMObjectPath> peg_nodes;
+    std::map<String, size_t> node_index;
+    std::vector<std::pair<size_t, size_t> > edges;
+    std::set<std::pair<size_t, size_t> > edge_set;
+    std::vector<size_t> level;
+
+    const String c_hostname(executor.hostname());
+
+    std::vector<Pegasus::CIMObjectPath>::iterator it;
+    for (it = peg_start_paths.begin(); it != peg_start_paths.end(); ++it) {
+        CIMInstanceName::updatePegasusCIMObjectPathHostname(*it, c_hostname);
+        const String key(CIMInstanceName::canonicalKey(*it));
+        if (node_index.find(key) != node_index.end())
+            continue;
+
+        node_index[key] = peg_nodes.size();
+        level.push_back(peg_nodes.size());
+        peg_nodes.push_back(*it);
+    }
+
+    for (int d = 0; d < c_depth && !level.empty(); ++d) {
+        const AssociationHop &hop = c_hops[std::min(d, hops_cnt - 1)];
+
+        // Nodes of a level are expanded concurrently.
+        const size_t cnt = level.size();
+        std::vector<AssociatorNamesTask> tasks(cnt);
+        std::vector<BulkTask*> task_ptrs(cnt);
+        for (size_t i = 0; i < cnt; ++i) {
+            tasks[i].hop = &hop;
+            tasks[i].path = peg_nodes[level[i]];
+            task_ptrs[i] = &tasks[i];
+        }
+
+        timer.enter(OperationStats::PHASE_CALL);
+        {
+            ScopedGILRelease sr;
+            executor.run(task_ptrs);
+        }
+        timer.enter(OperationStats::PHASE_CONVERSION);
+
+        // Results are merged in level order, so the graph doesn't depend on
+        // the order, in which the tasks finished.
+        std::vector<size_t> next_level;
+        for (size_t i = 0; i < cnt; ++i) {
+            if (tasks[i].error.isSet())
+                tasks[i].error.raise();
+
+            const Pegasus::CIMObjectPath &peg_path = tasks[i].path;
+            Pegasus::Array<Pegasus::CIMObjectPath> &peg_associator_names =
+                tasks[i].associator_names;
+            const Pegasus::Uint32 names_cnt = peg_associator_names.size();
+            for (Pegasus::Uint32 j = 0; j < names_cnt; ++j) {
+                Pegasus::CIMObjectPath &peg_name = peg_associator_names[j];
+                CIMInstanceName::updatePegasusCIMObjectPathNamespace(
+                    peg_name, peg_path.getNameSpace().getString());
+                CIMInstanceName::updatePegasusCIMObjectPathHostname(
+                    peg_name, c_hostname);
+
+                const String key(CIMInstanceName::canonicalKey(peg_name));
+                std::map<String, size_t>::const_iterator found = node_index.find(key);
+                size_t dst;
+                if (found == node_index.end()) {
+                    dst = peg_nodes.size();
+                    node_index[key] = dst;
+                    next_level.push_back(dst);
+                    peg_nodes.push_back(peg_name);
+                } else {
+                    dst = found->second;
+                }
+
+                const std::pair<size_t, size_t> edge(level[i], dst);
+                if (edge_set.insert(edge).second)
+                    edges.push_back(edge);
+            }
+        }
+
+        level.swap(next_level);
+    }
+    timer.setObjectCount(peg_nodes.size());
+
+    bp::list py_nodes;
+    std::vector<Pegasus::CIMObjectPath>::const_iterator node;
+    for (node = peg_nodes.begin(); node != peg_nodes.end(); ++node)
+        py_nodes.append(CIMInstanceName::create(*node));
+
+    bp::list py_edges;
+    std::vector<std::pair<size_t, size_t> >::const_iterator edge;
+    for (edge = edges.begin(); edge != edges.end(); ++edge) {
+        py_edges.append(bp::make_tuple(
+            py_nodes[edge->first], py_nodes[edge->second]));
+    }
+
+    return bp::make_tuple(py_nodes, py_edges);
+} catch (...) {
+    std::stringstream ss;
+    if (Config::isVerbose()) {
+        ss << "TraverseAssociatorNames(";
+        if (Config::isVerboseMore())
+            ss << '\'' << ObjectConv::asString(object_names) << '\'';
+        ss << ')';
+    }
+    handle_all_exceptions(ss);
+    return None;
+}
+
+void WBEMConnection::refreshClassHierarchy(const bp::object &ns) try
+{
+    String c_ns(m_default_namespace);
+    if (!isnone(ns))
+        c_ns = StringConv::asString(ns, "namespace");
+
+    m_class_hierarchy.set(c_ns, ClassHierarchyPtr());
+    classHierarchy(c_ns, true);
+} catch (...) {
+    std::stringstream ss;
+    if (Config::isVerbose())
+        ss << "RefreshClassHierarchy()";
+    handle_all_exceptions(ss);
+}
+
+bool WBEMConnection::isSubclass(
+    const bp::object &superclass,
+    const bp::object &subclass,
+    const bp::object &ns) try
+{
+    String c_ns(m_default_namespace);
+    if (!isnone(ns))
+        c_ns = StringConv::asString(ns, "namespace");
+    String c_superclass(StringConv::asString(superclass, "SuperClass"));
+    String c_subclass;
+    if (isinstance(subclass, CIMClass::type()))
+        c_subclass = CIMClass::asNative(subclass).getClassname();
+    else
+        c_subclass = StringConv::asString(subclass, "SubClass");
+
+    return classHierarchy(c_ns, true)->isSubclass(c_superclass, c_subclass);
+} catch (...) {
+    std::stringstream ss;
+    if (Config::isVerbose())
+        ss << "IsSubclass()";
+    handle_all_exceptions(ss);
+    return false;
+}
+
+bp::object WBEMConnection::getClassAncestors(
+    const bp::object &cls,
+    const bp::object &ns) try
+{
+    String c_ns(m_default_namespace);
+    if (!isnone(ns))
+        c_ns = StringConv::asString(ns, "namespace");
+    String c_cls(StringConv::asString(cls, "ClassName"));
+
+    std::vector<String> ancestors;
+    if (!classHierarchy(c_ns, true)->getAncestors(c_cls, ancestors))
+        throw_CIMError("Class not found: " + c_cls, CIMConstants::CIM_ERR_NOT_FOUND);
+
+    return asPyClassNameList(ancestors);
+} catch (...) {
+    std::stringstream ss;
+    if (Config::isVerbose()) {
+        ss << "GetClassAncestors(";
+        if (Config::isVerboseMore())
+            ss << "class=u'" << StringConv::asString(cls) << '\'';
+        ss << ')';
+    }
+    handle_all_exceptions(ss);
+    return None;
+}
+
+bp::object WBEMConnection::getClassDescendants(
+    const bp::object &cls,
+    const bp::object &ns,
+    const bool deep_inheritance) try
+{
+    String c_ns(m_default_namespace);
+    if (!isnone(ns))
+        c_ns = StringConv::asString(ns, "namespace");
+    String c_cls(StringConv::asString(cls, "ClassName"));
+
+    std::vector<String> descendants;
+    if (!classHierarchy(c_ns, true)->getDescendants(
+            c_cls, deep_inheritance, descendants)) {
+        throw_CIMError("Class not found: " + c_cls, CIMConstants::CIM_ERR_NOT_FOUND);
+    }
+
+    return asPyClassNameList(descendants);
+} catch (...) {
+    std::stringstream ss;
+    if (Config::isVerbose()) {
+        ss << "GetClassDescendants(";
+        if (Config::isVerboseMore())
+            ss << "class=u'" << StringConv::asString(cls) << '\'';
+        ss << ')';
+    }
+    handle_all_exceptions(ss);
+    return None;
+}
+
+bp::object WBEMConnection::getCommonSuperclass(
+    const bp::object &classes,
+    const bp::object &ns) try
+{
+    String c_ns(m_default_namespace);
+    if (!isnone(ns))
+        c_ns = StringConv::asString(ns, "namespace");
+
+    bp::list py_classes(Conv::get<bp::list>(classes, "ClassNames"));
+    std::vector<String> c_classes;
+    const int cnt = bp::len(py_classes);
+    for (int i = 0; i < cnt; ++i)
+        c_classes.push_back(StringConv::asString(py_classes[i], "ClassNames"));
+
+    String c_common(classHierarchy(c_ns, true)->getCommonSuperclass(c_classes));
+    if (c_common.empty())
+        return None;
+
+    return StringConv::asPyUnicode(c_common);
+} catch (...) {
+    std::stringstream ss;
+    if (Config::isVerbose())
+        ss << "GetCommonSuperclass()";
+    handle_all_exceptions(ss);
+    return None;
+}
+
+bp::object WBEMConnection::batch(const bp::object &self)
+{
+    return WBEMBatch::create(self);
+}
+
+bp::list WBEMConnection::executeBatch(
+    const std::vector<BatchOperation> &operations)
+{
+    OperationTimer timer(this, "Batch");
+    bp::list py_results;
+    if (operations.empty())
+        return py_results;
+
+    // Batch containing deletions must not be run twice.
+    bool idempotent = true;
+    std::vector<BatchOperation>::const_iterator it;
+    for (it = operations.begin(); it != operations.end(); ++it) {
+        if (it->type == BatchOperation::DELETE_INSTANCE)
+            idempotent = false;
+    }
+
+    // CIM-XML multiple operation requests are not supported by Pegasus
+    // client; the operations are sent one by one over the same connection.
+    ScopedTransactionBeginRetry(idempotent);
+    // The batch may be run once more over a new connection.
+    py_results = bp::list();
+    const String c_hostname(m_client.hostname());
+    for (it = operations.begin(); it != operations.end(); ++it) {
+        try {
+            py_results.append(executeBatchOperation(*it, c_hostname));
+        } catch (const bp::error_already_set &) {
+            throw;
+        } catch (...) {
+            // Connection failure of the first operation is left to
+            // ScopedConnection, which reconnects stale kept alive connection.
+            if (it == operations.begin() && isConnectionError())
+                throw;
+
+            std::stringstream ss;
+            if (Config::isVerbose())
+                ss << "Batch(" << (it - operations.begin()) << ')';
+            py_results.append(exception_as_object(ss));
+        }
+    }
+    ScopedTransactionEnd();
+
+    return py_results;
+}
+
+void WBEMConnection::setOperationTarget(
+    const String &ns,
+    const String &classname)
+{
+    m_perf_data.setClassname(classname);
+    if (m_op_timer)
+        m_op_timer->setTarget(ns, classname);
+}
+
+bp::object WBEMConnection::executeBatchOperation(
+    const BatchOperation &operation,
+    const String &hostname)
+{
+    m_perf_data.setClassname(operation.classname.isNull() ?
+        String(operation.path.getClassName().getString()) :
+        String(operation.classname.getString()));
+
+    switch (operation.type) {
+    case BatchOperation::GET_INSTANCE: {
+        Pegasus::CIMInstance peg_instance = m_client.getInstance(
+            operation.ns,
+            operation.path,
+            operation.local_only,
+            operation.include_qualifiers,
+            operation.include_class_origin,
+            operation.property_list);
+        peg_instance.setPath(operation.path);
+        return CIMInstance::create(peg_instance);
+    }
+    case BatchOperation::GET_CLASS:
+        return CIMClass::create(m_client.getClass(
+            operation.ns,
+            operation.classname,
+            operation.local_only,
+            operation.include_qualifiers,
+            operation.include_class_origin,
+            operation.property_list));
+    case BatchOperation::ENUMERATE_INSTANCE_NAMES:
+        return ListConv::asPyCIMInstanceNameList(
+            m_client.enumerateInstanceNames(operation.ns, operation.classname),
+            operation.ns.getString(),
+            hostname);
+    case BatchOperation::DELETE_INSTANCE:
+        m_client.deleteInstance(operation.ns, operation.path);
+        return None;
+    }
+
+    return None;
+}
+
+ClassHierarchyPtr WBEMConnection::classHierarchy(const String &ns, const bool build)
+{
+    ClassHierarchyPtr hierarchy(m_class_hierarchy.get(ns));
+    if (hierarchy || !build)
+        return hierarchy;
+
+    Pegasus::Array<Pegasus::CIMClass> peg_classes;
+    Pegasus::CIMNamespaceName peg_ns(ns);
+
+    // Only class and super class names are needed; keep the response small.
+    ScopedTransactionBegin();
+    peg_classes = m_client.enumerateClasses(
+        peg_ns,
+        Pegasus::CIMName(),
+        true,
+        true,
+        false,
+        false);
+    ScopedTransactionEnd();
+
+    hierarchy.reset(new ClassHierarchy(peg_classes));
+    m_class_hierarchy.set(ns, hierarchy);
+    return hierarchy;
+}
@@ -22,18 +22,29 @@
 #ifndef   LMIWBEM_CONNECTION_H
 #  define LMIWBEM_CONNECTION_H
 
+#  include <ctime>
+#  include <vector>
 #  include <boost/python/class.hpp>
 #  include "lmiwbem.h"
 #  include "lmiwbem_cimbase.h"
 #  include "lmiwbem_client.h"
+#  include "lmiwbem_client_perf.h"
+#  include "util/lmiwbem_class_hierarchy.h"
+#  include "util/lmiwbem_histogram.h"
+#  include "util/lmiwbem_operation_stats.h"
+#  include "util/lmiwbem_property_usage.h"
+#  include "util/lmiwbem_slow_log.h"
 #  include "util/lmiwbem_string.h"
 
 BOOST_PYTHON_BEGIN
 class dict;
 class object;
+class list;
 class tuple;
 BOOST_PYTHON_END
 
+struct BatchOperation;
+
 namespace bp = boost::python;
 
 class WBEMConnection: public CIMBase<WBEMConnection>
@@ -42,35 +53,131 @@ private:
         /* NOTE: These macros need to be used around every CIM operation.
          * ScopedTransactionBegin creates a temporary connection, if necessary and also
          * it ensures that CIMClient can enter a critical section.
-         * ScopedTransactionEnd is defined due to semantics; to close the scope.
+         * ScopedTransactionEnd marks the operation as successful. If the operation
+         * fails on a reused kept alive connection, it is run once more over a new
+         * connection. Operations, which the CIMOM may have already executed, are
+         * not idempotent; use ScopedTransactionBeginNoRetry() for them, so they
+         * are retried only, if the request was not sent. The code between the
+         * macros must not return.
          */
-#  define ScopedTransactionBegin() { \
+#  define ScopedTransactionBegin() ScopedTransactionBeginRetry(true)
+#  define ScopedTransactionBeginNoRetry() ScopedTransactionBeginRetry(false)
+#  define ScopedTransactionBeginRetry(idempotent) { \
        ScopedTransaction _st(this);  \
-       ScopedConnection  _sc(this);
-#  define ScopedTransactionEnd() }
+       for (ScopedConnection _sc(this, idempotent); !_sc.succeeded(); ) try {
+#  define ScopedTransactionEnd() \
+           _sc.succeed(); \
+       } catch (...) { \
+           if (!_sc.retry()) \
+               throw; \
+       } \
+   }
 
     class ScopedConnection
     {
     public:
-        ScopedConnection(WBEMConnection *conn);
+        ScopedConnection(WBEMConnection *conn, bool idempotent);
         ~ScopedConnection();
 
+        void succeed();
+        bool succeeded() const;
+
+        // Call from a catch block. Reconnects and returns true, if the
+        // operation failed on a reused kept alive connection for the first
+        // time; the server may have closed it meanwhile. Operation, which is
+        // not idempotent, is retried only, if it failed before the request
+        // was sent.
+        bool retry();
+
     private:
+        void connect();
+
         WBEMConnection *m_conn;
         bool m_conn_orig_state;
+        bool m_idempotent;
+        bool m_reused;
+        bool m_succeeded;
+    };
+
+    // Measures durations of phases of a single CIM operation and records
+    // them into connection's and process-wide OperationStats. Operation
+    // starts in conversion phase; ScopedTransaction switches to the other
+    // phases. Nested timers are restored on destruction.
+    class OperationTimer
+    {
+    public:
+        OperationTimer(WBEMConnection *conn, const char *operation);
+        ~OperationTimer();
+
+        void enter(OperationStats::Phase phase);
+        const char *operation() const;
+
+        // Details of the operation reported in the slow operation log.
+        void setTarget(const String &ns, const String &classname);
+        void setObjectCount(Pegasus::Uint64 count);
+
+    private:
+        void logSlowOperation();
+
+        WBEMConnection *m_conn;
+        OperationTimer *m_prev;
+        const char *m_operation;
+        Stopwatch m_stopwatch;
+        OperationStats::Phase m_phase;
+        Pegasus::Uint64 m_durations[OperationStats::PHASES];
+        bool m_measured[OperationStats::PHASES];
+        String m_classname;
+        String m_namespace;
+        Pegasus::Uint64 m_object_count;
+        // Total response size of the client at the beginning
+        Pegasus::Uint64 m_response_size;
     };
 
     class ScopedTransaction
     {
     public:
         ScopedTransaction(WBEMConnection *conn);
+        ~ScopedTransaction();
 
     private:
+        const char *operationName() const;
+
+        static WBEMConnection *enterPhase(
+            WBEMConnection *conn,
+            OperationStats::Phase phase);
+
+        WBEMConnection *m_conn;
+        // Destroyed after m_sct, when the transaction is finished.
+        ClientPerformanceData::ScopedCallbacks m_perf_callbacks;
         CIMClient::ScopedCIMClientTransaction m_sct;
     };
 
+    // Refetches partially retrieved instances in adaptive PropertyList mode.
+    // Instances hold only weak reference to it, so they don't outlive the
+    // connection.
+    class PropertyRefetcher: public InstanceFetcher
+    {
+    public:
+        PropertyRefetcher(WBEMConnection *conn);
+
+        virtual Pegasus::Array<Pegasus::CIMInstance> fetchInstances(
+            const InstanceRequest &request);
+
+        virtual Pegasus::CIMInstance fetchInstance(
+            const Pegasus::CIMObjectPath &path,
+            const bool local_only,
+            const bool include_qualifiers,
+            const bool include_class_origin);
+
+    private:
+        WBEMConnection *m_conn;
+    };
+
+    friend class BulkExecutor;
+    friend class OperationTimer;
     friend class ScopedConnection;
     friend class ScopedTransaction;
+    friend class PropertyRefetcher;
 
     typedef bp::class_<WBEMConnection, boost::noncopyable> WBEMConnectionClass;
 
@@ -97,6 +204,12 @@ public:
         const bp::object &no_verification);
     void connectLocally();
     void disconnect();
+
+    // Connects with the URL and credentials passed to the constructor. Works
+    // with native data only, so it may be called without the GIL; Pegasus
+    // exceptions are propagated to the caller.
+    void connectNative(const String &trust_store);
+    String getURL() const;
     bool isConnected() const;
     bp::object getHostname() const;
 
@@ -112,6 +225,28 @@ public:
     void setDefaultNamespace(const bp::object &ns);
     bp::object getCredentials() const;
     void setCredentials(const bp::object &creds);
+    bool getAdaptivePropertyList() const;
+    void setAdaptivePropertyList(bool adaptive);
+    unsigned int getKeepAlive() const;
+    void setKeepAlive(unsigned int keep_alive);
+    bp::object getPerformanceDataCallback();
+    void setPerformanceDataCallback(const bp::object &callback);
+
+    bp::object getPerformanceData();
+    void resetPerformanceData();
+
+    bp::object getStats();
+    void resetStats();
+
+    double getSlowOperationThreshold() const;
+    void setSlowOperationThreshold(double threshold);
+    unsigned int getSlowOperationLogSize() const;
+    void setSlowOperationLogSize(unsigned int size);
+    bp::object getSlowOperationCallback() const;
+    void setSlowOperationCallback(const bp::object &callback);
+
+    bp::object getSlowOperations();
+    void clearSlowOperations();
 
     bp::object createInstance(
         const bp::object &instance,
@@ -131,7 +266,8 @@ public:
         const bool deep_inheritance,
         const bool include_qualifiers,
         const bool include_class_origin,
-        const bp::object &property_list);
+        const bp::object &property_list,
+        const bp::object &client_query);
 
     bp::object enumerateInstanceNames(
         const bp::object &cls,
@@ -145,6 +281,15 @@ public:
         const bool include_class_origin,
         const bp::object &property_list);
 
+    bp::object getInstances(
+        const bp::object &instance_names,
+        const bp::object &ns,
+        const bool local_only,
+        const bool include_qualifiers,
+        const bool include_class_origin,
+        const bp::object &property_list,
+        const bp::object &concurrency);
+
     bp::object enumerateClasses(
         const bp::object &ns,
         const bp::object &cls,
@@ -167,6 +312,10 @@ public:
         const bp::tuple &args,
         const bp::dict  &kwds);
 
+    bp::object invokeMethods(
+        const bp::object &calls,
+        const bp::object &concurrency);
+
     bp::object getClass(
         const bp::object &cls,
         const bp::object &ns,
@@ -205,6 +354,45 @@ public:
         const bp::object &result_class,
         const bp::object &role);
 
+    bp::object traverseAssociatorNames(
+        const bp::object &object_names,
+        const bp::object &hops,
+        const bp::object &depth,
+        const bp::object &concurrency);
+
+    void refreshClassHierarchy(const bp::object &ns);
+
+    bool isSubclass(
+        const bp::object &superclass,
+        const bp::object &subclass,
+        const bp::object &ns);
+
+    bp::object getClassAncestors(
+        const bp::object &cls,
+        const bp::object &ns);
+
+    bp::object getClassDescendants(
+        const bp::object &cls,
+        const bp::object &ns,
+        const bool deep_inheritance);
+
+    bp::object getCommonSuperclass(
+        const bp::object &classes,
+        const bp::object &ns);
+
+    static bp::object batch(const bp::object &self);
+
+    // Executes all the operations within a single transaction. Returns list
+    // of results; errors of individual operations are stored as Python
+    // exception objects.
+    bp::list executeBatch(const std::vector<BatchOperation> &operations);
+
+    // Returns class hierarchy of the namespace. If it has not been retrieved
+    // yet, it is built by a single deep EnumerateClasses, if build is set;
+    // otherwise empty pointer is returned. Pegasus exceptions are propagated
+    // to the caller.
+    ClassHierarchyPtr classHierarchy(const String &ns, const bool build);
+
 #  ifdef HAVE_PEGASUS_ENUMERATION_CONTEXT
     bp::object openEnumerateInstances(
         const bp::object &cls,
@@ -216,7 +404,8 @@ public:
         const bp::object &query,
         const bp::object &operation_timeout,
         const bp::object &continue_on_error,
-        const bp::object &max_object_cnt);
+        const bp::object &max_object_cnt,
+        const bp::object &client_query);
 
     bp::object openEnumerateInstanceNames(
         const bp::object &cls,
@@ -304,8 +493,28 @@ protected:
     static void init_type_pull(WBEMConnectionClass &cls);
 #  endif // HAVE_PEGASUS_ENUMERATION_CONTEXT
 
+    // Sets namespace and class name of the running operation for
+    // performance data and the slow operation log.
+    void setOperationTarget(const String &ns, const String &classname);
+
+    bp::object executeBatchOperation(
+        const BatchOperation &operation,
+        const String &hostname);
+
+    Pegasus::Array<Pegasus::CIMInstance> refetchInstances(
+        const InstanceRequest &request);
+    Pegasus::CIMInstance refetchInstance(
+        const Pegasus::CIMObjectPath &path,
+        const bool local_only,
+        const bool include_qualifiers,
+        const bool include_class_origin);
+
+    // Set, if the connection was established by ScopedConnection and kept
+    // open for m_keep_alive seconds after the last operation.
     bool m_connected_tmp;
     bool m_connect_locally;
+    unsigned int m_keep_alive;
+    time_t m_last_used;
     String m_url;
     String m_username;
     String m_password;
@@ -313,6 +522,14 @@ protected:
     String m_key_file;
     String m_default_namespace;
     CIMClient m_client;
+    bool m_adaptive_property_list;
+    PropertyUsageMap m_property_usage;
+    InstanceFetcherPtr m_instance_fetcher;
+    ClassHierarchyMap m_class_hierarchy;
+    ClientPerformanceData m_perf_data;
+    OperationTimer *m_op_timer;
+    OperationStats m_op_stats;
+    SlowOperationLog m_slow_log;
 };
 
 #endif // LMIWBEM_CONNECTION_H
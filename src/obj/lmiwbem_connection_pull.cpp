@@ -30,6 +30,7 @@
 #include "obj/cim/lmiwbem_enum_ctx.h"
 #include "util/lmiwbem_convert.h"
 #include "util/lmiwbem_util.h"
+#include "util/lmiwbem_wql.h"
 
 namespace {
 
@@ -56,11 +57,13 @@ void WBEMConnection::init_type_pull(WBEMConnection::WBEMConnectionClass &cls)
          bp::arg("Query") = None,
          bp::arg("OperationTimeout") = None,
          bp::arg("ContinueOnError") = false,
-         bp::arg("MaxObjectCnt") = 0),
+         bp::arg("MaxObjectCnt") = 0,
+         bp::arg("ClientQuery") = None),
         "OpenEnumerateInstances(ClassName, namespace=None, "
         "DeepInheritance=True, IncludeQualifiers=False, IncludeClassOrigin=False, "
         "PropertyList=None, QueryLang=None, Query=None, "
-        "OperationTimeout=None, ContinueOnError=False, MaxObjectCnt=0)\n\n"
+        "OperationTimeout=None, ContinueOnError=False, MaxObjectCnt=0, "
+        "ClientQuery=None)\n\n"
         "Opens an enumeration sequence of :py:class:`.CIMInstance`.\n\n"
         ":param str ClassName: String containing class name of instances to be "
         "retrieved.\n"
@@ -84,6 +87,10 @@ void WBEMConnection::init_type_pull(WBEMConnection::WBEMConnectionClass &cls)
         "occurring in the server.\n"
         ":param int MaxObjectCnt: Defines the maximum number of elements "
         "that this Open operation can return.\n"
+        ":param str ClientQuery: WQL query evaluated by the client against "
+        "instances retrieved by this and all subsequent pull operations, see "
+        ":py:meth:`EnumerateInstances`. Unlike Query, it is not sent to the "
+        "CIMOM, so the returned chunks can be smaller than requested.\n"
         ":returns: Tuple containing list of retrieved :py:class:`.CIMInstance` "
         "objects, enumeration context and boolean which defines if all the instances"
         "have been retrieved.\n"
@@ -379,8 +386,10 @@ bp::object WBEMConnection::openEnumerateInstances(
     const bp::object &query,
     const bp::object &operation_timeout,
     const bp::object &continue_on_error,
-    const bp::object &max_object_cnt) try
+    const bp::object &max_object_cnt,
+    const bp::object &client_query) try
 {
+    OperationTimer timer(this, "OpenEnumerateInstances");
     Pegasus::CIMName peg_class(StringConv::asPegasusString(cls, "ClassName"));
     Pegasus::CIMNamespaceName peg_ns(m_default_namespace);
     if (!isnone(ns))
@@ -411,6 +420,12 @@ bp::object WBEMConnection::openEnumerateInstances(
             operation_timeout, "OperationTimeout"));
     }
 
+    boost::shared_ptr<WQLQuery> wql_query;
+    if (!isnone(client_query)) {
+        wql_query.reset(new WQLQuery(
+            StringConv::asString(client_query, "ClientQuery")));
+    }
+
     boost::shared_ptr<Pegasus::CIMEnumerationContext> ctx_ptr(
         make_enumeration_ctx());
     Pegasus::Array<Pegasus::CIMInstance> peg_instances;
@@ -432,9 +447,15 @@ bp::object WBEMConnection::openEnumerateInstances(
         peg_max_object_cnt);
     ScopedTransactionEnd();
 
+    bp::object py_ctx(CIMEnumerationContext::create(ctx_ptr));
+    if (wql_query) {
+        peg_instances = wql_query->apply(peg_instances);
+        CIMEnumerationContext::asNative(py_ctx).setClientQuery(wql_query);
+    }
+
     return bp::make_tuple(
         ListConv::asPyCIMInstanceList(peg_instances),
-        CIMEnumerationContext::create(ctx_ptr),
+        py_ctx,
         bp::object(peg_end_of_sequence));
 } catch (...) {
     std::stringstream ss;
@@ -462,6 +483,7 @@ bp::object WBEMConnection::openEnumerateInstanceNames(
     const bp::object &continue_on_error,
     const bp::object &max_object_cnt) try
 {
+    OperationTimer timer(this, "OpenEnumerateInstanceNames");
     Pegasus::CIMName peg_class(StringConv::asPegasusString(cls, "ClassName"));
     Pegasus::CIMNamespaceName peg_ns(m_default_namespace);
     if (!isnone(ns))
@@ -539,6 +561,7 @@ bp::object WBEMConnection::openAssociators(
     const bp::object &continue_on_error,
     const bp::object &max_object_cnt) try
 {
+    OperationTimer timer(this, "OpenAssociators");
     const CIMInstanceName &inst_name = CIMInstanceName::asNative(
         object_path, "ObjectName");
     Pegasus::CIMObjectPath peg_path = inst_name.asPegasusCIMObjectPath();
@@ -646,6 +669,7 @@ bp::object WBEMConnection::openAssociatorNames(
     const bp::object &continue_on_error,
     const bp::object &max_object_cnt) try
 {
+    OperationTimer timer(this, "OpenAssociatorNames");
     const CIMInstanceName &inst_name = CIMInstanceName::asNative(
         object_path, "ObjectName");
     Pegasus::CIMObjectPath peg_path = inst_name.asPegasusCIMObjectPath();
@@ -745,6 +769,7 @@ bp::object WBEMConnection::openReferences(
     const bp::object &continue_on_error,
     const bp::object &max_object_cnt) try
 {
+    OperationTimer timer(this, "OpenReferences");
     const CIMInstanceName &inst_name = CIMInstanceName::asNative(
         object_path, "ObjectName");
     Pegasus::CIMObjectPath peg_path = inst_name.asPegasusCIMObjectPath();
@@ -836,6 +861,7 @@ bp::object WBEMConnection::openReferenceNames(
     const bp::object &continue_on_error,
     const bp::object &max_object_cnt) try
 {
+    OperationTimer timer(this, "OpenReferenceNames");
     const CIMInstanceName &inst_name = CIMInstanceName::asNative(
         object_path, "ObjectName");
     Pegasus::CIMObjectPath peg_path = inst_name.asPegasusCIMObjectPath();
@@ -916,6 +942,7 @@ bp::object WBEMConnection::openExecQuery(
     const bp::object &continue_on_error,
     const bp::object &max_object_cnt) try
 {
+    OperationTimer timer(this, "OpenExecQuery");
     String c_query_lang(
         StringConv::asPegasusString(query_lang, "QueryLanguage"));
     String c_query(
@@ -984,6 +1011,7 @@ bp::object WBEMConnection::pullInstances(
     const bp::object &ctx,
     const bp::object &max_object_cnt) try
 {
+    OperationTimer timer(this, "PullInstances");
     CIMEnumerationContext &ctx_ = CIMEnumerationContext::asNative(ctx, "Context");
     Pegasus::Uint32 peg_max_object_cnt = Conv::as<Pegasus::Uint32>(
         max_object_cnt, "MaxObjectCount");
@@ -991,7 +1019,7 @@ bp::object WBEMConnection::pullInstances(
     Pegasus::Array<Pegasus::CIMInstance> peg_instances;
     Pegasus::Boolean peg_end_of_sequence;
 
-    ScopedTransactionBegin();
+    ScopedTransactionBeginNoRetry();
     if (ctx_.getIsWithPaths()) {
         peg_instances = m_client.pullInstancesWithPath(
             ctx_.getPegasusContext(),
@@ -1005,6 +1033,10 @@ bp::object WBEMConnection::pullInstances(
     }
     ScopedTransactionEnd();
 
+    boost::shared_ptr<WQLQuery> wql_query(ctx_.getClientQuery());
+    if (wql_query)
+        peg_instances = wql_query->apply(peg_instances);
+
     return bp::make_tuple(
         ListConv::asPyCIMInstanceList(
             peg_instances,
@@ -1024,6 +1056,7 @@ bp::object WBEMConnection::pullInstanceNames(
     bp::object &ctx,
     bp::object &max_object_cnt) try
 {
+    OperationTimer timer(this, "PullInstanceNames");
     CIMEnumerationContext &ctx_ = CIMEnumerationContext::asNative(ctx, "Context");
     Pegasus::Uint32 peg_max_object_cnt = Conv::as<Pegasus::Uint32>(
         max_object_cnt, "MaxObjectCnt");
@@ -1031,7 +1064,7 @@ bp::object WBEMConnection::pullInstanceNames(
     Pegasus::Array<Pegasus::CIMObjectPath> peg_instance_names;
     Pegasus::Boolean peg_end_of_sequence;
 
-    ScopedTransactionBegin();
+    ScopedTransactionBeginNoRetry();
     peg_instance_names = m_client.pullInstancePaths(
         ctx_.getPegasusContext(),
         peg_end_of_sequence,
@@ -1052,8 +1085,9 @@ bp::object WBEMConnection::pullInstanceNames(
 
 void WBEMConnection::closeEnumeration(const bp::object &ctx) try
 {
+    OperationTimer timer(this, "CloseEnumeration");
     CIMEnumerationContext &ctx_ = CIMEnumerationContext::asNative(ctx, "Context");
-    ScopedTransactionBegin();
+    ScopedTransactionBeginNoRetry();
     m_client.closeEnumeration(ctx_.getPegasusContext());
     ScopedTransactionEnd();
 } catch (...) {
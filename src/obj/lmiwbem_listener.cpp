@@ -20,16 +20,25 @@
  * ***** END LICENSE BLOCK ***** */
 
 #include <config.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <sstream>
+#include <boost/functional/hash.hpp>
 #include <Pegasus/Common/SSLContext.h>
 #include <Pegasus/Consumer/CIMIndicationConsumer.h>
 #include <Pegasus/Listener/CIMListener.h>
+#include <set>
 #include <boost/python/class.hpp>
+#include <boost/python/list.hpp>
+#include <boost/python/tuple.hpp>
 #include "lmiwbem_config.h"
 #include "lmiwbem_exception.h"
 #include "lmiwbem_gil.h"
 #include "lmiwbem_make_method.h"
+#include "lmiwbem_trace.h"
 #include "obj/lmiwbem_listener.h"
+#include "obj/cim/lmiwbem_constants.h"
 #include "obj/cim/lmiwbem_instance.h"
 #include "util/lmiwbem_convert.h"
 #include "util/lmiwbem_util.h"
@@ -91,6 +100,39 @@ void CIMIndicationConsumer::consumeIndication(
     const Pegasus::String &url,
     const Pegasus::CIMInstance &indication)
 {
+    const String name(String(url).substr(1));
+    m_listener->m_metrics->received();
+
+    LMIWBEM_TRACE3(indication_consume,
+        name.c_str(),
+        String(indication.getClassName().getString()).c_str(),
+        indication.getPropertyCount());
+
+    // Drop the indication before it gets queued or converted.
+    if (!m_listener->matchFilter(name, indication) ||
+        !m_listener->admitThrottle(name, indication))
+    {
+        return;
+    }
+
+    if (m_listener->m_spool)
+        m_listener->m_spool->append(name, indication);
+
+    boost::shared_ptr<IndicationQueue> queue(
+        m_listener->queueFor(name, indication));
+    if (queue) {
+        // Hand the indication over to a dispatcher thread. We don't need
+        // the GIL here, so slow handlers don't block the Pegasus listener.
+        queue->push(name, indication);
+        return;
+    } else if (m_listener->m_queue_size > 0) {
+        // Listener is terminating; dispatchers don't take indications.
+        return;
+    }
+
+    // Native handlers don't need the GIL.
+    m_listener->callNative(name, indication);
+
     ScopedMutex sm(m_listener->m_mutex);
     if (m_listener->m_terminating) {
         return;
@@ -98,11 +140,23 @@ void CIMIndicationConsumer::consumeIndication(
 
     /* We call python from inside a thread created by CIMOM. We need to acquire
      * the GIL. */
+    Stopwatch sw;
     ScopedGILAcquire sg;
+    const Pegasus::Uint64 gil_wait = sw.elapsedUs();
+
+    // Metrics are kept only for registered handlers; the name comes from
+    // the request URL.
+    if (m_listener->m_handlers.find(name) == m_listener->m_handlers.end())
+        return;
+
+    m_listener->m_metrics->recordGILWait(name, gil_wait);
+    sw.restart();
     bp::object inst = CIMInstance::create(indication);
-    m_listener->call(
-        String(url).substr(1),
-        inst);
+    m_listener->m_metrics->recordConversion(name, sw.elapsedUs());
+
+    m_listener->call(name, inst);
+    m_listener->m_metrics->delivered(name);
+    ++m_listener->m_delivered;
 }
 
 // ----------------------------------------------------------------------------
@@ -112,16 +166,42 @@ CIMIndicationListener::CIMIndicationListener(
     const bp::object &port,
     const bp::object &certfile,
     const bp::object &keyfile,
-    const bp::object &trust_store)
+    const bp::object &trust_store,
+    const bp::object &queue_size,
+    const bp::object &batch_size,
+    const bp::object &batch_latency,
+    const bp::object &overflow_policy,
+    const bp::object &dispatch_threads,
+    const bp::object &ordering,
+    const bp::object &spool,
+    const bp::object &spool_segment_size,
+    const bp::object &spool_segments)
     : m_listener()
     , m_consumer(this)
     , m_handlers()
+    , m_filters(new filter_map_t)
+    , m_throttle()
+    , m_native_handlers(new native_handler_map_t)
+    , m_filters_mutex()
+    , m_filtered(0)
+    , m_coalesced(0)
+    , m_rate_limited(0)
     , m_port(0)
     , m_listen_address()
     , m_certfile()
     , m_keyfile()
     , m_trust_store(Config::defaultTrustStore())
     , m_terminating(false)
+    , m_dispatchers()
+    , m_dispatch_threads(1)
+    , m_ordering(CIMConstants::LISTENER_ORDER_BY_NAME)
+    , m_queue_size(0)
+    , m_batch_size(0)
+    , m_batch_latency(0)
+    , m_overflow_policy(CIMConstants::LISTENER_OVERFLOW_BLOCK)
+    , m_delivered(0)
+    , m_spool()
+    , m_metrics(new ListenerMetrics)
 {
     m_listen_address = StringConv::asString(
         listen_address, "listen_address");
@@ -133,6 +213,53 @@ CIMIndicationListener::CIMIndicationListener(
         m_keyfile = StringConv::asString(keyfile, "keyfile");
     if (!isnone(trust_store))
         m_trust_store = StringConv::asString(trust_store, "trust_store");
+
+    m_queue_size = Conv::as<Pegasus::Uint32>(queue_size, "queue_size");
+    m_batch_size = Conv::as<Pegasus::Uint32>(batch_size, "batch_size");
+    m_batch_latency = Conv::as<Pegasus::Uint32>(batch_latency, "batch_latency");
+    m_overflow_policy = Conv::as<int>(overflow_policy, "overflow_policy");
+    m_dispatch_threads = Conv::as<Pegasus::Uint32>(
+        dispatch_threads, "dispatch_threads");
+    m_ordering = Conv::as<int>(ordering, "ordering");
+
+    if (m_batch_size > 0 && m_queue_size == 0)
+        throw_ValueError("batch_size requires non-zero queue_size");
+    if (m_dispatch_threads == 0)
+        throw_ValueError("dispatch_threads must be positive number");
+    if (m_dispatch_threads > 1 && m_queue_size == 0)
+        throw_ValueError("dispatch_threads requires non-zero queue_size");
+    if (m_ordering != CIMConstants::LISTENER_ORDER_BY_NAME &&
+        m_ordering != CIMConstants::LISTENER_ORDER_BY_SOURCE)
+    {
+        throw_ValueError("Invalid ordering");
+    }
+    if (m_overflow_policy != CIMConstants::LISTENER_OVERFLOW_BLOCK &&
+        m_overflow_policy != CIMConstants::LISTENER_OVERFLOW_DROP_OLDEST &&
+        m_overflow_policy != CIMConstants::LISTENER_OVERFLOW_DROP_NEWEST)
+    {
+        throw_ValueError("Invalid overflow_policy");
+    }
+
+    if (!isnone(spool)) {
+        std::size_t c_segment_size = Conv::as<Pegasus::Uint32>(
+            spool_segment_size, "spool_segment_size");
+        std::size_t c_segments = Conv::as<Pegasus::Uint32>(
+            spool_segments, "spool_segments");
+        if (c_segment_size == 0 || c_segments == 0)
+            throw_ValueError("spool_segment_size and spool_segments must be positive numbers");
+
+        m_spool.reset(new IndicationSpool(
+            StringConv::asString(spool, "spool"),
+            c_segment_size,
+            c_segments));
+    }
+}
+
+CIMIndicationListener::~CIMIndicationListener()
+{
+    // Dispatcher and Pegasus listener threads refer to this object; they
+    // need to be finished before it is freed.
+    stop();
 }
 
 void CIMIndicationListener::init_type()
@@ -140,6 +267,15 @@ void CIMIndicationListener::init_type()
     CIMBase<CIMIndicationListener>::init_type(
         bp::class_<CIMIndicationListener>("CIMIndicationListener", bp::no_init)
             .def(bp::init<
+                const bp::object &,
+                const bp::object &,
+                const bp::object &,
+                const bp::object &,
+                const bp::object &,
+                const bp::object &,
+                const bp::object &,
+                const bp::object &,
+                const bp::object &,
                 const bp::object &,
                 const bp::object &,
                 const bp::object &,
@@ -149,14 +285,58 @@ void CIMIndicationListener::init_type()
                     bp::arg("port"),
                     bp::arg("certfile") = None,
                     bp::arg("keyfile") = None,
-                    bp::arg("trust_store") = None),
+                    bp::arg("trust_store") = None,
+                    bp::arg("queue_size") = 0,
+                    bp::arg("batch_size") = 0,
+                    bp::arg("batch_latency") = 0,
+                    bp::arg("overflow_policy") =
+                        static_cast<int>(CIMConstants::LISTENER_OVERFLOW_BLOCK),
+                    bp::arg("dispatch_threads") = 1,
+                    bp::arg("ordering") =
+                        static_cast<int>(CIMConstants::LISTENER_ORDER_BY_NAME),
+                    bp::arg("spool") = None,
+                    bp::arg("spool_segment_size") = 4 * 1024 * 1024,
+                    bp::arg("spool_segments") = 16),
                     "Constructs a :py:class:`.CIMIndicationListener` object.\n\n"
                     ":param unicode listen_address: bind address\n"
                     ":param int port: listening port\n"
                     ":param unicode certfile: path to X509 certificate\n"
                     ":param unicode keyfile: path to X509 private key; may be None,\n"
                     "\tif cert_file also contains private key\n"
-                    ":param unicode trust_store: path to trust store"))
+                    ":param unicode trust_store: path to trust store\n"
+                    ":param int queue_size: capacity of the indication queue. If\n"
+                    "\tnon-zero, received indications are queued and handlers are\n"
+                    "\tcalled from a dedicated dispatcher thread, so slow handlers\n"
+                    "\tdon't block the listener. If 0, handlers are called directly\n"
+                    "\tfrom the listener threads. Default value is 0.\n"
+                    ":param int batch_size: if non-zero, handlers are called with a\n"
+                    "\tlist of at most batch_size indications instead of a single\n"
+                    "\tindication. Requires non-zero queue_size. Default value is 0.\n"
+                    ":param int batch_latency: maximum time in milliseconds, for which\n"
+                    "\tthe dispatcher waits for a batch to fill up. Default value is 0.\n"
+                    ":param int overflow_policy: what to do, when the queue is full;\n"
+                    "\t:py:data:`.LISTENER_OVERFLOW_BLOCK` blocks the listener thread,\n"
+                    "\t:py:data:`.LISTENER_OVERFLOW_DROP_OLDEST` drops the oldest queued\n"
+                    "\tindication and :py:data:`.LISTENER_OVERFLOW_DROP_NEWEST` drops the\n"
+                    "\treceived one. Default value is :py:data:`.LISTENER_OVERFLOW_BLOCK`.\n"
+                    ":param int dispatch_threads: number of dispatcher threads, each\n"
+                    "\twith its own queue of queue_size indications. Python handlers\n"
+                    "\tstill run one at a time, unless they release the GIL (e.g.\n"
+                    "\tblocking I/O). Default value is 1.\n"
+                    ":param int ordering: indications are distributed among the\n"
+                    "\tdispatcher threads so that handlers get indications in order\n"
+                    "\tof arrival per indication name (:py:data:`.LISTENER_ORDER_BY_NAME`)\n"
+                    "\tor per indication name and SourceInstanceHost property\n"
+                    "\t(:py:data:`.LISTENER_ORDER_BY_SOURCE`). Default value is\n"
+                    "\t:py:data:`.LISTENER_ORDER_BY_NAME`.\n"
+                    ":param str spool: if not None, directory, where received\n"
+                    "\tindications are spooled before they are handled. Spooled\n"
+                    "\tindications can be read by :py:class:`.CIMIndicationSpool`.\n"
+                    "\tDefault value is None.\n"
+                    ":param int spool_segment_size: size of a spool segment file in\n"
+                    "\tbytes. Default value is 4 MiB.\n"
+                    ":param int spool_segments: maximum number of spool segments; the\n"
+                    "\toldest segments are removed. Default value is 16."))
             .def("__repr__", &CIMIndicationListener::repr,
                  ":returns: pretty string of the object")
             .def("start",  &CIMIndicationListener::start,
@@ -166,7 +346,8 @@ void CIMIndicationListener::init_type()
                  ":param int retries: number of bind retries.\n")
             .def("stop", &CIMIndicationListener::stop,
                 "stop()\n\n"
-                "Stops indication listener.")
+                "Stops indication listener. Indications already queued for\n"
+                "dispatcher threads are delivered before it returns.")
             .def("add_handler",
                 lmi::raw_method<CIMIndicationListener>(&CIMIndicationListener::addPyHandler, 1),
                 "add_handler(name, handler, *args, **kwargs)\n\n"
@@ -180,6 +361,61 @@ void CIMIndicationListener::init_type()
                 "Removes a specified handler from indication listener.\n\n"
                 ":param str name: indication name\n"
                 ":raises: :py:exc:`KeyError`")
+            .def("add_forward_handler", &CIMIndicationListener::addPyForwardHandler,
+                (bp::arg("name"),
+                 bp::arg("host"),
+                 bp::arg("port")),
+                "add_forward_handler(name, host, port)\n\n"
+                "Adds native handler, which forwards indications as CIM-XML\n"
+                "INSTANCE elements (one per line) over TCP connection. The handler\n"
+                "does not use Python at all, so it is not slowed down by Python\n"
+                "handlers. Indications are forwarded by dispatcher threads, so the\n"
+                "listener needs to be created with ``queue_size`` greater than 0.\n"
+                "While the target is unreachable, indications are dropped and the\n"
+                "connection is retried with growing delay.\n\n"
+                ":param str name: indication name\n"
+                ":param str host: host to forward the indications to\n"
+                ":param int port: TCP port\n"
+                ":raises: :py:exc:`ValueError`, if the listener has no queue")
+            .def("set_handler_filter", &CIMIndicationListener::setPyHandlerFilter,
+                (bp::arg("name"),
+                 bp::arg("query") = None,
+                 bp::arg("classnames") = None),
+                "set_handler_filter(name, query=None, classnames=None)\n\n"
+                "Sets native filter for indications delivered to handlers of the\n"
+                "name. The filter is evaluated before the indication is converted\n"
+                "into :py:class:`.CIMInstance` and without the GIL held, so\n"
+                "indications which don't match are dropped cheaply.\n\n"
+                ":param str name: indication name\n"
+                ":param str query: WQL query, see ``ClientQuery`` parameter of\n"
+                "\t:py:meth:`.WBEMConnection.EnumerateInstances`. Only WHERE\n"
+                "\tclause is used for filtering.\n"
+                ":param classnames: string or list of strings with class names of\n"
+                "\tindications to deliver. Subclasses don't match.\n\n"
+                "If both query and classnames are None, the filter is removed.")
+            .def("set_throttle", &CIMIndicationListener::setPyThrottle,
+                (bp::arg("dedup_properties") = None,
+                 bp::arg("dedup_window") = 0,
+                 bp::arg("rate") = 0,
+                 bp::arg("burst") = 1),
+                "set_throttle(dedup_properties=None, dedup_window=0, rate=0, burst=1)\n\n"
+                "Sets native stage, which drops repeated indications and limits\n"
+                "rate of indications per source before they are converted into\n"
+                ":py:class:`.CIMInstance`. The stage applies to all indications,\n"
+                "which pass the handler filters.\n\n"
+                ":param list dedup_properties: names of properties, which identify\n"
+                "\tduplicate indications together with indication name and class\n"
+                "\tname. If None, all properties except IndicationIdentifier and\n"
+                "\tIndicationTime are used.\n"
+                ":param int dedup_window: time in milliseconds since the first\n"
+                "\toccurrence, for which duplicates are coalesced; 0 disables\n"
+                "\tdeduplication.\n"
+                ":param float rate: maximum rate of indications per second from one\n"
+                "\tsource (SourceInstanceHost property, or indication name, if not\n"
+                "\tpresent); 0 disables rate limiting.\n"
+                ":param int burst: number of indications from one source, which may\n"
+                "\tbe received at once, exceeding the rate.\n\n"
+                "If both dedup_window and rate are 0, the stage is removed.")
             .add_property("is_alive", &CIMIndicationListener::getIsAlive,
                 "Property storing flag, which indicates, if the indication\n"
                 "listener is running.\n\n"
@@ -198,7 +434,34 @@ void CIMIndicationListener::init_type()
                 ":rtype: int")
             .add_property("handlers", &CIMIndicationListener::getPyHandlers,
                 "Property storing list of strings of handlers.\n\n"
-                ":rtype: list"));
+                ":rtype: list")
+            .add_property("queue_stats", &CIMIndicationListener::getPyQueueStats,
+                "Property storing indication queue counters: number of indications\n"
+                "dropped by filters, coalesced duplicates, rate limited indications,\n"
+                "number of enqueued, delivered and dropped indications, current and\n"
+                "maximum queue depth.\n\n"
+                ":rtype: dict")
+            .def("metrics", &CIMIndicationListener::getPyMetrics,
+                "metrics()\n\n"
+                "Returns snapshot of listener metrics. The dictionary contains\n"
+                "counters from :py:attr:`.queue_stats`, number of received\n"
+                "indications and key 'handlers', which maps handler names to\n"
+                "dictionaries with number of delivered indications and histograms\n"
+                "'gil_wait' (time spent waiting for the GIL), 'conversion' (time\n"
+                "spent converting indications into :py:class:`.CIMInstance`) and\n"
+                "'handler' (time spent in handlers). Each histogram is\n"
+                "a dictionary with 'count', 'total_us', 'max_us' and 'buckets',\n"
+                "list of (upper_bound_us, count) tuples; upper bound of the last\n"
+                "bucket is None.\n\n"
+                ":returns: dictionary of metrics")
+            .def("reset_metrics", &CIMIndicationListener::resetPyMetrics,
+                "reset_metrics()\n\n"
+                "Resets received counter and histograms of the listener metrics.")
+            .add_property("spool", &CIMIndicationListener::getPySpool,
+                "Property storing spool directory and counters of spooled\n"
+                "indications and indications, which could not be spooled; None,\n"
+                "if the spool is not used.\n\n"
+                ":rtype: dict"));
 }
 
 bp::object CIMIndicationListener::repr()
@@ -214,17 +477,38 @@ void CIMIndicationListener::start(const bp::object &retries)
     if (m_listener)
         return;
 
-    m_terminating = false;
+    {
+        ScopedMutex sm(m_mutex);
+        m_terminating = false;
+        if (m_queue_size > 0) {
+            m_dispatchers.clear();
+            for (std::size_t i = 0; i < m_dispatch_threads; ++i) {
+                boost::shared_ptr<IndicationQueue> queue(
+                    new IndicationQueue(m_queue_size, m_overflow_policy));
+                m_dispatchers.push_back(boost::shared_ptr<Dispatcher>(
+                    new Dispatcher(this, queue)));
+            }
+            m_delivered = 0;
+        }
+    }
+
     // Get retries count for port binding. By default, we try only once.
     const int c_retries = Conv::as<int>(retries, "retries");
     if (c_retries < 0)
         throw_ValueError("retries must be positive number");
 
+    if (m_spool && !m_spool->open()) {
+        std::stringstream ss;
+        ss << "Can't open indication spool '" << m_spool->getDirectory()
+           << "': " << strerror(errno);
+        throw_RuntimeError(ss.str());
+    }
+
     // Try to create a listener for retries-times.
     for (int i = 0; !m_listener && i < c_retries; ++i) {
         m_listener.reset(new Pegasus::CIMListener(
 #ifdef HAVE_PEGASUS_LISTENER_WITH_BIND_ADDRESS
-            m_listen_address),
+            m_listen_address,
 #endif
             m_port + static_cast<Pegasus::Uint32>(i)));
 
@@ -270,6 +554,9 @@ void CIMIndicationListener::start(const bp::object &retries)
             }
         }
     }
+
+    if (m_listener)
+        startDispatchers();
 }
 
 void CIMIndicationListener::stop()
@@ -288,8 +575,21 @@ void CIMIndicationListener::stop()
         m_terminating = true;
     }
 
+    // Dispatchers keep running, so listener threads waiting for free space
+    // in the queues can finish.
     m_listener->stop();
     m_listener.reset();
+
+    // Indications in the queues were already acknowledged to the CIMOM;
+    // let the dispatchers deliver them before they exit.
+    dispatcher_list_t::iterator it;
+    for (it = m_dispatchers.begin(); it != m_dispatchers.end(); ++it)
+        (*it)->m_queue->close(false);
+
+    stopDispatchers();
+
+    if (m_spool)
+        m_spool->close();
 }
 
 bool CIMIndicationListener::getIsAlive() const
@@ -365,9 +665,45 @@ void CIMIndicationListener::removePyHandler(const bp::object &name)
 {
     String c_name = StringConv::asString(name, "name");
     handler_map_t::iterator it = m_handlers.find(c_name);
-    if (it == m_handlers.end())
+    bool has_native;
+    {
+        ScopedMutex sm(m_filters_mutex);
+        has_native = m_native_handlers->count(c_name) > 0;
+    }
+
+    if (it == m_handlers.end() && !has_native)
         throw_KeyError("No such handler registered: " + c_name);
-    m_handlers.erase(it);
+    if (it != m_handlers.end())
+        m_handlers.erase(it);
+    setNativeHandlers(c_name, std::list<NativeHandlerPtr>());
+
+    // Drop the filter as well.
+    setFilter(c_name, boost::shared_ptr<IndicationFilter>());
+}
+
+void CIMIndicationListener::addPyForwardHandler(
+    const bp::object &name,
+    const bp::object &host,
+    const bp::object &port)
+{
+    // Forwarding may block on network; keep it off Pegasus listener threads.
+    if (m_queue_size == 0)
+        throw_ValueError("Forwarding handler needs queue_size greater than 0");
+
+    String c_name = StringConv::asString(name, "name");
+    String c_host = StringConv::asString(host, "host");
+    unsigned int c_port = Conv::as<Pegasus::Uint32>(port, "port");
+
+    std::list<NativeHandlerPtr> handlers;
+    {
+        ScopedMutex sm(m_filters_mutex);
+        native_handler_map_t::const_iterator it = m_native_handlers->find(c_name);
+        if (it != m_native_handlers->end())
+            handlers = it->second;
+    }
+
+    handlers.push_back(NativeHandlerPtr(new ForwardingHandler(c_host, c_port)));
+    setNativeHandlers(c_name, handlers);
 }
 
 bp::object CIMIndicationListener::getPyHandlers() const
@@ -379,6 +715,205 @@ bp::object CIMIndicationListener::getPyHandlers() const
     return py_handlers;
 }
 
+void CIMIndicationListener::setPyHandlerFilter(
+    const bp::object &name,
+    const bp::object &query,
+    const bp::object &classnames)
+{
+    String c_name = StringConv::asString(name, "name");
+    boost::shared_ptr<IndicationFilter> filter(new IndicationFilter);
+
+    if (!isnone(query)) {
+        filter->setQuery(boost::shared_ptr<WQLQuery>(
+            new WQLQuery(StringConv::asString(query, "query"))));
+    }
+
+    if (isbasestring(classnames)) {
+        filter->addClassname(StringConv::asString(classnames, "classnames"));
+    } else if (!isnone(classnames)) {
+        bp::list py_classnames(Conv::get<bp::list>(classnames, "classnames"));
+        const int cnt = bp::len(py_classnames);
+        for (int i = 0; i < cnt; ++i) {
+            filter->addClassname(StringConv::asString(
+                py_classnames[i], "classnames[i]"));
+        }
+    }
+
+    if (filter->empty())
+        filter.reset();
+
+    setFilter(c_name, filter);
+}
+
+void CIMIndicationListener::setFilter(
+    const String &name,
+    const boost::shared_ptr<IndicationFilter> &filter)
+{
+    ScopedMutex sm(m_filters_mutex);
+    boost::shared_ptr<filter_map_t> filters(new filter_map_t(*m_filters));
+    if (filter)
+        (*filters)[name] = filter;
+    else
+        filters->erase(name);
+    m_filters = filters;
+}
+
+void CIMIndicationListener::setPyThrottle(
+    const bp::object &dedup_properties,
+    const bp::object &dedup_window,
+    const bp::object &rate,
+    const bp::object &burst)
+{
+    const unsigned int c_dedup_window = Conv::as<Pegasus::Uint32>(
+        dedup_window, "dedup_window");
+    const double c_rate = Conv::as<double>(rate, "rate");
+    const unsigned int c_burst = Conv::as<Pegasus::Uint32>(burst, "burst");
+
+    if (c_rate < 0)
+        throw_ValueError("rate must be positive number");
+
+    boost::shared_ptr<IndicationThrottle> throttle;
+    if (c_dedup_window > 0 || c_rate > 0) {
+        throttle.reset(new IndicationThrottle(c_dedup_window, c_rate, c_burst));
+
+        if (!isnone(dedup_properties)) {
+            bp::list py_properties(Conv::get<bp::list>(
+                dedup_properties, "dedup_properties"));
+            const int cnt = bp::len(py_properties);
+            for (int i = 0; i < cnt; ++i) {
+                throttle->addDedupProperty(StringConv::asString(
+                    py_properties[i], "dedup_properties[i]"));
+            }
+        }
+    }
+
+    ScopedMutex sm(m_filters_mutex);
+    m_throttle = throttle;
+}
+
+bool CIMIndicationListener::admitThrottle(
+    const String &name,
+    const Pegasus::CIMInstance &indication)
+{
+    boost::shared_ptr<IndicationThrottle> throttle;
+    {
+        ScopedMutex sm(m_filters_mutex);
+        throttle = m_throttle;
+    }
+
+    if (!throttle)
+        return true;
+
+    IndicationThrottle::Verdict verdict = throttle->admit(name, indication);
+    if (verdict == IndicationThrottle::ADMIT)
+        return true;
+
+    ScopedMutex sm(m_filters_mutex);
+    if (verdict == IndicationThrottle::DUPLICATE)
+        ++m_coalesced;
+    else
+        ++m_rate_limited;
+    return false;
+}
+
+bool CIMIndicationListener::matchFilter(
+    const String &name,
+    const Pegasus::CIMInstance &indication)
+{
+    boost::shared_ptr<filter_map_t> filters;
+    {
+        ScopedMutex sm(m_filters_mutex);
+        filters = m_filters;
+    }
+
+    filter_map_t::const_iterator it = filters->find(name);
+    if (it == filters->end() || it->second->match(indication))
+        return true;
+
+    ScopedMutex sm(m_filters_mutex);
+    ++m_filtered;
+    return false;
+}
+
+bp::object CIMIndicationListener::getPyQueueStats() const
+{
+    CIMIndicationListener *fake_this = const_cast<CIMIndicationListener*>(this);
+    Pegasus::Uint64 filtered;
+    Pegasus::Uint64 coalesced;
+    Pegasus::Uint64 rate_limited;
+    {
+        ScopedMutex sm(fake_this->m_filters_mutex);
+        filtered = m_filtered;
+        coalesced = m_coalesced;
+        rate_limited = m_rate_limited;
+    }
+
+    Pegasus::Uint64 enqueued = 0;
+    Pegasus::Uint64 dropped = 0;
+    std::size_t depth = 0;
+    std::size_t max_depth = 0;
+    dispatcher_list_t::const_iterator it;
+    for (it = m_dispatchers.begin(); it != m_dispatchers.end(); ++it) {
+        IndicationQueue &queue = *(*it)->m_queue;
+        enqueued += queue.getEnqueued();
+        dropped += queue.getDropped();
+        depth += queue.getDepth();
+        max_depth = std::max(max_depth, queue.getMaxDepth());
+    }
+
+    bp::dict py_stats;
+    py_stats["filtered"] = filtered;
+    py_stats["coalesced"] = coalesced;
+    py_stats["rate_limited"] = rate_limited;
+    py_stats["enqueued"] = enqueued;
+    py_stats["delivered"] = m_delivered;
+    py_stats["dropped"] = dropped;
+    py_stats["depth"] = depth;
+    py_stats["max_depth"] = max_depth;
+    return py_stats;
+}
+
+bp::object CIMIndicationListener::getPyMetrics() const
+{
+    Pegasus::Uint64 received;
+    ListenerMetrics::handler_metrics_t handlers;
+    m_metrics->snapshot(received, handlers);
+
+    bp::dict py_metrics(getPyQueueStats());
+    py_metrics["received"] = received;
+
+    bp::dict py_handlers;
+    ListenerMetrics::handler_metrics_t::const_iterator it;
+    for (it = handlers.begin(); it != handlers.end(); ++it) {
+        bp::dict py_handler;
+        py_handler["delivered"] = it->second.delivered;
+        py_handler["gil_wait"] = histogramAsPyDict(it->second.gil_wait);
+        py_handler["conversion"] = histogramAsPyDict(it->second.conversion);
+        py_handler["handler"] = histogramAsPyDict(it->second.handler);
+        py_handlers[StringConv::asPyUnicode(it->first)] = py_handler;
+    }
+
+    py_metrics["handlers"] = py_handlers;
+    return py_metrics;
+}
+
+void CIMIndicationListener::resetPyMetrics()
+{
+    m_metrics->reset();
+}
+
+bp::object CIMIndicationListener::getPySpool() const
+{
+    if (!m_spool)
+        return None;
+
+    bp::dict py_spool;
+    py_spool["directory"] = StringConv::asPyUnicode(m_spool->getDirectory());
+    py_spool["appended"] = m_spool->getAppended();
+    py_spool["dropped"] = m_spool->getDropped();
+    return py_spool;
+}
+
 void CIMIndicationListener::call(
     const String &name,
     const bp::object &indication) const
@@ -388,7 +923,198 @@ void CIMIndicationListener::call(
     if (it == m_handlers.end())
         return;
 
+    Stopwatch sw;
     std::list<CallableWithParams>::const_iterator it_cb;
     for (it_cb = it->second.begin(); it_cb != it->second.end(); ++it_cb)
         it_cb->call(indication);
+    m_metrics->recordHandler(name, sw.elapsedUs());
+}
+
+CIMIndicationListener::Dispatcher::Dispatcher(
+    CIMIndicationListener *listener,
+    const boost::shared_ptr<IndicationQueue> &queue)
+    : m_listener(listener)
+    , m_queue(queue)
+    , m_thread()
+    , m_running(false)
+{
+}
+
+void CIMIndicationListener::callNative(
+    const String &name,
+    const Pegasus::CIMInstance &indication)
+{
+    boost::shared_ptr<native_handler_map_t> handlers;
+    {
+        ScopedMutex sm(m_filters_mutex);
+        handlers = m_native_handlers;
+    }
+
+    native_handler_map_t::const_iterator it = handlers->find(name);
+    if (it == handlers->end())
+        return;
+
+    std::list<NativeHandlerPtr>::const_iterator it_handler;
+    for (it_handler = it->second.begin(); it_handler != it->second.end(); ++it_handler)
+        (*it_handler)->handle(name, indication);
+}
+
+void CIMIndicationListener::setNativeHandlers(
+    const String &name,
+    const std::list<NativeHandlerPtr> &handlers)
+{
+    ScopedMutex sm(m_filters_mutex);
+    boost::shared_ptr<native_handler_map_t> native_handlers(
+        new native_handler_map_t(*m_native_handlers));
+    if (handlers.empty())
+        native_handlers->erase(name);
+    else
+        (*native_handlers)[name] = handlers;
+    m_native_handlers = native_handlers;
+}
+
+String CIMIndicationListener::orderingKey(
+    const String &name,
+    const Pegasus::CIMInstance &indication) const
+{
+    if (m_ordering != CIMConstants::LISTENER_ORDER_BY_SOURCE)
+        return name;
+
+    Pegasus::Uint32 idx = indication.findProperty(
+        Pegasus::CIMName("SourceInstanceHost"));
+    if (idx == PEG_NOT_FOUND)
+        return name;
+
+    Pegasus::CIMValue value(indication.getProperty(idx).getValue());
+    if (value.isNull() || value.isArray() ||
+        value.getType() != Pegasus::CIMTYPE_STRING)
+    {
+        return name;
+    }
+
+    Pegasus::String source;
+    value.get(source);
+    return name + ":" + String(source);
+}
+
+boost::shared_ptr<IndicationQueue> CIMIndicationListener::queueFor(
+    const String &name,
+    const Pegasus::CIMInstance &indication)
+{
+    ScopedMutex sm(m_mutex);
+    if (m_terminating || m_dispatchers.empty())
+        return boost::shared_ptr<IndicationQueue>();
+
+    std::size_t idx = 0;
+    if (m_dispatchers.size() > 1) {
+        boost::hash<std::string> hasher;
+        idx = hasher(orderingKey(name, indication)) % m_dispatchers.size();
+    }
+
+    return m_dispatchers[idx]->m_queue;
+}
+
+void *CIMIndicationListener::dispatch(void *dispatcher)
+{
+    Dispatcher *disp = static_cast<Dispatcher*>(dispatcher);
+    CIMIndicationListener *listener = disp->m_listener;
+    const std::size_t batch_size = std::max<std::size_t>(listener->m_batch_size, 1);
+    IndicationQueue::batch_t batch;
+
+    while (disp->m_queue->pop(batch, batch_size, listener->m_batch_latency)) {
+        // Native handlers go first; they don't need the GIL.
+        IndicationQueue::batch_t::const_iterator it;
+        for (it = batch.begin(); it != batch.end(); ++it)
+            listener->callNative(it->name, it->indication);
+
+        Stopwatch sw;
+        ScopedGILAcquire sg;
+        const Pegasus::Uint64 gil_wait = sw.elapsedUs();
+        std::set<String> names;
+        for (it = batch.begin(); it != batch.end(); ++it) {
+            if (listener->m_handlers.find(it->name) != listener->m_handlers.end() &&
+                names.insert(it->name).second)
+            {
+                listener->m_metrics->recordGILWait(it->name, gil_wait);
+            }
+        }
+
+        listener->deliver(batch);
+    }
+
+    return NULL;
+}
+
+void CIMIndicationListener::deliver(const IndicationQueue::batch_t &batch)
+{
+    IndicationQueue::batch_t::const_iterator it;
+
+    if (m_batch_size == 0) {
+        for (it = batch.begin(); it != batch.end(); ++it) {
+            // Don't convert indications nobody listens to.
+            if (m_handlers.find(it->name) == m_handlers.end())
+                continue;
+
+            Stopwatch sw;
+            bp::object inst = CIMInstance::create(it->indication);
+            m_metrics->recordConversion(it->name, sw.elapsedUs());
+
+            call(it->name, inst);
+            m_metrics->delivered(it->name);
+            ++m_delivered;
+        }
+        return;
+    }
+
+    // Group the indications by handler name; order of arrival is kept.
+    std::map<String, bp::list> py_batches;
+    for (it = batch.begin(); it != batch.end(); ++it) {
+        if (m_handlers.find(it->name) == m_handlers.end())
+            continue;
+
+        Stopwatch sw;
+        py_batches[it->name].append(CIMInstance::create(it->indication));
+        m_metrics->recordConversion(it->name, sw.elapsedUs());
+        m_metrics->delivered(it->name);
+        ++m_delivered;
+    }
+
+    std::map<String, bp::list>::const_iterator it_batch;
+    for (it_batch = py_batches.begin(); it_batch != py_batches.end(); ++it_batch)
+        call(it_batch->first, it_batch->second);
+}
+
+void CIMIndicationListener::startDispatchers()
+{
+    dispatcher_list_t::iterator it;
+    for (it = m_dispatchers.begin(); it != m_dispatchers.end(); ++it) {
+        Dispatcher &disp = **it;
+        if (disp.m_running)
+            continue;
+
+        if (pthread_create(&disp.m_thread, NULL,
+            &CIMIndicationListener::dispatch, &disp) != 0)
+        {
+            // Leave the listener in consistent state.
+            stop();
+            throw_RuntimeError("Can't create indication dispatcher thread");
+        }
+
+        disp.m_running = true;
+    }
+}
+
+void CIMIndicationListener::stopDispatchers()
+{
+    // The queues are already closed; dispatchers drain them and exit. GIL
+    // needs to be released by the caller.
+    dispatcher_list_t::iterator it;
+    for (it = m_dispatchers.begin(); it != m_dispatchers.end(); ++it) {
+        Dispatcher &disp = **it;
+        if (!disp.m_running)
+            continue;
+
+        pthread_join(disp.m_thread, NULL);
+        disp.m_running = false;
+    }
 }
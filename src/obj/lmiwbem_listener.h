@@ -22,12 +22,21 @@
 #ifndef   LMIWBEM_LISTENER_H
 #  define LMIWBEM_LISTENER_H
 
+#  include <cstddef>
 #  include <map>
+#  include <vector>
 #  include <Pegasus/Consumer/CIMIndicationConsumer.h>
 #  include "lmiwbem.h"
 #  include <boost/python/object.hpp>
 #  include <boost/shared_ptr.hpp>
+#  include "lmiwbem_mutex.h"
 #  include "obj/lmiwbem_cimbase.h"
+#  include "obj/lmiwbem_listener_filter.h"
+#  include "obj/lmiwbem_listener_handler.h"
+#  include "obj/lmiwbem_listener_metrics.h"
+#  include "obj/lmiwbem_listener_queue.h"
+#  include "obj/lmiwbem_listener_spool.h"
+#  include "obj/lmiwbem_listener_throttle.h"
 #  include "obj/cim/lmiwbem_instance.h"
 #  include "util/lmiwbem_string.h"
 
@@ -45,6 +54,16 @@ typedef std::map<
     std::list<CallableWithParams>
 > handler_map_t;
 
+typedef std::map<
+    String,
+    boost::shared_ptr<IndicationFilter>
+> filter_map_t;
+
+typedef std::map<
+    String,
+    std::list<NativeHandlerPtr>
+> native_handler_map_t;
+
 class CallableWithParams
 {
 public:
@@ -88,7 +107,17 @@ public:
         const bp::object &port,
         const bp::object &certfile,
         const bp::object &keyfile,
-        const bp::object &trust_store);
+        const bp::object &trust_store,
+        const bp::object &queue_size,
+        const bp::object &batch_size,
+        const bp::object &batch_latency,
+        const bp::object &overflow_policy,
+        const bp::object &dispatch_threads,
+        const bp::object &ordering,
+        const bp::object &spool,
+        const bp::object &spool_segment_size,
+        const bp::object &spool_segments);
+    ~CIMIndicationListener();
 
     static void init_type();
 
@@ -107,7 +136,24 @@ public:
 
     bp::object addPyHandler(const bp::tuple &args, const bp::dict &kwds);
     void removePyHandler(const bp::object &name);
+    void addPyForwardHandler(
+        const bp::object &name,
+        const bp::object &host,
+        const bp::object &port);
     bp::object getPyHandlers() const;
+    void setPyHandlerFilter(
+        const bp::object &name,
+        const bp::object &query,
+        const bp::object &classnames);
+    void setPyThrottle(
+        const bp::object &dedup_properties,
+        const bp::object &dedup_window,
+        const bp::object &rate,
+        const bp::object &burst);
+    bp::object getPyQueueStats() const;
+    bp::object getPySpool() const;
+    bp::object getPyMetrics() const;
+    void resetPyMetrics();
 
 private:
     friend class CIMIndicationConsumer;
@@ -115,18 +161,85 @@ private:
         const String &name,
         const bp::object &indication) const;
 
+    // Evaluated by Pegasus listener threads without the GIL.
+    bool matchFilter(const String &name, const Pegasus::CIMInstance &indication);
+    void setFilter(
+        const String &name,
+        const boost::shared_ptr<IndicationFilter> &filter);
+    bool admitThrottle(const String &name, const Pegasus::CIMInstance &indication);
+
+    // Called without the GIL.
+    void callNative(const String &name, const Pegasus::CIMInstance &indication);
+    void setNativeHandlers(
+        const String &name,
+        const std::list<NativeHandlerPtr> &handlers);
+
+    // Dispatcher threads delivering queued indications to the handlers. Each
+    // dispatcher has its own queue; indications with the same ordering key
+    // always go to the same queue, so they are delivered in order.
+    class Dispatcher
+    {
+    public:
+        Dispatcher(
+            CIMIndicationListener *listener,
+            const boost::shared_ptr<IndicationQueue> &queue);
+
+        CIMIndicationListener *m_listener;
+        boost::shared_ptr<IndicationQueue> m_queue;
+        pthread_t m_thread;
+        bool m_running;
+    };
+
+    typedef std::vector<boost::shared_ptr<Dispatcher> > dispatcher_list_t;
+
+    String orderingKey(
+        const String &name,
+        const Pegasus::CIMInstance &indication) const;
+    boost::shared_ptr<IndicationQueue> queueFor(
+        const String &name,
+        const Pegasus::CIMInstance &indication);
+
+    static void *dispatch(void *dispatcher);
+    void deliver(const IndicationQueue::batch_t &batch);
+    void startDispatchers();
+    void stopDispatchers();
+
     boost::shared_ptr<Pegasus::CIMListener> m_listener;
     CIMIndicationConsumer m_consumer;
 
     handler_map_t m_handlers;
 
+    // Filters, throttle and native handlers are replaced as a whole
+    // (copy-on-write), so the listener threads hold m_filters_mutex only to
+    // get the current objects.
+    boost::shared_ptr<filter_map_t> m_filters;
+    boost::shared_ptr<IndicationThrottle> m_throttle;
+    boost::shared_ptr<native_handler_map_t> m_native_handlers;
+    Mutex m_filters_mutex;
+    Pegasus::Uint64 m_filtered;
+    Pegasus::Uint64 m_coalesced;
+    Pegasus::Uint64 m_rate_limited;
+
     Pegasus::Uint32 m_port;
     String m_listen_address;
     String m_certfile;
     String m_keyfile;
     String m_trust_store;
-    Mutex m_mutex;          // A guard for m_terminating flag.
+    Mutex m_mutex;          // A guard for m_terminating flag and m_dispatchers.
     bool m_terminating;
+
+    dispatcher_list_t m_dispatchers;
+    std::size_t m_dispatch_threads;
+    int m_ordering;
+    std::size_t m_queue_size;
+    std::size_t m_batch_size;
+    unsigned int m_batch_latency;
+    int m_overflow_policy;
+    Pegasus::Uint64 m_delivered;
+
+    // Set in constructor only; used by listener threads.
+    boost::shared_ptr<IndicationSpool> m_spool;
+    boost::shared_ptr<ListenerMetrics> m_metrics;
 };
 
 #endif // LMIWBEM_LISTENER_H
@@ -0,0 +1,55 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include "obj/lmiwbem_listener_filter.h"
+
+IndicationFilter::IndicationFilter()
+    : m_classnames()
+    , m_query()
+{
+}
+
+void IndicationFilter::addClassname(const String &classname)
+{
+    m_classnames.insert(lowerCase(classname));
+}
+
+void IndicationFilter::setQuery(const boost::shared_ptr<WQLQuery> &query)
+{
+    m_query = query;
+}
+
+bool IndicationFilter::match(const Pegasus::CIMInstance &indication) const
+{
+    if (!m_classnames.empty()) {
+        String classname(indication.getClassName().getString());
+        if (m_classnames.find(lowerCase(classname)) == m_classnames.end())
+            return false;
+    }
+
+    return !m_query || m_query->evaluate(indication);
+}
+
+bool IndicationFilter::empty() const
+{
+    return m_classnames.empty() && !m_query;
+}
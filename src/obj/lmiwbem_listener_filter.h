@@ -0,0 +1,54 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_LISTENER_FILTER_H
+#  define LMIWBEM_LISTENER_FILTER_H
+
+#  include <set>
+#  include <boost/shared_ptr.hpp>
+#  include <Pegasus/Common/CIMInstance.h>
+#  include "lmiwbem.h"
+#  include "util/lmiwbem_string.h"
+#  include "util/lmiwbem_wql.h"
+
+// Native indication filter evaluated on Pegasus::CIMInstance before the
+// indication is converted into a Python object, therefore it can be
+// evaluated without holding the GIL. Indication matches, if its class name
+// is one of the class names (if any given) and the WQL condition (if any
+// given) is satisfied.
+class IndicationFilter
+{
+public:
+    IndicationFilter();
+
+    void addClassname(const String &classname);
+    void setQuery(const boost::shared_ptr<WQLQuery> &query);
+
+    bool match(const Pegasus::CIMInstance &indication) const;
+
+    bool empty() const;
+
+private:
+    std::set<String> m_classnames;
+    boost::shared_ptr<WQLQuery> m_query;
+};
+
+#endif // LMIWBEM_LISTENER_FILTER_H
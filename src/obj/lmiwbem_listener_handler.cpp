@@ -0,0 +1,170 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <Pegasus/Common/Buffer.h>
+#include <Pegasus/Common/XmlWriter.h>
+extern "C" {
+#  include <fcntl.h>
+#  include <netdb.h>
+#  include <poll.h>
+#  include <sys/socket.h>
+#  include <sys/time.h>
+#  include <sys/types.h>
+#  include <unistd.h>
+}
+#include "obj/lmiwbem_listener_handler.h"
+
+NativeHandler::~NativeHandler()
+{
+}
+
+ForwardingHandler::ForwardingHandler(const String &host, unsigned int port)
+    : m_host(host)
+    , m_port(port)
+    , m_fd(-1)
+    , m_backoff(0)
+    , m_since_failure()
+    , m_mutex()
+{
+}
+
+ForwardingHandler::~ForwardingHandler()
+{
+    disconnect();
+}
+
+void ForwardingHandler::handle(
+    const String &name,
+    const Pegasus::CIMInstance &indication)
+{
+    Pegasus::Buffer buffer;
+    Pegasus::XmlWriter::appendInstanceElement(buffer, indication);
+    buffer.append('\n');
+
+    // Dispatcher threads share the connection.
+    ScopedMutex sm(m_mutex);
+    if (m_fd < 0) {
+        // Target is down; drop the indications until the next attempt.
+        if (m_backoff > 0 && m_since_failure.elapsedUs() < m_backoff * 1000)
+            return;
+
+        if (!connect()) {
+            m_backoff *= 2;
+            if (m_backoff < MIN_BACKOFF)
+                m_backoff = MIN_BACKOFF;
+            else if (m_backoff > MAX_BACKOFF)
+                m_backoff = MAX_BACKOFF;
+            m_since_failure.restart();
+            return;
+        }
+
+        m_backoff = 0;
+    }
+
+    if (!send(buffer.getData(), buffer.size()))
+        disconnect();
+}
+
+String ForwardingHandler::repr() const
+{
+    std::stringstream ss;
+    ss << "ForwardingHandler(host=u'" << m_host << "', port=" << m_port << ')';
+    return ss.str();
+}
+
+bool ForwardingHandler::connect()
+{
+    std::stringstream ss;
+    ss << m_port;
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *result = NULL;
+    if (getaddrinfo(m_host.c_str(), ss.str().c_str(), &hints, &result) != 0)
+        return false;
+
+    for (struct addrinfo *rp = result; rp && m_fd < 0; rp = rp->ai_next) {
+        m_fd = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+        if (m_fd < 0)
+            continue;
+
+        // Connect without blocking longer than CONNECT_TIMEOUT.
+        const int flags = fcntl(m_fd, F_GETFL);
+        fcntl(m_fd, F_SETFL, flags | O_NONBLOCK);
+        bool connected = ::connect(m_fd, rp->ai_addr, rp->ai_addrlen) == 0;
+        if (!connected && errno == EINPROGRESS) {
+            struct pollfd pfd = { m_fd, POLLOUT, 0 };
+            if (poll(&pfd, 1, CONNECT_TIMEOUT) > 0) {
+                int so_error = 0;
+                socklen_t len = sizeof(so_error);
+                getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &so_error, &len);
+                connected = so_error == 0;
+            }
+        }
+
+        if (!connected) {
+            disconnect();
+            continue;
+        }
+
+        // Sending blocks again, but not forever.
+        fcntl(m_fd, F_SETFL, flags);
+        struct timeval tv;
+        tv.tv_sec = SEND_TIMEOUT / 1000;
+        tv.tv_usec = (SEND_TIMEOUT % 1000) * 1000;
+        setsockopt(m_fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    }
+
+    freeaddrinfo(result);
+    return m_fd >= 0;
+}
+
+void ForwardingHandler::disconnect()
+{
+    if (m_fd < 0)
+        return;
+
+    close(m_fd);
+    m_fd = -1;
+}
+
+bool ForwardingHandler::send(const char *data, std::size_t size)
+{
+    while (size > 0) {
+        ssize_t sent = ::send(m_fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return false;
+
+        data += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+
+    return true;
+}
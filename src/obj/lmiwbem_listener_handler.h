@@ -0,0 +1,87 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_LISTENER_HANDLER_H
+#  define LMIWBEM_LISTENER_HANDLER_H
+
+#  include <cstddef>
+#  include <boost/shared_ptr.hpp>
+#  include <Pegasus/Common/CIMInstance.h>
+#  include "lmiwbem.h"
+#  include "lmiwbem_mutex.h"
+#  include "util/lmiwbem_histogram.h"
+#  include "util/lmiwbem_string.h"
+
+// Indication handler implemented in C++. Native handlers are called without
+// the GIL, possibly from several listener threads at once.
+class NativeHandler
+{
+public:
+    virtual ~NativeHandler();
+
+    virtual void handle(
+        const String &name,
+        const Pegasus::CIMInstance &indication) = 0;
+
+    virtual String repr() const = 0;
+};
+
+typedef boost::shared_ptr<NativeHandler> NativeHandlerPtr;
+
+// Forwards indications as CIM-XML INSTANCE elements, one per line, over TCP
+// connection. Connection is established lazily and re-established after
+// failure; indications, which can't be sent, are dropped. Connecting and
+// sending block for a bounded time only, so the handler is called from
+// dispatcher threads, never from Pegasus listener threads.
+class ForwardingHandler: public NativeHandler
+{
+public:
+    ForwardingHandler(const String &host, unsigned int port);
+    virtual ~ForwardingHandler();
+
+    virtual void handle(
+        const String &name,
+        const Pegasus::CIMInstance &indication);
+
+    virtual String repr() const;
+
+private:
+    // Timeouts in milliseconds.
+    static const int CONNECT_TIMEOUT = 1000;
+    static const int SEND_TIMEOUT = 5000;
+    // Delay between reconnection attempts grows from MIN_BACKOFF up to
+    // MAX_BACKOFF milliseconds.
+    static const Pegasus::Uint64 MIN_BACKOFF = 100;
+    static const Pegasus::Uint64 MAX_BACKOFF = 30000;
+
+    bool connect();
+    void disconnect();
+    bool send(const char *data, std::size_t size);
+
+    String m_host;
+    unsigned int m_port;
+    int m_fd;
+    Pegasus::Uint64 m_backoff;
+    Stopwatch m_since_failure;
+    Mutex m_mutex;
+};
+
+#endif // LMIWBEM_LISTENER_HANDLER_H
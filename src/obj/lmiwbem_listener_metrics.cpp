@@ -0,0 +1,84 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include "obj/lmiwbem_listener_metrics.h"
+
+ListenerMetrics::HandlerMetrics::HandlerMetrics()
+    : delivered(0)
+    , gil_wait()
+    , conversion()
+    , handler()
+{
+}
+
+ListenerMetrics::ListenerMetrics()
+    : m_mutex()
+    , m_received(0)
+    , m_handlers()
+{
+}
+
+void ListenerMetrics::received()
+{
+    ScopedMutex sm(m_mutex);
+    ++m_received;
+}
+
+void ListenerMetrics::delivered(const String &name, std::size_t cnt)
+{
+    ScopedMutex sm(m_mutex);
+    m_handlers[name].delivered += cnt;
+}
+
+void ListenerMetrics::recordGILWait(const String &name, Pegasus::Uint64 us)
+{
+    ScopedMutex sm(m_mutex);
+    m_handlers[name].gil_wait.record(us);
+}
+
+void ListenerMetrics::recordConversion(const String &name, Pegasus::Uint64 us)
+{
+    ScopedMutex sm(m_mutex);
+    m_handlers[name].conversion.record(us);
+}
+
+void ListenerMetrics::recordHandler(const String &name, Pegasus::Uint64 us)
+{
+    ScopedMutex sm(m_mutex);
+    m_handlers[name].handler.record(us);
+}
+
+void ListenerMetrics::snapshot(
+    Pegasus::Uint64 &received,
+    handler_metrics_t &handlers)
+{
+    ScopedMutex sm(m_mutex);
+    received = m_received;
+    handlers = m_handlers;
+}
+
+void ListenerMetrics::reset()
+{
+    ScopedMutex sm(m_mutex);
+    m_received = 0;
+    m_handlers.clear();
+}
@@ -0,0 +1,67 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_LISTENER_METRICS_H
+#  define LMIWBEM_LISTENER_METRICS_H
+
+#  include <cstddef>
+#  include <map>
+#  include <Pegasus/Common/Config.h>
+#  include "lmiwbem.h"
+#  include "lmiwbem_mutex.h"
+#  include "util/lmiwbem_histogram.h"
+#  include "util/lmiwbem_string.h"
+
+// Counters and histograms of CIMIndicationListener. Updated both from
+// listener threads without the GIL and from threads holding it.
+class ListenerMetrics
+{
+public:
+    struct HandlerMetrics
+    {
+        HandlerMetrics();
+
+        Pegasus::Uint64 delivered;
+        Histogram gil_wait;
+        Histogram conversion;
+        Histogram handler;
+    };
+
+    typedef std::map<String, HandlerMetrics> handler_metrics_t;
+
+    ListenerMetrics();
+
+    void received();
+    void delivered(const String &name, std::size_t cnt = 1);
+    void recordGILWait(const String &name, Pegasus::Uint64 us);
+    void recordConversion(const String &name, Pegasus::Uint64 us);
+    void recordHandler(const String &name, Pegasus::Uint64 us);
+
+    void snapshot(Pegasus::Uint64 &received, handler_metrics_t &handlers);
+    void reset();
+
+private:
+    Mutex m_mutex;
+    Pegasus::Uint64 m_received;
+    handler_metrics_t m_handlers;
+};
+
+#endif // LMIWBEM_LISTENER_METRICS_H
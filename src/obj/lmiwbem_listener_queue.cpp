@@ -0,0 +1,172 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include <time.h>
+#include "obj/cim/lmiwbem_constants.h"
+#include "obj/lmiwbem_listener_queue.h"
+
+namespace {
+
+// Uses monotonic clock, so the result is not affected by changes of the
+// wall clock.
+unsigned int elapsedMs(const struct timespec &since)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since.tv_sec) * 1000 +
+        (now.tv_nsec - since.tv_nsec) / 1000000;
+}
+
+} // unnamed namespace
+
+IndicationQueue::Item::Item(
+    const String &name,
+    const Pegasus::CIMInstance &indication)
+    : name(name)
+    , indication(indication)
+{
+}
+
+IndicationQueue::IndicationQueue(std::size_t capacity, int overflow_policy)
+    : m_mutex()
+    , m_not_empty()
+    , m_not_full()
+    , m_items()
+    , m_capacity(capacity)
+    , m_overflow_policy(overflow_policy)
+    , m_closed(false)
+    , m_enqueued(0)
+    , m_dropped(0)
+    , m_max_depth(0)
+{
+}
+
+bool IndicationQueue::push(
+    const String &name,
+    const Pegasus::CIMInstance &indication)
+{
+    ScopedMutex sm(m_mutex);
+    bool dropped = false;
+
+    while (!m_closed && m_items.size() >= m_capacity) {
+        if (m_overflow_policy == CIMConstants::LISTENER_OVERFLOW_DROP_NEWEST) {
+            ++m_dropped;
+            return false;
+        } else if (m_overflow_policy == CIMConstants::LISTENER_OVERFLOW_DROP_OLDEST) {
+            m_items.pop_front();
+            ++m_dropped;
+            dropped = true;
+        } else {
+            // Block the Pegasus listener thread until the dispatcher catches
+            // up.
+            m_not_full.wait(m_mutex);
+        }
+    }
+
+    if (m_closed) {
+        ++m_dropped;
+        return false;
+    }
+
+    m_items.push_back(Item(name, indication));
+    ++m_enqueued;
+    if (m_items.size() > m_max_depth)
+        m_max_depth = m_items.size();
+
+    m_not_empty.signal();
+    return !dropped;
+}
+
+bool IndicationQueue::pop(
+    batch_t &batch,
+    std::size_t batch_size,
+    unsigned int latency)
+{
+    ScopedMutex sm(m_mutex);
+
+    while (!m_closed && m_items.empty())
+        m_not_empty.wait(m_mutex);
+
+    // Let the batch fill up, but don't hold the indications longer than
+    // latency milliseconds.
+    if (latency > 0) {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        while (!m_closed && m_items.size() < batch_size) {
+            unsigned int elapsed = elapsedMs(start);
+            if (elapsed >= latency ||
+                !m_not_empty.timedWait(m_mutex, latency - elapsed))
+            {
+                break;
+            }
+        }
+    }
+
+    // Closed queue is drained first.
+    if (m_items.empty())
+        return false;
+
+    batch.clear();
+    while (!m_items.empty() && batch.size() < batch_size) {
+        batch.push_back(m_items.front());
+        m_items.pop_front();
+    }
+
+    m_not_full.broadcast();
+    return true;
+}
+
+void IndicationQueue::close(bool discard)
+{
+    ScopedMutex sm(m_mutex);
+    if (discard) {
+        m_dropped += m_items.size();
+        m_items.clear();
+    }
+    m_closed = true;
+    m_not_empty.broadcast();
+    m_not_full.broadcast();
+}
+
+Pegasus::Uint64 IndicationQueue::getEnqueued()
+{
+    ScopedMutex sm(m_mutex);
+    return m_enqueued;
+}
+
+Pegasus::Uint64 IndicationQueue::getDropped()
+{
+    ScopedMutex sm(m_mutex);
+    return m_dropped;
+}
+
+std::size_t IndicationQueue::getDepth()
+{
+    ScopedMutex sm(m_mutex);
+    return m_items.size();
+}
+
+std::size_t IndicationQueue::getMaxDepth()
+{
+    ScopedMutex sm(m_mutex);
+    return m_max_depth;
+}
@@ -0,0 +1,84 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_LISTENER_QUEUE_H
+#  define LMIWBEM_LISTENER_QUEUE_H
+
+#  include <cstddef>
+#  include <deque>
+#  include <vector>
+#  include <Pegasus/Common/CIMInstance.h>
+#  include "lmiwbem.h"
+#  include "lmiwbem_mutex.h"
+#  include "util/lmiwbem_string.h"
+
+// Bounded queue of received indications. Pegasus listener threads push the
+// indications, dispatcher thread of CIMIndicationListener pops them in
+// batches. None of the methods touches Python objects, so the GIL does not
+// need to be held.
+class IndicationQueue
+{
+public:
+    struct Item
+    {
+        Item(const String &name, const Pegasus::CIMInstance &indication);
+
+        String name;
+        Pegasus::CIMInstance indication;
+    };
+
+    typedef std::vector<Item> batch_t;
+
+    IndicationQueue(std::size_t capacity, int overflow_policy);
+
+    // Returns false, if the indication (or some other, depending on overflow
+    // policy) was dropped.
+    bool push(const String &name, const Pegasus::CIMInstance &indication);
+
+    // Blocks until there is an indication in the queue; then waits at most
+    // latency milliseconds to fill the batch with batch_size indications.
+    // Returns false, if the queue has been closed and drained.
+    bool pop(batch_t &batch, std::size_t batch_size, unsigned int latency);
+
+    // Refuses new indications and wakes up all the waiting threads. Queued
+    // indications are still handed out by pop(), unless discard is set.
+    void close(bool discard);
+
+    Pegasus::Uint64 getEnqueued();
+    Pegasus::Uint64 getDropped();
+    std::size_t getDepth();
+    std::size_t getMaxDepth();
+
+private:
+    Mutex m_mutex;
+    Condition m_not_empty;
+    Condition m_not_full;
+    std::deque<Item> m_items;
+    std::size_t m_capacity;
+    int m_overflow_policy;
+    bool m_closed;
+
+    Pegasus::Uint64 m_enqueued;
+    Pegasus::Uint64 m_dropped;
+    std::size_t m_max_depth;
+};
+
+#endif // LMIWBEM_LISTENER_QUEUE_H
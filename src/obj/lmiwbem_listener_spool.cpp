@@ -0,0 +1,564 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <Pegasus/Common/Buffer.h>
+#include <Pegasus/Common/XmlParser.h>
+#include <Pegasus/Common/XmlReader.h>
+#include <Pegasus/Common/XmlWriter.h>
+#include <boost/python/class.hpp>
+#include <boost/python/list.hpp>
+#include <boost/python/tuple.hpp>
+extern "C" {
+#  include <dirent.h>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <sys/types.h>
+#  include <unistd.h>
+}
+#include "lmiwbem_config.h"
+#include "lmiwbem_exception.h"
+#include "obj/lmiwbem_listener_spool.h"
+#include "obj/cim/lmiwbem_instance.h"
+#include "util/lmiwbem_convert.h"
+#include "util/lmiwbem_util.h"
+
+namespace {
+
+// Each record starts with this header followed by the indication name and
+// CIM-XML INSTANCE element. The magic is written last, so readers never see
+// incomplete records. Segments are zero-filled, so zero magic marks the end
+// of written data.
+struct RecordHeader
+{
+    Pegasus::Uint32 magic;
+    Pegasus::Uint32 name_size;
+    Pegasus::Uint32 data_size;
+    Pegasus::Uint32 reserved;
+};
+
+const Pegasus::Uint32 RECORD_MAGIC = 0x4c4d4931; // "LMI1"
+
+const char SEGMENT_PREFIX[] = "segment-";
+const char SEGMENT_SUFFIX[] = ".spool";
+const char CHECKPOINT_SUFFIX[] = ".checkpoint";
+
+std::size_t recordSize(std::size_t name_size, std::size_t data_size)
+{
+    // Keep the headers aligned.
+    std::size_t size = sizeof(RecordHeader) + name_size + data_size;
+    return (size + 7) & ~static_cast<std::size_t>(7);
+}
+
+String segmentPath(const String &directory, Pegasus::Uint64 seq)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx",
+        static_cast<unsigned long long>(seq));
+    return directory + "/" + SEGMENT_PREFIX + name + SEGMENT_SUFFIX;
+}
+
+// Returns sorted sequence numbers of segments present in the directory.
+std::vector<Pegasus::Uint64> listSegments(const String &directory)
+{
+    std::vector<Pegasus::Uint64> segments;
+    DIR *dir = opendir(directory.c_str());
+    if (!dir)
+        return segments;
+
+    const std::size_t prefix_len = sizeof(SEGMENT_PREFIX) - 1;
+    const std::size_t suffix_len = sizeof(SEGMENT_SUFFIX) - 1;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        std::string name(entry->d_name);
+        if (name.size() <= prefix_len + suffix_len ||
+            name.compare(0, prefix_len, SEGMENT_PREFIX) != 0 ||
+            name.compare(name.size() - suffix_len, suffix_len, SEGMENT_SUFFIX) != 0)
+        {
+            continue;
+        }
+
+        std::string seq(name.substr(prefix_len, name.size() - prefix_len - suffix_len));
+        char *end;
+        unsigned long long value = strtoull(seq.c_str(), &end, 16);
+        if (*end != '\0')
+            continue;
+        segments.push_back(static_cast<Pegasus::Uint64>(value));
+    }
+
+    closedir(dir);
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+} // unnamed namespace
+
+IndicationSpool::IndicationSpool(
+    const String &directory,
+    std::size_t segment_size,
+    std::size_t max_segments)
+    : m_directory(directory)
+    , m_segment_size(segment_size)
+    , m_max_segments(max_segments)
+    , m_fd(-1)
+    , m_data(NULL)
+    , m_offset(0)
+    , m_seq(0)
+    , m_appended(0)
+    , m_dropped(0)
+    , m_open(false)
+    , m_mutex()
+{
+}
+
+IndicationSpool::~IndicationSpool()
+{
+    close();
+}
+
+bool IndicationSpool::open()
+{
+    ScopedMutex sm(m_mutex);
+    if (m_data)
+        return true;
+
+    if (mkdir(m_directory.c_str(), 0700) != 0 && errno != EEXIST)
+        return false;
+
+    // Never append to existing segments; readers may have consumed them
+    // partially. Continue with a new segment instead.
+    std::vector<Pegasus::Uint64> segments(listSegments(m_directory));
+    m_seq = segments.empty() ? 0 : segments.back() + 1;
+    m_open = createSegment();
+    return m_open;
+}
+
+void IndicationSpool::close()
+{
+    ScopedMutex sm(m_mutex);
+    closeSegment();
+    m_open = false;
+}
+
+bool IndicationSpool::append(
+    const String &name,
+    const Pegasus::CIMInstance &indication)
+{
+    // Serialize outside of the critical section.
+    Pegasus::Buffer buffer;
+    Pegasus::XmlWriter::appendInstanceElement(buffer, indication);
+
+    const std::size_t size = recordSize(name.size(), buffer.size());
+
+    ScopedMutex sm(m_mutex);
+    if (!m_open)
+        return false;
+
+    if (size > m_segment_size) {
+        ++m_dropped;
+        return false;
+    }
+
+    if (m_data && m_offset + size > m_segment_size) {
+        closeSegment();
+        ++m_seq;
+    }
+
+    // Segment is missing after rotation or a previous failure.
+    if (!m_data && !createSegment()) {
+        // Don't retry the same file name, if it exists.
+        if (errno == EEXIST)
+            ++m_seq;
+        ++m_dropped;
+        return false;
+    }
+
+    RecordHeader *header = reinterpret_cast<RecordHeader*>(m_data + m_offset);
+    char *payload = m_data + m_offset + sizeof(RecordHeader);
+    memcpy(payload, name.c_str(), name.size());
+    memcpy(payload + name.size(), buffer.getData(), buffer.size());
+    header->name_size = static_cast<Pegasus::Uint32>(name.size());
+    header->data_size = static_cast<Pegasus::Uint32>(buffer.size());
+    header->reserved = 0;
+
+    // Publish the record.
+    __sync_synchronize();
+    header->magic = RECORD_MAGIC;
+
+    m_offset += size;
+    ++m_appended;
+    return true;
+}
+
+String IndicationSpool::getDirectory() const
+{
+    return m_directory;
+}
+
+Pegasus::Uint64 IndicationSpool::getAppended()
+{
+    ScopedMutex sm(m_mutex);
+    return m_appended;
+}
+
+Pegasus::Uint64 IndicationSpool::getDropped()
+{
+    ScopedMutex sm(m_mutex);
+    return m_dropped;
+}
+
+bool IndicationSpool::createSegment()
+{
+    const String path(segmentPath(m_directory, m_seq));
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (m_fd < 0)
+        return false;
+
+    if (ftruncate(m_fd, m_segment_size) != 0) {
+        int saved_errno = errno;
+        ::close(m_fd);
+        unlink(path.c_str());
+        m_fd = -1;
+        errno = saved_errno;
+        return false;
+    }
+
+    void *data = mmap(NULL, m_segment_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED) {
+        int saved_errno = errno;
+        ::close(m_fd);
+        unlink(path.c_str());
+        m_fd = -1;
+        errno = saved_errno;
+        return false;
+    }
+
+    m_data = static_cast<char*>(data);
+    m_offset = 0;
+    removeOldSegments();
+    return true;
+}
+
+void IndicationSpool::closeSegment()
+{
+    if (m_data) {
+        msync(m_data, m_segment_size, MS_ASYNC);
+        munmap(m_data, m_segment_size);
+        m_data = NULL;
+    }
+
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+void IndicationSpool::removeOldSegments()
+{
+    std::vector<Pegasus::Uint64> segments(listSegments(m_directory));
+    if (segments.size() <= m_max_segments)
+        return;
+
+    std::size_t cnt = segments.size() - m_max_segments;
+    for (std::size_t i = 0; i < cnt; ++i)
+        unlink(segmentPath(m_directory, segments[i]).c_str());
+}
+
+// ----------------------------------------------------------------------------
+
+CIMIndicationSpool::CIMIndicationSpool(
+    const bp::object &directory,
+    const bp::object &consumer)
+    : m_directory()
+    , m_consumer()
+    , m_fd(-1)
+    , m_data(NULL)
+    , m_size(0)
+    , m_seq(0)
+    , m_offset(0)
+    , m_commit_seq(0)
+    , m_commit_offset(0)
+    , m_lost_segments(0)
+{
+    m_directory = StringConv::asString(directory, "directory");
+    m_consumer = StringConv::asString(consumer, "consumer");
+
+    if (m_consumer.empty() || m_consumer.find('/') != String::npos)
+        throw_ValueError("Invalid consumer name: " + m_consumer);
+
+    std::ifstream checkpoint(checkpointPath().c_str());
+    if (checkpoint >> m_commit_seq >> m_commit_offset) {
+        m_seq = m_commit_seq;
+        m_offset = m_commit_offset;
+    } else {
+        // New consumer starts with the oldest segment.
+        std::vector<Pegasus::Uint64> segments(listSegments(m_directory));
+        if (!segments.empty())
+            m_seq = m_commit_seq = segments.front();
+    }
+}
+
+CIMIndicationSpool::~CIMIndicationSpool()
+{
+    unmapSegment();
+}
+
+void CIMIndicationSpool::init_type()
+{
+    CIMBase<CIMIndicationSpool>::init_type(
+        bp::class_<CIMIndicationSpool>("CIMIndicationSpool", bp::no_init)
+            .def(bp::init<
+                const bp::object &,
+                const bp::object &>((
+                    bp::arg("directory"),
+                    bp::arg("consumer") = "default"),
+                    "Constructs a :py:class:`.CIMIndicationSpool` object, which\n"
+                    "reads indications spooled by :py:class:`.CIMIndicationListener`.\n"
+                    "Reading starts at the last committed position of the consumer.\n\n"
+                    ":param str directory: spool directory\n"
+                    ":param str consumer: consumer name; each consumer has its own\n"
+                    "\tcheckpoint. Default value is 'default'."))
+            .def("__repr__", &CIMIndicationSpool::repr,
+                 ":returns: pretty string of the object")
+            .def("read", &CIMIndicationSpool::read,
+                (bp::arg("max_cnt") = 0),
+                "read(max_cnt=0)\n\n"
+                "Reads spooled indications following the current position.\n\n"
+                ":param int max_cnt: maximum number of indications to read; 0\n"
+                "\tmeans all available indications\n"
+                ":returns: list of (name, :py:class:`.CIMInstance`) tuples")
+            .def("commit", &CIMIndicationSpool::commit,
+                "commit()\n\n"
+                "Stores current position as the consumer's checkpoint.")
+            .def("rewind", &CIMIndicationSpool::rewind,
+                "rewind()\n\n"
+                "Returns to the last committed position.")
+            .add_property("directory", &CIMIndicationSpool::getPyDirectory,
+                "Property storing spool directory.\n\n"
+                ":rtype: unicode")
+            .add_property("consumer", &CIMIndicationSpool::getPyConsumer,
+                "Property storing consumer name.\n\n"
+                ":rtype: unicode")
+            .add_property("lost_segments", &CIMIndicationSpool::getPyLostSegments,
+                "Property storing number of segments, which were removed by\n"
+                "the listener before they were read.\n\n"
+                ":rtype: int"));
+}
+
+bp::object CIMIndicationSpool::repr()
+{
+    std::stringstream ss;
+    ss << "CIMIndicationSpool(directory=u'" << m_directory
+       << "', consumer=u'" << m_consumer << "')";
+    return StringConv::asPyUnicode(ss.str());
+}
+
+bp::object CIMIndicationSpool::read(const bp::object &max_cnt) try
+{
+    const std::size_t c_max_cnt = Conv::as<Pegasus::Uint32>(max_cnt, "max_cnt");
+    bp::list py_indications;
+    std::size_t cnt = 0;
+
+    while (c_max_cnt == 0 || cnt < c_max_cnt) {
+        if (!m_data && !mapSegment())
+            break;
+
+        if (!hasRecord()) {
+            // The segment is complete, once the listener moves on to the
+            // next one. Check for a record written in between.
+            if (!hasNextSegment())
+                break;
+            if (hasRecord())
+                continue;
+
+            unmapSegment();
+            ++m_seq;
+            m_offset = 0;
+            continue;
+        }
+
+        const RecordHeader *header =
+            reinterpret_cast<const RecordHeader*>(m_data + m_offset);
+        __sync_synchronize();
+
+        const std::size_t size = recordSize(header->name_size, header->data_size);
+        if (m_offset + size > m_size)
+            throw_RuntimeError("Corrupted indication spool segment: " +
+                segmentPath(m_directory, m_seq));
+
+        const char *payload = m_data + m_offset + sizeof(RecordHeader);
+        String name(std::string(payload, header->name_size));
+
+        // XmlParser needs mutable null-terminated buffer.
+        std::vector<char> data(
+            payload + header->name_size,
+            payload + header->name_size + header->data_size);
+        data.push_back('\0');
+
+        Pegasus::XmlParser parser(&data[0]);
+        Pegasus::CIMInstance indication;
+        Pegasus::XmlReader::getInstanceElement(parser, indication);
+
+        py_indications.append(
+            bp::make_tuple(
+                StringConv::asPyUnicode(name),
+                CIMInstance::create(indication)));
+
+        m_offset += size;
+        ++cnt;
+    }
+
+    return py_indications;
+} catch (...) {
+    std::stringstream ss;
+    if (Config::isVerbose())
+        ss << "CIMIndicationSpool.read()";
+    handle_all_exceptions(ss);
+    return None;
+}
+
+void CIMIndicationSpool::commit()
+{
+    const String path(checkpointPath());
+    const String tmp_path(path + ".tmp");
+
+    // Replace the checkpoint atomically.
+    {
+        std::ofstream checkpoint(tmp_path.c_str(), std::ios::trunc);
+        checkpoint << m_seq << ' ' << m_offset << '\n';
+        checkpoint.flush();
+        if (!checkpoint)
+            throw_RuntimeError("Can't write checkpoint: " + tmp_path);
+    }
+
+    if (rename(tmp_path.c_str(), path.c_str()) != 0)
+        throw_RuntimeError("Can't write checkpoint: " + path);
+
+    m_commit_seq = m_seq;
+    m_commit_offset = m_offset;
+}
+
+void CIMIndicationSpool::rewind()
+{
+    if (m_seq != m_commit_seq)
+        unmapSegment();
+
+    m_seq = m_commit_seq;
+    m_offset = m_commit_offset;
+}
+
+bp::object CIMIndicationSpool::getPyDirectory() const
+{
+    return StringConv::asPyUnicode(m_directory);
+}
+
+bp::object CIMIndicationSpool::getPyConsumer() const
+{
+    return StringConv::asPyUnicode(m_consumer);
+}
+
+bp::object CIMIndicationSpool::getPyLostSegments() const
+{
+    return bp::object(m_lost_segments);
+}
+
+bool CIMIndicationSpool::mapSegment()
+{
+    std::vector<Pegasus::Uint64> segments(listSegments(m_directory));
+    std::vector<Pegasus::Uint64>::const_iterator it = std::lower_bound(
+        segments.begin(), segments.end(), m_seq);
+    if (it == segments.end())
+        return false;
+
+    if (*it != m_seq) {
+        // The listener removed segments we haven't read yet.
+        m_lost_segments += *it - m_seq;
+        m_seq = *it;
+        m_offset = 0;
+    }
+
+    m_fd = ::open(segmentPath(m_directory, m_seq).c_str(), O_RDONLY);
+    if (m_fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || st.st_size == 0) {
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED) {
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    m_data = static_cast<char*>(data);
+    m_size = st.st_size;
+    return true;
+}
+
+void CIMIndicationSpool::unmapSegment()
+{
+    if (m_data) {
+        munmap(m_data, m_size);
+        m_data = NULL;
+        m_size = 0;
+    }
+
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool CIMIndicationSpool::hasRecord() const
+{
+    if (m_offset + sizeof(RecordHeader) > m_size)
+        return false;
+
+    const RecordHeader *header =
+        reinterpret_cast<const RecordHeader*>(m_data + m_offset);
+    return header->magic == RECORD_MAGIC;
+}
+
+bool CIMIndicationSpool::hasNextSegment() const
+{
+    std::vector<Pegasus::Uint64> segments(listSegments(m_directory));
+    return !segments.empty() && segments.back() > m_seq;
+}
+
+String CIMIndicationSpool::checkpointPath() const
+{
+    return m_directory + "/" + m_consumer + CHECKPOINT_SUFFIX;
+}
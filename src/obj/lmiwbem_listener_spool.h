@@ -0,0 +1,119 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_LISTENER_SPOOL_H
+#  define LMIWBEM_LISTENER_SPOOL_H
+
+#  include <cstddef>
+#  include <Pegasus/Common/CIMInstance.h>
+#  include <boost/python/object.hpp>
+#  include "lmiwbem.h"
+#  include "lmiwbem_mutex.h"
+#  include "obj/lmiwbem_cimbase.h"
+#  include "util/lmiwbem_string.h"
+
+namespace bp = boost::python;
+
+// Durable ring buffer of received indications. Indications are appended to
+// memory-mapped segment files of fixed size. When the current segment is
+// full, a new one is created and the oldest segments over the limit are
+// removed. Readers (see CIMIndicationSpool) may run in other processes.
+class IndicationSpool
+{
+public:
+    IndicationSpool(
+        const String &directory,
+        std::size_t segment_size,
+        std::size_t max_segments);
+    ~IndicationSpool();
+
+    // Returns false and sets errno on failure.
+    bool open();
+    void close();
+
+    // Called by listener threads without the GIL. If a segment could not be
+    // created, the indication is counted as dropped and the creation is
+    // retried with the next indication.
+    bool append(const String &name, const Pegasus::CIMInstance &indication);
+
+    String getDirectory() const;
+    Pegasus::Uint64 getAppended();
+    Pegasus::Uint64 getDropped();
+
+private:
+    bool createSegment();
+    void closeSegment();
+    void removeOldSegments();
+
+    String m_directory;
+    std::size_t m_segment_size;
+    std::size_t m_max_segments;
+    int m_fd;
+    char *m_data;
+    std::size_t m_offset;
+    Pegasus::Uint64 m_seq;
+    Pegasus::Uint64 m_appended;
+    Pegasus::Uint64 m_dropped;
+    // Set between open() and close(), even if there is no segment mapped.
+    bool m_open;
+    Mutex m_mutex;
+};
+
+class CIMIndicationSpool: public CIMBase<CIMIndicationSpool>
+{
+public:
+    CIMIndicationSpool(
+        const bp::object &directory,
+        const bp::object &consumer);
+    ~CIMIndicationSpool();
+
+    static void init_type();
+
+    bp::object repr();
+
+    bp::object read(const bp::object &max_cnt);
+    void commit();
+    void rewind();
+
+    bp::object getPyDirectory() const;
+    bp::object getPyConsumer() const;
+    bp::object getPyLostSegments() const;
+
+private:
+    bool mapSegment();
+    void unmapSegment();
+    bool hasRecord() const;
+    bool hasNextSegment() const;
+    String checkpointPath() const;
+
+    String m_directory;
+    String m_consumer;
+    int m_fd;
+    char *m_data;
+    std::size_t m_size;
+    Pegasus::Uint64 m_seq;
+    std::size_t m_offset;
+    Pegasus::Uint64 m_commit_seq;
+    std::size_t m_commit_offset;
+    Pegasus::Uint64 m_lost_segments;
+};
+
+#endif // LMIWBEM_LISTENER_SPOOL_H
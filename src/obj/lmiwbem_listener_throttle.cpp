@@ -0,0 +1,187 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include <algorithm>
+#include <sstream>
+#include <Pegasus/Common/CIMProperty.h>
+#include <Pegasus/Common/CIMValue.h>
+#include <time.h>
+#include "obj/lmiwbem_listener_throttle.h"
+
+namespace {
+
+// Monotonic clock; differences of the values must not wrap, when the wall
+// clock is set back.
+Pegasus::Uint64 nowMs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<Pegasus::Uint64>(now.tv_sec) * 1000 +
+        now.tv_nsec / 1000000;
+}
+
+String sourceOf(const String &name, const Pegasus::CIMInstance &indication)
+{
+    Pegasus::Uint32 idx = indication.findProperty(
+        Pegasus::CIMName("SourceInstanceHost"));
+    if (idx == PEG_NOT_FOUND)
+        return name;
+
+    Pegasus::CIMValue value(indication.getProperty(idx).getValue());
+    if (value.isNull() || value.isArray() ||
+        value.getType() != Pegasus::CIMTYPE_STRING)
+    {
+        return name;
+    }
+
+    Pegasus::String source;
+    value.get(source);
+    return String(source);
+}
+
+void appendKeyPart(std::stringstream &ss, const String &part)
+{
+    ss << part.size() << ':' << part;
+}
+
+} // unnamed namespace
+
+IndicationThrottle::IndicationThrottle(
+    unsigned int dedup_window,
+    double rate,
+    unsigned int burst)
+    : m_dedup_properties()
+    , m_dedup_window(dedup_window)
+    , m_rate(rate)
+    , m_burst(std::max(static_cast<double>(burst), 1.0))
+    , m_mutex()
+    , m_seen()
+    , m_buckets()
+    , m_last_purge(0)
+{
+}
+
+void IndicationThrottle::addDedupProperty(const String &property)
+{
+    m_dedup_properties.insert(lowerCase(property));
+}
+
+IndicationThrottle::Verdict IndicationThrottle::admit(
+    const String &name,
+    const Pegasus::CIMInstance &indication)
+{
+    // Compute the key and the source outside of the critical section.
+    const String key(m_dedup_window > 0 ? dedupKey(name, indication) : String());
+    const String source(m_rate > 0 ? sourceOf(name, indication) : String());
+
+    ScopedMutex sm(m_mutex);
+    const Pegasus::Uint64 now = nowMs();
+    purge(now);
+
+    if (m_dedup_window > 0) {
+        std::map<String, Pegasus::Uint64>::iterator it = m_seen.find(key);
+        if (it != m_seen.end() && now - it->second < m_dedup_window)
+            return DUPLICATE;
+    }
+
+    if (m_rate > 0) {
+        std::map<String, Bucket>::iterator it = m_buckets.find(source);
+        if (it == m_buckets.end()) {
+            Bucket bucket = { m_burst, now };
+            it = m_buckets.insert(std::make_pair(source, bucket)).first;
+        }
+
+        Bucket &bucket = it->second;
+        bucket.tokens = std::min(
+            m_burst, bucket.tokens + (now - bucket.last) * m_rate / 1000.0);
+        bucket.last = now;
+        if (bucket.tokens < 1.0)
+            return RATE_LIMITED;
+        bucket.tokens -= 1.0;
+    }
+
+    // Remember only admitted indications, so duplicates don't extend the
+    // window forever.
+    if (m_dedup_window > 0)
+        m_seen[key] = now;
+
+    return ADMIT;
+}
+
+String IndicationThrottle::dedupKey(
+    const String &name,
+    const Pegasus::CIMInstance &indication) const
+{
+    // Each part is prefixed by its length, so different indications can't
+    // produce the same key.
+    std::stringstream ss;
+    appendKeyPart(ss, name);
+    appendKeyPart(ss, lowerCase(indication.getClassName().getString()));
+
+    const Pegasus::Uint32 cnt = indication.getPropertyCount();
+    for (Pegasus::Uint32 i = 0; i < cnt; ++i) {
+        Pegasus::CIMConstProperty property(indication.getProperty(i));
+        String property_name(lowerCase(property.getName().getString()));
+        if (!isDedupProperty(property_name))
+            continue;
+
+        appendKeyPart(ss, property_name);
+        appendKeyPart(ss, property.getValue().toString());
+    }
+
+    return ss.str();
+}
+
+bool IndicationThrottle::isDedupProperty(const String &property) const
+{
+    if (!m_dedup_properties.empty())
+        return m_dedup_properties.find(property) != m_dedup_properties.end();
+
+    // These differ for every indication.
+    return property != "indicationidentifier" && property != "indicationtime";
+}
+
+void IndicationThrottle::purge(Pegasus::Uint64 now)
+{
+    // Purge at most once per second.
+    if (now - m_last_purge < 1000)
+        return;
+    m_last_purge = now;
+
+    std::map<String, Pegasus::Uint64>::iterator it_seen = m_seen.begin();
+    while (it_seen != m_seen.end()) {
+        if (now - it_seen->second >= m_dedup_window)
+            m_seen.erase(it_seen++);
+        else
+            ++it_seen;
+    }
+
+    // Buckets, which would be full by now, are the same as new ones.
+    std::map<String, Bucket>::iterator it_bucket = m_buckets.begin();
+    while (it_bucket != m_buckets.end()) {
+        const Bucket &bucket = it_bucket->second;
+        if (bucket.tokens + (now - bucket.last) * m_rate / 1000.0 >= m_burst)
+            m_buckets.erase(it_bucket++);
+        else
+            ++it_bucket;
+    }
+}
@@ -0,0 +1,87 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_LISTENER_THROTTLE_H
+#  define LMIWBEM_LISTENER_THROTTLE_H
+
+#  include <cstddef>
+#  include <map>
+#  include <set>
+#  include <Pegasus/Common/CIMInstance.h>
+#  include "lmiwbem.h"
+#  include "lmiwbem_mutex.h"
+#  include "util/lmiwbem_string.h"
+
+// Native stage, which suppresses repeated indications and limits rate of
+// indications per source, before they are converted into Python objects.
+//
+// Indications are considered identical, if they have the same name, class
+// name and values of the deduplication properties (all properties except
+// IndicationIdentifier and IndicationTime, if no properties are given).
+// Duplicates within dedup_window milliseconds from the first occurrence are
+// coalesced. Rate is limited by a token bucket per source, which is the
+// SourceInstanceHost property, or the indication name, if not present.
+class IndicationThrottle
+{
+public:
+    enum Verdict {
+        ADMIT,
+        DUPLICATE,
+        RATE_LIMITED
+    };
+
+    IndicationThrottle(
+        unsigned int dedup_window,
+        double rate,
+        unsigned int burst);
+
+    void addDedupProperty(const String &property);
+
+    // Called by listener threads without the GIL.
+    Verdict admit(const String &name, const Pegasus::CIMInstance &indication);
+
+private:
+    struct Bucket
+    {
+        double tokens;
+        Pegasus::Uint64 last;
+    };
+
+    String dedupKey(
+        const String &name,
+        const Pegasus::CIMInstance &indication) const;
+    bool isDedupProperty(const String &property) const;
+    void purge(Pegasus::Uint64 now);
+
+    std::set<String> m_dedup_properties;
+    unsigned int m_dedup_window;
+    double m_rate;
+    double m_burst;
+
+    Mutex m_mutex;
+    // Canonical keys of recently admitted indications; hashes alone could
+    // collide and drop distinct indications.
+    std::map<String, Pegasus::Uint64> m_seen;
+    std::map<String, Bucket> m_buckets;
+    Pegasus::Uint64 m_last_purge;
+};
+
+#endif // LMIWBEM_LISTENER_THROTTLE_H
@@ -87,7 +87,8 @@ void NocaseDict::init_type()
             (bp::arg("key"),
              bp::arg("def") = None),
             "pop(key, default_value)")
-        .def("copy", &NocaseDict::copy, "copy()"));
+        .def("copy", &NocaseDict::copy, "copy()")
+        .def("__sizeof__", &Census<NocaseDict>::sizeOf));
 }
 
 bp::object NocaseDict::create()
@@ -302,6 +303,22 @@ bp::object NocaseDict::copy()
     return py_inst;
 }
 
+std::size_t NocaseDict::heapSize() const
+{
+    std::size_t size = 0;
+    nocase_map_t::const_iterator it;
+    for (it = m_dict.begin(); it != m_dict.end(); ++it) {
+        size += MemSize::MAP_NODE_OVERHEAD + sizeof(nocase_map_t::value_type) +
+            MemSize::of(it->first);
+    }
+    return size;
+}
+
+std::size_t NocaseDict::lazySize() const
+{
+    return 0;
+}
+
 #  if PY_MAJOR_VERSION < 3
 int NocaseDict::cmp(const bp::object &other)
 {
@@ -27,6 +27,7 @@
 #  include <boost/python/object.hpp>
 #  include "lmiwbem.h"
 #  include "lmiwbem_cimbase.h"
+#  include "util/lmiwbem_census.h"
 #  include "util/lmiwbem_convert.h"
 #  include "util/lmiwbem_string.h"
 
@@ -47,7 +48,9 @@ public:
     bool operator ()(const String &a, const String &b) const;
 };
 
-class NocaseDict: public CIMBase<NocaseDict>
+class NocaseDict:
+    public CIMBase<NocaseDict>,
+    public Census<NocaseDict>
 {
 public:
     NocaseDict();
@@ -92,6 +95,11 @@ public:
 
     bp::object copy();
 
+    // Memory owned by native members and by unevaluated Pegasus objects;
+    // see Census.
+    std::size_t heapSize() const;
+    std::size_t lazySize() const;
+
 #  if PY_MAJOR_VERSION < 3
     int cmp(const bp::object &other);
 #  else
@@ -133,29 +133,44 @@ SLPBoolean SLP::attrCallback(
     if (errcode == SLP_OK) {
         bp::dict &py_attrs = *static_cast<bp::dict *>(cookie);
 
-        std::stringstream ss(attrlist);
-        String item;
+        slp_attrs_t attrs;
+        bool good = parseAttrs(attrlist, attrs);
 
-        while (std::getline(ss, item, ',')) {
-            std::size_t pos = item.find("=", 0, 1);
+        slp_attrs_t::const_iterator it;
+        for (it = attrs.begin(); it != attrs.end(); ++it)
+            py_attrs[it->first] = it->second;
 
-            // Basic check of the attribute's format.
-            if (item[0] != '(' ||
-                item[item.length() - 1] != ')' ||
-                pos == String::npos)
-            {
-                return SLP_FALSE;
-            }
+        if (!good)
+            return SLP_FALSE;
+    }
 
-            // Cut the key and value of the attribute.
-            String key = item.substr(1, pos - 1);
-            String val = item.substr(pos + 1, item.length() - pos - 2);
+    return SLP_TRUE;
+}
+
+bool SLP::parseAttrs(const char *attrlist, slp_attrs_t &attrs)
+{
+    std::stringstream ss(attrlist);
+    String item;
 
-            py_attrs[key] = val;
+    while (std::getline(ss, item, ',')) {
+        std::size_t pos = item.find("=", 0, 1);
+
+        // Basic check of the attribute's format.
+        if (item[0] != '(' ||
+            item[item.length() - 1] != ')' ||
+            pos == String::npos)
+        {
+            return false;
         }
+
+        // Cut the key and value of the attribute.
+        String key = item.substr(1, pos - 1);
+        String val = item.substr(pos + 1, item.length() - pos - 2);
+
+        attrs[key] = val;
     }
 
-    return SLP_TRUE;
+    return true;
 }
 
 bp::object SLP::discover(
@@ -22,6 +22,7 @@
 #ifndef   LMIWBEM_SLP_H
 #  define LMIWBEM_SLP_H
 
+#  include <map>
 #  include <slp.h>
 #  include "lmiwbem.h"
 #  include "obj/lmiwbem_cimbase.h"
@@ -33,6 +34,8 @@ BOOST_PYTHON_END
 
 namespace bp = boost::python;
 
+typedef std::map<String, String> slp_attrs_t;
+
 class ScopedSLPHandle
 {
 public:
@@ -71,6 +74,10 @@ public:
         SLPError errcode,
         void *cookie);
 
+    // Parses SLP attribute list "(key=value),...". Returns false, if the
+    // list is malformed.
+    static bool parseAttrs(const char *attrlist, slp_attrs_t &attrs);
+
     static bp::object discover(
         const bp::object &srvtype,
         const bp::object &scopelist,
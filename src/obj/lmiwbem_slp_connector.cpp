@@ -0,0 +1,406 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <boost/python/class.hpp>
+#include <boost/python/tuple.hpp>
+#include <Pegasus/Common/Exception.h>
+extern "C" {
+#  include <fcntl.h>
+#  include <netdb.h>
+#  include <poll.h>
+#  include <sys/socket.h>
+#  include <sys/types.h>
+#  include <unistd.h>
+}
+#include "lmiwbem_config.h"
+#include "lmiwbem_exception.h"
+#include "lmiwbem_gil.h"
+#include "lmiwbem_urlinfo.h"
+#include "obj/lmiwbem_connection.h"
+#include "obj/lmiwbem_slp.h"
+#include "obj/lmiwbem_slp_connector.h"
+#include "util/lmiwbem_convert.h"
+#include "util/lmiwbem_util.h"
+
+namespace {
+
+// Builds WBEM URL from SLP service; service:wbem:https://host:port has
+// service type "service:wbem:https".
+String serviceURL(const SLPResult &service)
+{
+    const String srvtype(service.getSrvType());
+    const std::size_t pos = srvtype.rfind(':');
+    String scheme(pos == String::npos ? srvtype : String(srvtype.substr(pos + 1)));
+    if (scheme != "http" && scheme != "https")
+        scheme = "https";
+
+    std::stringstream ss;
+    ss << scheme << "://";
+    if (service.getHost().find(':') != String::npos)
+        ss << '[' << service.getHost() << ']';
+    else
+        ss << service.getHost();
+    if (service.getPort() > 0)
+        ss << ':' << service.getPort();
+    return ss.str();
+}
+
+// Tries to establish TCP connection within timeout (in milliseconds).
+bool isReachable(
+    const String &hostname,
+    unsigned int port,
+    unsigned int timeout,
+    String &error)
+{
+    std::stringstream ss;
+    ss << port;
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *result;
+    int rv = getaddrinfo(hostname.c_str(), ss.str().c_str(), &hints, &result);
+    if (rv != 0) {
+        error = gai_strerror(rv);
+        return false;
+    }
+
+    bool reachable = false;
+    for (struct addrinfo *ai = result; ai && !reachable; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            error = strerror(errno);
+            continue;
+        }
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        rv = ::connect(fd, ai->ai_addr, ai->ai_addrlen);
+        if (rv == 0) {
+            reachable = true;
+        } else if (errno == EINPROGRESS) {
+            struct pollfd pfd = { fd, POLLOUT, 0 };
+            rv = poll(&pfd, 1, static_cast<int>(timeout));
+            if (rv == 0) {
+                error = "Connection timed out";
+            } else if (rv > 0) {
+                int so_error = 0;
+                socklen_t len = sizeof(so_error);
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_error, &len);
+                if (so_error == 0)
+                    reachable = true;
+                else
+                    error = strerror(so_error);
+            } else {
+                error = strerror(errno);
+            }
+        } else {
+            error = strerror(errno);
+        }
+
+        close(fd);
+    }
+
+    freeaddrinfo(result);
+    return reachable;
+}
+
+} // unnamed namespace
+
+SLPConnector::Target::Target()
+    : hostname()
+    , port(0)
+    , conn(NULL)
+    , error()
+{
+}
+
+SLPConnector::SLPConnector(
+    const bp::object &services,
+    const bp::object &creds,
+    const bp::object &x509,
+    const bp::object &default_namespace,
+    const bp::object &no_verification,
+    const bp::object &timeout,
+    const bp::object &threads)
+    : m_targets()
+    , m_py_services()
+    , m_py_conns()
+    , m_trust_store(Config::defaultTrustStore())
+    , m_timeout(0)
+    , m_mutex()
+    , m_cond()
+    , m_next(0)
+    , m_ready()
+    , m_failed()
+    , m_active(0)
+    , m_cancelled(false)
+    , m_workers()
+{
+    m_timeout = Conv::as<Pegasus::Uint32>(timeout, "timeout");
+    std::size_t c_threads = Conv::as<Pegasus::Uint32>(threads, "threads");
+    if (c_threads == 0)
+        throw_ValueError("threads must be positive number");
+
+    // Connections are created here, with the GIL held; workers only connect
+    // them.
+    bp::list py_services(Conv::get<bp::list>(services, "services"));
+    const int cnt = bp::len(py_services);
+    for (int i = 0; i < cnt; ++i) {
+        const SLPResult &service = SLPResult::asNative(
+            py_services[i], "services[i]");
+        const String url(serviceURL(service));
+
+        bp::object py_conn = CIMBase<WBEMConnection>::type()(
+            StringConv::asPyUnicode(url),
+            creds,
+            x509,
+            default_namespace,
+            no_verification);
+
+        Target target;
+        URLInfo url_info;
+        if (url_info.set(url)) {
+            target.hostname = url_info.hostname();
+            target.port = url_info.port();
+            target.conn = &WBEMConnection::asNative(py_conn);
+        } else {
+            target.error = "Invalid locator";
+        }
+
+        m_py_services.append(py_services[i]);
+        m_py_conns.append(py_conn);
+        m_targets.push_back(target);
+    }
+
+    for (std::size_t i = 0; i < m_targets.size(); ++i) {
+        if (!m_targets[i].conn)
+            m_failed.push_back(i);
+    }
+
+    // Workers may finish before all of them are started; count them as
+    // active in advance.
+    c_threads = std::min(c_threads, m_targets.size());
+    {
+        ScopedMutex sm(m_mutex);
+        m_active = c_threads;
+    }
+
+    for (std::size_t i = 0; i < c_threads; ++i) {
+        pthread_t worker;
+        if (pthread_create(&worker, NULL, &SLPConnector::work, this) != 0) {
+            // Remaining workers won't be started.
+            ScopedMutex sm(m_mutex);
+            m_active -= c_threads - i;
+            if (m_active == 0)
+                m_cond.broadcast();
+            break;
+        }
+        m_workers.push_back(worker);
+    }
+
+    if (m_workers.empty() && !m_targets.empty())
+        throw_RuntimeError("Can't create SLP connector thread");
+}
+
+SLPConnector::~SLPConnector()
+{
+    cancel();
+
+    // Connection attempts may block until their timeout expires.
+    ScopedGILRelease sr;
+    std::vector<pthread_t>::iterator it;
+    for (it = m_workers.begin(); it != m_workers.end(); ++it)
+        pthread_join(*it, NULL);
+}
+
+void SLPConnector::init_type()
+{
+    CIMBase<SLPConnector>::init_type(
+        bp::class_<SLPConnector>("SLPConnector", bp::no_init)
+        .def(bp::init<
+            const bp::object &,
+            const bp::object &,
+            const bp::object &,
+            const bp::object &,
+            const bp::object &,
+            const bp::object &,
+            const bp::object &>((
+                bp::arg("services"),
+                bp::arg("creds") = None,
+                bp::arg("x509") = None,
+                bp::arg("default_namespace") = None,
+                bp::arg("no_verification") = false,
+                bp::arg("timeout") = 5000,
+                bp::arg("threads") = 8),
+                "Connects to services found by SLP discovery in background.\n"
+                "The object is an iterator over connected\n"
+                ":py:class:`.WBEMConnection` objects, which yields the\n"
+                "connections as soon as they are up. Unreachable services don't\n"
+                "block the others. The GIL is released while waiting.\n\n"
+                ":param list services: list of :py:class:`.SLPResult`\n"
+                ":param tuple creds: tuple containing username and password\n"
+                ":param dict x509: see :py:class:`.WBEMConnection`\n"
+                ":param str default_namespace: default namespace of the connections\n"
+                ":param bool no_verification: see :py:class:`.WBEMConnection`\n"
+                ":param int timeout: reachability check timeout in milliseconds.\n"
+                "\tDefault value is 5000.\n"
+                ":param int threads: number of services connected in parallel.\n"
+                "\tDefault value is 8."))
+        .def("__repr__", &SLPConnector::repr)
+        .def("__iter__", &SLPConnector::iter)
+#  if PY_MAJOR_VERSION < 3
+        .def("next", &SLPConnector::next)
+#  else
+        .def("__next__", &SLPConnector::next)
+#  endif // PY_MAJOR_VERSION
+        .def("cancel", &SLPConnector::cancel,
+            "cancel()\n\n"
+            "Cancels pending connection attempts.")
+        .add_property("failures", &SLPConnector::getPyFailures,
+            "Property storing list of (:py:class:`.SLPResult`, error message)\n"
+            "tuples of services, which could not be connected to so far.\n\n"
+            ":rtype: list"));
+}
+
+bp::object SLPConnector::repr()
+{
+    std::stringstream ss;
+    ss << "SLPConnector(services=" << m_targets.size() << ", ...)";
+    return StringConv::asPyUnicode(ss.str());
+}
+
+bp::object SLPConnector::iter(const bp::object &self)
+{
+    return self;
+}
+
+bp::object SLPConnector::next()
+{
+    std::size_t idx = 0;
+    bool has_conn = false;
+
+    {
+        ScopedGILRelease sr;
+        ScopedMutex sm(m_mutex);
+        while (m_ready.empty() && m_active > 0)
+            m_cond.wait(m_mutex);
+
+        if (!m_ready.empty()) {
+            idx = m_ready.front();
+            m_ready.pop_front();
+            has_conn = true;
+        }
+    }
+
+    if (!has_conn)
+        throw_StopIteration("Stop iteration");
+
+    return m_py_conns[idx];
+}
+
+void SLPConnector::cancel()
+{
+    ScopedMutex sm(m_mutex);
+    m_cancelled = true;
+    m_cond.broadcast();
+}
+
+bp::object SLPConnector::getPyFailures()
+{
+    std::vector<std::size_t> failed;
+    {
+        ScopedMutex sm(m_mutex);
+        failed = m_failed;
+    }
+
+    bp::list py_failures;
+    std::vector<std::size_t>::const_iterator it;
+    for (it = failed.begin(); it != failed.end(); ++it) {
+        py_failures.append(
+            bp::make_tuple(
+                m_py_services[*it],
+                StringConv::asPyUnicode(m_targets[*it].error)));
+    }
+
+    return py_failures;
+}
+
+void *SLPConnector::work(void *connector)
+{
+    static_cast<SLPConnector*>(connector)->workLoop();
+    return NULL;
+}
+
+void SLPConnector::workLoop()
+{
+    while (true) {
+        std::size_t idx;
+        {
+            ScopedMutex sm(m_mutex);
+            while (m_next < m_targets.size() && !m_targets[m_next].conn)
+                ++m_next;
+
+            if (m_cancelled || m_next == m_targets.size()) {
+                if (--m_active == 0)
+                    m_cond.broadcast();
+                return;
+            }
+
+            idx = m_next++;
+        }
+
+        // Each target is handled by exactly one worker; no need to lock.
+        Target &target = m_targets[idx];
+        String error;
+        if (!isReachable(target.hostname, target.port, m_timeout, error)) {
+            fail(idx, error);
+            continue;
+        }
+
+        try {
+            target.conn->connectNative(m_trust_store);
+        } catch (const Pegasus::Exception &e) {
+            fail(idx, e.getMessage());
+            continue;
+        } catch (...) {
+            fail(idx, "Unknown error");
+            continue;
+        }
+
+        ScopedMutex sm(m_mutex);
+        m_ready.push_back(idx);
+        m_cond.broadcast();
+    }
+}
+
+void SLPConnector::fail(std::size_t idx, const String &error)
+{
+    ScopedMutex sm(m_mutex);
+    m_targets[idx].error = error;
+    m_failed.push_back(idx);
+}
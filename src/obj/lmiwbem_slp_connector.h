@@ -0,0 +1,98 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_SLP_CONNECTOR_H
+#  define LMIWBEM_SLP_CONNECTOR_H
+
+#  include <cstddef>
+#  include <deque>
+#  include <vector>
+#  include <pthread.h>
+#  include <boost/python/list.hpp>
+#  include "lmiwbem.h"
+#  include "lmiwbem_mutex.h"
+#  include "obj/lmiwbem_cimbase.h"
+#  include "util/lmiwbem_string.h"
+
+namespace bp = boost::python;
+
+class WBEMConnection;
+
+// Establishes WBEMConnections to services found by SLP discovery. Worker
+// threads check reachability of the services and connect to them in
+// parallel without the GIL; connections are yielded as soon as they are up.
+class SLPConnector: public CIMBase<SLPConnector>
+{
+public:
+    SLPConnector(
+        const bp::object &services,
+        const bp::object &creds,
+        const bp::object &x509,
+        const bp::object &default_namespace,
+        const bp::object &no_verification,
+        const bp::object &timeout,
+        const bp::object &threads);
+    ~SLPConnector();
+
+    static void init_type();
+
+    bp::object repr();
+
+    static bp::object iter(const bp::object &self);
+    bp::object next();
+    void cancel();
+
+    bp::object getPyFailures();
+
+private:
+    struct Target
+    {
+        Target();
+
+        String hostname;
+        unsigned int port;
+        WBEMConnection *conn;
+        String error;
+    };
+
+    static void *work(void *connector);
+    void workLoop();
+    void fail(std::size_t idx, const String &error);
+
+    std::vector<Target> m_targets;
+    bp::list m_py_services;
+    bp::list m_py_conns;
+    String m_trust_store;
+    unsigned int m_timeout;
+
+    // Guards all the members below.
+    Mutex m_mutex;
+    Condition m_cond;
+    std::size_t m_next;
+    std::deque<std::size_t> m_ready;
+    std::vector<std::size_t> m_failed;
+    std::size_t m_active;
+    bool m_cancelled;
+
+    std::vector<pthread_t> m_workers;
+};
+
+#endif // LMIWBEM_SLP_CONNECTOR_H
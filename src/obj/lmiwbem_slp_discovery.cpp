@@ -0,0 +1,461 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include <ctime>
+#include <map>
+#include <sstream>
+#include <boost/python/class.hpp>
+#include <boost/python/def.hpp>
+#include <boost/python/dict.hpp>
+#include <boost/python/tuple.hpp>
+#include "lmiwbem_exception.h"
+#include "lmiwbem_gil.h"
+#include "obj/lmiwbem_slp_discovery.h"
+#include "util/lmiwbem_convert.h"
+#include "util/lmiwbem_util.h"
+
+namespace {
+
+// Process-wide cache of discovered services and attributes.
+template <typename T>
+struct CacheEntry
+{
+    time_t stamp;
+    T value;
+};
+
+Mutex s_cache_mutex;
+std::map<String, CacheEntry<slp_services_t> > s_services_cache;
+std::map<String, CacheEntry<slp_attrs_t> > s_attrs_cache;
+
+template <typename T>
+bool cacheGet(
+    const std::map<String, CacheEntry<T> > &cache,
+    const String &key,
+    unsigned int ttl,
+    T &value)
+{
+    ScopedMutex sm(s_cache_mutex);
+    typename std::map<String, CacheEntry<T> >::const_iterator it = cache.find(key);
+    if (it == cache.end() || time(NULL) - it->second.stamp >= static_cast<time_t>(ttl))
+        return false;
+
+    value = it->second.value;
+    return true;
+}
+
+template <typename T>
+void cachePut(
+    std::map<String, CacheEntry<T> > &cache,
+    const String &key,
+    const T &value)
+{
+    ScopedMutex sm(s_cache_mutex);
+    CacheEntry<T> &entry = cache[key];
+    entry.stamp = time(NULL);
+    entry.value = value;
+}
+
+bp::object createSLPResult(const SLPService &service)
+{
+    bp::object py_result = CIMBase<SLPResult>::create();
+    SLPResult &result = SLPResult::asNative(py_result);
+    result.setSrvType(service.srvtype);
+    result.setHost(service.host);
+    result.setPort(service.port);
+    result.setFamily(service.family);
+    result.setSrvPart(service.srvpart);
+    return py_result;
+}
+
+} // unnamed namespace
+
+SLPService::SLPService()
+    : url()
+    , srvtype()
+    , host()
+    , port(0)
+    , family()
+    , srvpart()
+    , attrs()
+{
+}
+
+SLPDiscovery::SLPDiscovery(
+    const bp::object &srvtype,
+    const bp::object &scopelist,
+    const bp::object &filter,
+    const bp::object &attrs,
+    const bp::object &attrids,
+    const bp::object &threads,
+    const bp::object &cache_ttl)
+    : m_srvtype()
+    , m_scopelist()
+    , m_filter()
+    , m_attrids()
+    , m_with_attrs(false)
+    , m_threads(0)
+    , m_cache_ttl(0)
+    , m_mutex()
+    , m_cond()
+    , m_pending()
+    , m_results()
+    , m_found()
+    , m_found_all(false)
+    , m_done(false)
+    , m_cancelled(false)
+    , m_error(SLP_OK)
+    , m_thread()
+    , m_running(false)
+{
+    m_srvtype = StringConv::asString(srvtype, "srvtype");
+    m_scopelist = StringConv::asString(scopelist, "scopelist");
+    m_filter = StringConv::asString(filter, "filter");
+    m_with_attrs = Conv::as<bool>(attrs, "attrs");
+    m_attrids = StringConv::asString(attrids, "attrids");
+    m_threads = Conv::as<Pegasus::Uint32>(threads, "threads");
+    m_cache_ttl = Conv::as<Pegasus::Uint32>(cache_ttl, "cache_ttl");
+
+    if (m_threads == 0)
+        throw_ValueError("threads must be positive number");
+
+    if (pthread_create(&m_thread, NULL, &SLPDiscovery::discover, this) != 0)
+        throw_RuntimeError("Can't create SLP discovery thread");
+    m_running = true;
+}
+
+SLPDiscovery::~SLPDiscovery()
+{
+    if (!m_running)
+        return;
+
+    cancel();
+
+    // SLP calls may block until their timeout expires.
+    ScopedGILRelease sr;
+    pthread_join(m_thread, NULL);
+}
+
+void SLPDiscovery::init_type()
+{
+    CIMBase<SLPDiscovery>::init_type(
+        bp::class_<SLPDiscovery>("SLPDiscovery", bp::no_init)
+        .def(bp::init<
+            const bp::object &,
+            const bp::object &,
+            const bp::object &,
+            const bp::object &,
+            const bp::object &,
+            const bp::object &,
+            const bp::object &>((
+                bp::arg("srvtype") = "",
+                bp::arg("scopelist") = "",
+                bp::arg("filter") = "",
+                bp::arg("attrs") = false,
+                bp::arg("attrids") = "",
+                bp::arg("threads") = 8,
+                bp::arg("cache_ttl") = 60),
+                "Starts SLP discovery in background. The object is an iterator\n"
+                "over discovered services, which yields the services as soon as\n"
+                "they are found. The GIL is released while waiting for them.\n\n"
+                ":param str srvtype: service type\n"
+                ":param str scopelist: comma separated list of scope names\n"
+                ":param str filter: query formulated of attribute pattern matching\n"
+                "\texpressions in the form of an LDAPv3 search filter\n"
+                ":param bool attrs: if True, attributes of each found service are\n"
+                "\tdiscovered too and the iterator yields tuples\n"
+                "\t(:py:class:`.SLPResult`, dict of attributes). Otherwise, it\n"
+                "\tyields :py:class:`.SLPResult` objects. Default value is False.\n"
+                ":param str attrids: comma separated list of attribute ids to return\n"
+                ":param int threads: number of threads discovering attributes in\n"
+                "\tparallel. Default value is 8.\n"
+                ":param int cache_ttl: number of seconds, for which discovered\n"
+                "\tservices and attributes are cached; 0 disables the cache.\n"
+                "\tDefault value is 60.\n"
+                ":raises: :py:exc:`.SLPError` from the iterator, if the discovery\n"
+                "\tfails"))
+        .def("__repr__", &SLPDiscovery::repr)
+        .def("__iter__", &SLPDiscovery::iter)
+#  if PY_MAJOR_VERSION < 3
+        .def("next", &SLPDiscovery::next)
+#  else
+        .def("__next__", &SLPDiscovery::next)
+#  endif // PY_MAJOR_VERSION
+        .def("cancel", &SLPDiscovery::cancel,
+            "cancel()\n\n"
+            "Cancels the discovery. Results already discovered can still be\n"
+            "iterated over.")
+        .add_property("is_done", &SLPDiscovery::getIsDone,
+            "Property storing flag, which indicates, if the discovery\n"
+            "finished. Results may still be pending.\n\n"
+            ":rtype: bool"));
+
+    bp::def("slp_cache_clear", SLPDiscovery::clearCache,
+        "Clears cache of services and attributes discovered by\n"
+        ":py:class:`.SLPDiscovery`.");
+}
+
+bp::object SLPDiscovery::repr()
+{
+    std::stringstream ss;
+    ss << "SLPDiscovery(srvtype=u'" << m_srvtype
+       << "', scopelist=u'" << m_scopelist
+       << "', filter=u'" << m_filter << "', ...)";
+    return StringConv::asPyUnicode(ss.str());
+}
+
+bp::object SLPDiscovery::iter(const bp::object &self)
+{
+    return self;
+}
+
+bp::object SLPDiscovery::next()
+{
+    SLPService service;
+    bool has_result = false;
+    SLPError error;
+
+    {
+        ScopedGILRelease sr;
+        ScopedMutex sm(m_mutex);
+        while (m_results.empty() && !m_done)
+            m_cond.wait(m_mutex);
+
+        if (!m_results.empty()) {
+            service = m_results.front();
+            m_results.pop_front();
+            has_result = true;
+        }
+
+        error = m_error;
+    }
+
+    if (!has_result) {
+        if (error != SLP_OK)
+            throw_SLPError("SLP discovery failed", static_cast<int>(error));
+        throw_StopIteration("Stop iteration");
+    }
+
+    bp::object py_result = createSLPResult(service);
+    if (!m_with_attrs)
+        return py_result;
+
+    bp::dict py_attrs;
+    slp_attrs_t::const_iterator it;
+    for (it = service.attrs.begin(); it != service.attrs.end(); ++it)
+        py_attrs[it->first] = it->second;
+
+    return bp::make_tuple(py_result, py_attrs);
+}
+
+void SLPDiscovery::cancel()
+{
+    ScopedMutex sm(m_mutex);
+    m_cancelled = true;
+    m_cond.broadcast();
+}
+
+bool SLPDiscovery::getIsDone()
+{
+    ScopedMutex sm(m_mutex);
+    return m_done;
+}
+
+void SLPDiscovery::clearCache()
+{
+    ScopedMutex sm(s_cache_mutex);
+    s_services_cache.clear();
+    s_attrs_cache.clear();
+}
+
+SLPBoolean SLPDiscovery::urlCallback(
+    SLPHandle hslp,
+    const char *srvurl,
+    unsigned short lifetime,
+    SLPError errcode,
+    void *cookie)
+{
+    SLPDiscovery *fake_this = static_cast<SLPDiscovery*>(cookie);
+
+    if ((errcode == SLP_OK || errcode == SLP_LAST_CALL) && srvurl != NULL) {
+        SLPSrvURL *url;
+        if (SLPParseSrvURL(srvurl, &url) == SLP_OK) {
+            SLPService service;
+            service.url = String(srvurl);
+            service.srvtype = String(url->s_pcSrvType);
+            service.host = String(url->s_pcHost);
+            service.port = url->s_iPort;
+            service.family = String(url->s_pcNetFamily);
+            service.srvpart = String(url->s_pcSrvPart);
+            SLPFree(url);
+
+            fake_this->found(service);
+        }
+    }
+
+    return fake_this->isCancelled() ? SLP_FALSE : SLP_TRUE;
+}
+
+SLPBoolean SLPDiscovery::attrCallback(
+    SLPHandle hslp,
+    const char *attrlist,
+    SLPError errcode,
+    void *cookie)
+{
+    if (errcode == SLP_OK && attrlist != NULL) {
+        slp_attrs_t &attrs = *static_cast<slp_attrs_t*>(cookie);
+        if (!SLP::parseAttrs(attrlist, attrs))
+            return SLP_FALSE;
+    }
+
+    return SLP_TRUE;
+}
+
+void *SLPDiscovery::discover(void *discovery)
+{
+    static_cast<SLPDiscovery*>(discovery)->discoverServices();
+    return NULL;
+}
+
+void *SLPDiscovery::fetchAttrs(void *discovery)
+{
+    static_cast<SLPDiscovery*>(discovery)->fetchAttrsLoop();
+    return NULL;
+}
+
+void SLPDiscovery::discoverServices()
+{
+    // Attribute workers start right away and process the services as they
+    // are found.
+    std::vector<pthread_t> workers;
+    for (std::size_t i = 0; m_with_attrs && i < m_threads; ++i) {
+        pthread_t worker;
+        if (pthread_create(&worker, NULL, &SLPDiscovery::fetchAttrs, this) != 0)
+            break;
+        workers.push_back(worker);
+    }
+
+    const String key(m_srvtype + '\n' + m_scopelist + '\n' + m_filter);
+    slp_services_t services;
+    if (m_cache_ttl > 0 && cacheGet(s_services_cache, key, m_cache_ttl, services)) {
+        slp_services_t::const_iterator it;
+        for (it = services.begin(); it != services.end(); ++it)
+            found(*it);
+    } else {
+        ScopedSLPHandle hslp;
+        SLPError err = hslp.error();
+        if (hslp.good()) {
+            err = SLPFindSrvs(
+                hslp,
+                m_srvtype.c_str(),
+                m_scopelist.c_str(),
+                m_filter.c_str(),
+                SLPDiscovery::urlCallback,
+                static_cast<void*>(this));
+        }
+
+        ScopedMutex sm(m_mutex);
+        if (err != SLP_OK)
+            m_error = err;
+        else if (m_cache_ttl > 0 && !m_cancelled)
+            cachePut(s_services_cache, key, m_found);
+    }
+
+    {
+        ScopedMutex sm(m_mutex);
+        m_found_all = true;
+        m_cond.broadcast();
+    }
+
+    // No worker could be started; fetch the attributes here.
+    if (m_with_attrs && workers.empty())
+        fetchAttrsLoop();
+
+    std::vector<pthread_t>::iterator it;
+    for (it = workers.begin(); it != workers.end(); ++it)
+        pthread_join(*it, NULL);
+
+    ScopedMutex sm(m_mutex);
+    m_done = true;
+    m_cond.broadcast();
+}
+
+void SLPDiscovery::fetchAttrsLoop()
+{
+    // SLP handles can't be shared among threads.
+    ScopedSLPHandle hslp;
+
+    while (true) {
+        SLPService service;
+        {
+            ScopedMutex sm(m_mutex);
+            while (m_pending.empty() && !m_found_all && !m_cancelled)
+                m_cond.wait(m_mutex);
+
+            if (m_pending.empty() || m_cancelled)
+                return;
+
+            service = m_pending.front();
+            m_pending.pop_front();
+        }
+
+        const String key(service.url + '\n' + m_scopelist + '\n' + m_attrids);
+        if (m_cache_ttl == 0 ||
+            !cacheGet(s_attrs_cache, key, m_cache_ttl, service.attrs))
+        {
+            // Services without attributes are still reported.
+            if (hslp.good() &&
+                SLPFindAttrs(
+                    hslp,
+                    service.url.c_str(),
+                    m_scopelist.c_str(),
+                    m_attrids.c_str(),
+                    SLPDiscovery::attrCallback,
+                    static_cast<void*>(&service.attrs)) == SLP_OK &&
+                m_cache_ttl > 0)
+            {
+                cachePut(s_attrs_cache, key, service.attrs);
+            }
+        }
+
+        ScopedMutex sm(m_mutex);
+        m_results.push_back(service);
+        m_cond.broadcast();
+    }
+}
+
+void SLPDiscovery::found(const SLPService &service)
+{
+    ScopedMutex sm(m_mutex);
+    m_found.push_back(service);
+    if (m_with_attrs)
+        m_pending.push_back(service);
+    else
+        m_results.push_back(service);
+    m_cond.broadcast();
+}
+
+bool SLPDiscovery::isCancelled()
+{
+    ScopedMutex sm(m_mutex);
+    return m_cancelled;
+}
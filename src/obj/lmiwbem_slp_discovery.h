@@ -0,0 +1,134 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_SLP_DISCOVERY_H
+#  define LMIWBEM_SLP_DISCOVERY_H
+
+#  include <cstddef>
+#  include <deque>
+#  include <vector>
+#  include <pthread.h>
+#  include <slp.h>
+#  include "lmiwbem.h"
+#  include "lmiwbem_mutex.h"
+#  include "obj/lmiwbem_cimbase.h"
+#  include "obj/lmiwbem_slp.h"
+#  include "util/lmiwbem_string.h"
+
+BOOST_PYTHON_BEGIN
+class object;
+BOOST_PYTHON_END
+
+namespace bp = boost::python;
+
+// Discovered service. Plain C++ data, so discovery threads don't need the
+// GIL.
+struct SLPService
+{
+    SLPService();
+
+    String url;
+    String srvtype;
+    String host;
+    int port;
+    String family;
+    String srvpart;
+    slp_attrs_t attrs;
+};
+
+typedef std::vector<SLPService> slp_services_t;
+
+// Background SLP discovery. Services are discovered by a dedicated thread
+// and their attributes (if requested) are fetched by a pool of worker
+// threads, each with its own SLP handle. Results are streamed to Python as
+// they come; discovered URLs and attributes are cached for cache_ttl
+// seconds.
+class SLPDiscovery: public CIMBase<SLPDiscovery>
+{
+public:
+    SLPDiscovery(
+        const bp::object &srvtype,
+        const bp::object &scopelist,
+        const bp::object &filter,
+        const bp::object &attrs,
+        const bp::object &attrids,
+        const bp::object &threads,
+        const bp::object &cache_ttl);
+    ~SLPDiscovery();
+
+    static void init_type();
+
+    bp::object repr();
+
+    static bp::object iter(const bp::object &self);
+    bp::object next();
+    void cancel();
+
+    bool getIsDone();
+
+    static void clearCache();
+
+private:
+    static SLPBoolean urlCallback(
+        SLPHandle hslp,
+        const char *srvurl,
+        unsigned short lifetime,
+        SLPError errcode,
+        void *cookie);
+
+    static SLPBoolean attrCallback(
+        SLPHandle hslp,
+        const char *attrlist,
+        SLPError errcode,
+        void *cookie);
+
+    static void *discover(void *discovery);
+    static void *fetchAttrs(void *discovery);
+
+    void discoverServices();
+    void fetchAttrsLoop();
+    void found(const SLPService &service);
+    bool isCancelled();
+
+    String m_srvtype;
+    String m_scopelist;
+    String m_filter;
+    String m_attrids;
+    bool m_with_attrs;
+    std::size_t m_threads;
+    unsigned int m_cache_ttl;
+
+    // Guards all the members below.
+    Mutex m_mutex;
+    Condition m_cond;
+    std::deque<SLPService> m_pending;   // Services waiting for attributes
+    std::deque<SLPService> m_results;   // Services ready for Python
+    slp_services_t m_found;             // All services found; for the cache
+    bool m_found_all;
+    bool m_done;
+    bool m_cancelled;
+    SLPError m_error;
+
+    pthread_t m_thread;
+    bool m_running;
+};
+
+#endif // LMIWBEM_SLP_DISCOVERY_H
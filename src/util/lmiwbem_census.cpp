@@ -0,0 +1,194 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include <boost/python/dict.hpp>
+#include <Pegasus/Common/Array.h>
+#include <Pegasus/Common/CIMMethod.h>
+#include <Pegasus/Common/CIMObject.h>
+#include <Pegasus/Common/CIMObjectPath.h>
+#include <Pegasus/Common/CIMProperty.h>
+#include <Pegasus/Common/CIMQualifier.h>
+#include <Pegasus/Common/CIMValue.h>
+#include "obj/lmiwbem_nocasedict.h"
+#include "obj/cim/lmiwbem_class.h"
+#include "obj/cim/lmiwbem_instance.h"
+#include "obj/cim/lmiwbem_instance_name.h"
+#include "obj/cim/lmiwbem_property.h"
+#include "obj/cim/lmiwbem_qualifier.h"
+#include "util/lmiwbem_census.h"
+
+namespace {
+
+template <typename T>
+std::size_t valueSize(const Pegasus::CIMValue &value)
+{
+    if (value.isArray()) {
+        Pegasus::Array<T> array;
+        value.get(array);
+        return MemSize::of(array);
+    }
+
+    T scalar;
+    value.get(scalar);
+    return MemSize::of(scalar);
+}
+
+std::size_t objectSize(const Pegasus::CIMObject &object)
+{
+    std::size_t size = MemSize::REP_OVERHEAD +
+        MemSize::of(object.getClassName().getString()) +
+        MemSize::of(object.getPath());
+    const Pegasus::Uint32 cnt = object.getPropertyCount();
+    for (Pegasus::Uint32 i = 0; i < cnt; ++i) {
+        size += sizeof(Pegasus::CIMConstProperty) +
+            MemSize::of(object.getProperty(i));
+    }
+    return size;
+}
+
+template <typename T>
+std::size_t objectValueSize(const Pegasus::CIMValue &value)
+{
+    if (!value.isArray()) {
+        T object;
+        value.get(object);
+        return objectSize(Pegasus::CIMObject(object));
+    }
+
+    Pegasus::Array<T> array;
+    value.get(array);
+    std::size_t size = MemSize::REP_OVERHEAD;
+    for (Pegasus::Uint32 i = 0; i < array.size(); ++i)
+        size += sizeof(T) + objectSize(Pegasus::CIMObject(array[i]));
+    return size;
+}
+
+template <typename T>
+bp::object censusAsPyDict()
+{
+    const typename Census<T>::Totals totals(Census<T>::totals());
+    bp::dict py_totals;
+    py_totals["count"] = totals.count;
+    py_totals["bytes"] = totals.bytes;
+    py_totals["lazy_bytes"] = totals.lazy_bytes;
+    return py_totals;
+}
+
+} // unnamed namespace
+
+std::size_t MemSize::of(const String &str)
+{
+    return str.empty() ? 0 : str.capacity() + 1;
+}
+
+std::size_t MemSize::of(const Pegasus::String &str)
+{
+    return REP_OVERHEAD + (str.size() + 1) * sizeof(Pegasus::Char16);
+}
+
+std::size_t MemSize::of(const Pegasus::CIMValue &value)
+{
+    std::size_t size = REP_OVERHEAD;
+    if (value.isNull())
+        return size;
+
+    const std::size_t cnt = value.isArray() ? value.getArraySize() : 1;
+    switch (value.getType()) {
+    case Pegasus::CIMTYPE_STRING:
+        size += valueSize<Pegasus::String>(value);
+        break;
+    case Pegasus::CIMTYPE_REFERENCE:
+        size += valueSize<Pegasus::CIMObjectPath>(value);
+        break;
+    case Pegasus::CIMTYPE_OBJECT:
+        size += objectValueSize<Pegasus::CIMObject>(value);
+        break;
+    case Pegasus::CIMTYPE_INSTANCE:
+        size += objectValueSize<Pegasus::CIMInstance>(value);
+        break;
+    case Pegasus::CIMTYPE_DATETIME:
+        size += cnt * (REP_OVERHEAD + sizeof(Pegasus::Uint64));
+        break;
+    default:
+        size += cnt * sizeof(Pegasus::Uint64);
+        break;
+    }
+
+    return size;
+}
+
+std::size_t MemSize::of(const Pegasus::CIMObjectPath &path)
+{
+    return REP_OVERHEAD +
+        of(path.getHost()) +
+        of(path.getNameSpace().getString()) +
+        of(path.getClassName().getString()) +
+        of(path.getKeyBindings());
+}
+
+std::size_t MemSize::of(const Pegasus::CIMKeyBinding &keybinding)
+{
+    return REP_OVERHEAD +
+        of(keybinding.getName().getString()) +
+        of(keybinding.getValue());
+}
+
+std::size_t MemSize::of(const Pegasus::CIMConstProperty &property)
+{
+    std::size_t size = REP_OVERHEAD +
+        of(property.getName().getString()) +
+        of(property.getValue());
+    const Pegasus::Uint32 cnt = property.getQualifierCount();
+    for (Pegasus::Uint32 i = 0; i < cnt; ++i)
+        size += sizeof(Pegasus::CIMConstQualifier) + of(property.getQualifier(i));
+    return size;
+}
+
+std::size_t MemSize::of(const Pegasus::CIMConstQualifier &qualifier)
+{
+    return REP_OVERHEAD +
+        of(qualifier.getName().getString()) +
+        of(qualifier.getValue());
+}
+
+std::size_t MemSize::of(const Pegasus::CIMConstMethod &method)
+{
+    std::size_t size = REP_OVERHEAD +
+        of(method.getName().getString()) +
+        method.getParameterCount() * (REP_OVERHEAD + sizeof(void*));
+    const Pegasus::Uint32 cnt = method.getQualifierCount();
+    for (Pegasus::Uint32 i = 0; i < cnt; ++i)
+        size += sizeof(Pegasus::CIMConstQualifier) + of(method.getQualifier(i));
+    return size;
+}
+
+bp::object object_census()
+{
+    bp::dict py_census;
+    py_census["CIMInstance"] = censusAsPyDict<CIMInstance>();
+    py_census["CIMInstanceName"] = censusAsPyDict<CIMInstanceName>();
+    py_census["CIMProperty"] = censusAsPyDict<CIMProperty>();
+    py_census["CIMQualifier"] = censusAsPyDict<CIMQualifier>();
+    py_census["CIMClass"] = censusAsPyDict<CIMClass>();
+    py_census["NocaseDict"] = censusAsPyDict<NocaseDict>();
+    return py_census;
+}
@@ -0,0 +1,209 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_CENSUS_H
+#  define LMIWBEM_CENSUS_H
+
+#  include <cstddef>
+#  include <list>
+#  include <boost/python/extract.hpp>
+#  include <boost/python/handle.hpp>
+#  include <boost/python/object.hpp>
+#  include <Pegasus/Common/Config.h>
+#  include "lmiwbem.h"
+#  include "lmiwbem_refcountedptr.h"
+#  include "util/lmiwbem_convert.h"
+#  include "util/lmiwbem_string.h"
+
+PEGASUS_BEGIN
+template <class T> class Array;
+class CIMConstMethod;
+class CIMConstProperty;
+class CIMConstQualifier;
+class CIMKeyBinding;
+class CIMObjectPath;
+class CIMValue;
+class String;
+PEGASUS_END
+
+namespace bp = boost::python;
+
+// Approximate sizes of heap memory owned by native objects. Pegasus objects
+// share reference counted representations; shared data is counted for
+// every owner.
+class MemSize
+{
+public:
+    static std::size_t of(const String &str);
+    static std::size_t of(const Pegasus::String &str);
+    static std::size_t of(const Pegasus::CIMValue &value);
+    static std::size_t of(const Pegasus::CIMObjectPath &path);
+    static std::size_t of(const Pegasus::CIMKeyBinding &keybinding);
+    static std::size_t of(const Pegasus::CIMConstProperty &property);
+    static std::size_t of(const Pegasus::CIMConstQualifier &qualifier);
+    static std::size_t of(const Pegasus::CIMConstMethod &method);
+
+    template <typename T>
+    static std::size_t of(const Pegasus::Array<T> &array)
+    {
+        std::size_t size = REP_OVERHEAD;
+        for (Pegasus::Uint32 i = 0; i < array.size(); ++i)
+            size += sizeof(T) + of(array[i]);
+        return size;
+    }
+
+    template <typename T>
+    static std::size_t of(const std::list<T> &list)
+    {
+        std::size_t size = 0;
+        typename std::list<T>::const_iterator it;
+        for (it = list.begin(); it != list.end(); ++it)
+            size += LIST_NODE_OVERHEAD + sizeof(T) + of(*it);
+        return size;
+    }
+
+    // Size of data held by lazy evaluation holder; 0, if already evaluated.
+    template <typename T>
+    static std::size_t of(const RefCountedPtr<T> &ptr)
+    {
+        if (ptr.empty())
+            return 0;
+        return sizeof(RefCountedPtrValue<T>) + sizeof(T) + of(*ptr.get());
+    }
+
+    // Reference count and size of a Pegasus representation
+    static const std::size_t REP_OVERHEAD = 3 * sizeof(void*);
+    // Two links of std::list node
+    static const std::size_t LIST_NODE_OVERHEAD = 2 * sizeof(void*);
+    // Color and three links of std::map node
+    static const std::size_t MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+};
+
+// Registry of live native objects of type T. Classes derive from
+// Census<T> and provide heapSize() (memory owned by native members) and
+// lazySize() (memory held by unevaluated Pegasus objects). The classes hold
+// Python objects, so they are created, copied and destroyed with the GIL
+// held; the GIL guards the registry, too.
+template <typename T>
+class Census
+{
+public:
+    struct Totals
+    {
+        Totals()
+            : count(0)
+            , bytes(0)
+            , lazy_bytes(0)
+        {
+        }
+
+        std::size_t count;
+        std::size_t bytes;
+        std::size_t lazy_bytes;
+    };
+
+    static Totals totals()
+    {
+        Totals totals;
+        for (const Census *it = s_head; it; it = it->m_next) {
+            const T &obj = static_cast<const T&>(*it);
+            ++totals.count;
+            totals.bytes += sizeof(T) + obj.heapSize();
+            totals.lazy_bytes += obj.lazySize();
+        }
+        return totals;
+    }
+
+    // __sizeof__ implementation: size of Python object including held
+    // native object plus memory owned by the native object. Referenced
+    // Python objects are not included.
+    static bp::object sizeOf(const bp::object &self)
+    {
+        const T &obj = Conv::as<T&>(self);
+        const std::size_t base_size = bp::extract<std::size_t>(
+            baseSizeOf()(self));
+        return bp::object(base_size + obj.heapSize() + obj.lazySize());
+    }
+
+protected:
+    Census()
+        : m_prev(NULL)
+        , m_next(NULL)
+    {
+        link();
+    }
+
+    Census(const Census &copy)
+        : m_prev(NULL)
+        , m_next(NULL)
+    {
+        link();
+    }
+
+    ~Census()
+    {
+        unlink();
+    }
+
+    Census &operator=(const Census &rhs)
+    {
+        return *this;
+    }
+
+private:
+    void link()
+    {
+        m_next = s_head;
+        if (s_head)
+            s_head->m_prev = this;
+        s_head = this;
+    }
+
+    void unlink()
+    {
+        if (m_prev)
+            m_prev->m_next = m_next;
+        else
+            s_head = m_next;
+        if (m_next)
+            m_next->m_prev = m_prev;
+    }
+
+    static bp::object baseSizeOf()
+    {
+        return bp::object(bp::handle<>(bp::borrowed(
+            reinterpret_cast<PyObject*>(&PyBaseObject_Type)))).attr("__sizeof__");
+    }
+
+    static Census *s_head;
+
+    Census *m_prev;
+    Census *m_next;
+};
+
+template <typename T>
+Census<T> *Census<T>::s_head = NULL;
+
+// Returns dictionary keyed by class names; values are dictionaries with
+// keys count, bytes and lazy_bytes.
+bp::object object_census();
+
+#endif // LMIWBEM_CENSUS_H
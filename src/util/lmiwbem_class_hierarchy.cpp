@@ -0,0 +1,237 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+extern "C" {
+#  include <strings.h>
+}
+#include "util/lmiwbem_class_hierarchy.h"
+
+bool NoCaseLess::operator()(const String &lhs, const String &rhs) const
+{
+    return strcasecmp(lhs.c_str(), rhs.c_str()) < 0;
+}
+
+ClassHierarchy::ClassHierarchy(const Pegasus::Array<Pegasus::CIMClass> &peg_classes)
+    : m_nodes()
+    , m_index()
+{
+    const Pegasus::Uint32 cnt = peg_classes.size();
+    m_nodes.resize(cnt);
+    for (Pegasus::Uint32 i = 0; i < cnt; ++i) {
+        Node &node = m_nodes[i];
+        node.name = peg_classes[i].getClassName().getString();
+        node.parent = npos;
+        node.depth = 0;
+        node.first = 0;
+        node.last = 0;
+        m_index[node.name] = i;
+    }
+
+    std::vector<size_t> roots;
+    for (Pegasus::Uint32 i = 0; i < cnt; ++i) {
+        const Pegasus::CIMName &peg_super = peg_classes[i].getSuperClassName();
+        const size_t parent = peg_super.isNull() ?
+            npos : find(String(peg_super.getString()));
+        if (parent == npos) {
+            // Root class or a class, whose superclass was not enumerated.
+            roots.push_back(i);
+            continue;
+        }
+
+        m_nodes[i].parent = parent;
+        m_nodes[parent].children.push_back(i);
+    }
+
+    size_t counter = 0;
+    std::vector<size_t>::const_iterator it;
+    for (it = roots.begin(); it != roots.end(); ++it)
+        counter = number(*it, counter);
+}
+
+bool ClassHierarchy::hasClass(const String &classname) const
+{
+    return find(classname) != npos;
+}
+
+bool ClassHierarchy::isSubclass(
+    const String &superclass,
+    const String &subclass) const
+{
+    bool known;
+    return isSubclass(superclass, subclass, known);
+}
+
+bool ClassHierarchy::isSubclass(
+    const String &superclass,
+    const String &subclass,
+    bool &known) const
+{
+    const size_t sub = find(subclass);
+    known = sub != npos;
+    if (!known)
+        return false;
+
+    const size_t sup = find(superclass);
+    if (sup == npos)
+        return false;
+
+    return m_nodes[sup].first <= m_nodes[sub].first &&
+        m_nodes[sub].last <= m_nodes[sup].last;
+}
+
+bool ClassHierarchy::getAncestors(
+    const String &classname,
+    std::vector<String> &ancestors) const
+{
+    size_t node = find(classname);
+    if (node == npos)
+        return false;
+
+    for (node = m_nodes[node].parent; node != npos; node = m_nodes[node].parent)
+        ancestors.push_back(m_nodes[node].name);
+
+    return true;
+}
+
+bool ClassHierarchy::getDescendants(
+    const String &classname,
+    const bool deep_inheritance,
+    std::vector<String> &descendants) const
+{
+    const size_t node = find(classname);
+    if (node == npos)
+        return false;
+
+    if (deep_inheritance) {
+        collectDescendants(node, descendants);
+    } else {
+        const std::vector<size_t> &children = m_nodes[node].children;
+        std::vector<size_t>::const_iterator it;
+        for (it = children.begin(); it != children.end(); ++it)
+            descendants.push_back(m_nodes[*it].name);
+    }
+
+    return true;
+}
+
+String ClassHierarchy::getCommonSuperclass(
+    const std::vector<String> &classnames) const
+{
+    if (classnames.empty())
+        return String();
+
+    size_t common = find(classnames[0]);
+    std::vector<String>::const_iterator it;
+    for (it = classnames.begin() + 1; it != classnames.end() && common != npos; ++it) {
+        size_t node = find(*it);
+        if (node == npos)
+            return String();
+
+        // Lift the deeper class first, then both of them in lockstep.
+        while (m_nodes[node].depth > m_nodes[common].depth)
+            node = m_nodes[node].parent;
+        while (m_nodes[common].depth > m_nodes[node].depth)
+            common = m_nodes[common].parent;
+        while (node != common) {
+            node = m_nodes[node].parent;
+            common = m_nodes[common].parent;
+            if (node == npos || common == npos)
+                return String();
+        }
+    }
+
+    return common == npos ? String() : m_nodes[common].name;
+}
+
+size_t ClassHierarchy::size() const
+{
+    return m_nodes.size();
+}
+
+size_t ClassHierarchy::find(const String &classname) const
+{
+    std::map<String, size_t, NoCaseLess>::const_iterator found =
+        m_index.find(classname);
+    return found == m_index.end() ? npos : found->second;
+}
+
+size_t ClassHierarchy::number(size_t node, size_t counter)
+{
+    // Iterative preorder numbering; CIM schemas may be deep enough to make
+    // recursion undesirable.
+    std::vector<std::pair<size_t, size_t> > stack;
+    m_nodes[node].first = counter++;
+    stack.push_back(std::make_pair(node, static_cast<size_t>(0)));
+    while (!stack.empty()) {
+        std::pair<size_t, size_t> &top = stack.back();
+        Node &current = m_nodes[top.first];
+        if (top.second == current.children.size()) {
+            current.last = counter - 1;
+            stack.pop_back();
+            continue;
+        }
+
+        const size_t child = current.children[top.second++];
+        m_nodes[child].depth = current.depth + 1;
+        m_nodes[child].first = counter++;
+        stack.push_back(std::make_pair(child, static_cast<size_t>(0)));
+    }
+
+    return counter;
+}
+
+void ClassHierarchy::collectDescendants(
+    size_t node,
+    std::vector<String> &result) const
+{
+    std::vector<size_t> stack(m_nodes[node].children.rbegin(),
+        m_nodes[node].children.rend());
+    while (!stack.empty()) {
+        const Node &current = m_nodes[stack.back()];
+        stack.pop_back();
+        result.push_back(current.name);
+        stack.insert(stack.end(), current.children.rbegin(),
+            current.children.rend());
+    }
+}
+
+ClassHierarchyMap::ClassHierarchyMap()
+    : m_hierarchies()
+{
+}
+
+ClassHierarchyPtr ClassHierarchyMap::get(const String &ns) const
+{
+    std::map<String, ClassHierarchyPtr, NoCaseLess>::const_iterator found =
+        m_hierarchies.find(ns);
+    return found == m_hierarchies.end() ? ClassHierarchyPtr() : found->second;
+}
+
+void ClassHierarchyMap::set(const String &ns, const ClassHierarchyPtr &hierarchy)
+{
+    m_hierarchies[ns] = hierarchy;
+}
+
+void ClassHierarchyMap::clear()
+{
+    m_hierarchies.clear();
+}
@@ -0,0 +1,115 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_CLASS_HIERARCHY_H
+#  define LMIWBEM_CLASS_HIERARCHY_H
+
+#  include <map>
+#  include <vector>
+#  include <boost/shared_ptr.hpp>
+#  include <Pegasus/Common/Array.h>
+#  include <Pegasus/Common/CIMClass.h>
+#  include "util/lmiwbem_string.h"
+
+// Case insensitive ordering of class and namespace names; lookups don't
+// need a lowercased copy of the key.
+struct NoCaseLess
+{
+    bool operator()(const String &lhs, const String &rhs) const;
+};
+
+// Class hierarchy of a single CIM namespace. Built from one deep
+// EnumerateClasses; answers subclass queries without any CIM operation.
+// Class names are matched case insensitively.
+class ClassHierarchy
+{
+public:
+    ClassHierarchy(const Pegasus::Array<Pegasus::CIMClass> &peg_classes);
+
+    bool hasClass(const String &classname) const;
+
+    // Returns true, if subclass is superclass or derives from it. Returns
+    // false also for unknown classes.
+    bool isSubclass(const String &superclass, const String &subclass) const;
+
+    // Same as above; known is set to false, if subclass is not in the
+    // hierarchy.
+    bool isSubclass(
+        const String &superclass,
+        const String &subclass,
+        bool &known) const;
+
+    // Both methods return false for unknown classes. Ancestors are ordered
+    // from the direct superclass up to the root class.
+    bool getAncestors(
+        const String &classname,
+        std::vector<String> &ancestors) const;
+    bool getDescendants(
+        const String &classname,
+        const bool deep_inheritance,
+        std::vector<String> &descendants) const;
+
+    // Returns the most derived class, which is a superclass of (or equal to)
+    // all the classes; empty string, if there is none.
+    String getCommonSuperclass(const std::vector<String> &classnames) const;
+
+    size_t size() const;
+
+private:
+    static const size_t npos = static_cast<size_t>(-1);
+
+    struct Node
+    {
+        String name;
+        size_t parent;
+        size_t depth;
+        // Preorder interval of the subtree; subclass test is then
+        // a constant time comparison.
+        size_t first;
+        size_t last;
+        std::vector<size_t> children;
+    };
+
+    size_t find(const String &classname) const;
+    size_t number(size_t node, size_t counter);
+    void collectDescendants(size_t node, std::vector<String> &result) const;
+
+    std::vector<Node> m_nodes;
+    std::map<String, size_t, NoCaseLess> m_index;
+};
+
+typedef boost::shared_ptr<ClassHierarchy> ClassHierarchyPtr;
+
+// Class hierarchies keyed by namespace.
+class ClassHierarchyMap
+{
+public:
+    ClassHierarchyMap();
+
+    ClassHierarchyPtr get(const String &ns) const;
+    void set(const String &ns, const ClassHierarchyPtr &hierarchy);
+    void clear();
+
+private:
+    std::map<String, ClassHierarchyPtr, NoCaseLess> m_hierarchies;
+};
+
+#endif // LMIWBEM_CLASS_HIERARCHY_H
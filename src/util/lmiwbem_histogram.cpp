@@ -0,0 +1,108 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include <cstring>
+#include <boost/python/dict.hpp>
+#include <boost/python/list.hpp>
+#include <boost/python/object.hpp>
+#include <boost/python/tuple.hpp>
+#include "util/lmiwbem_histogram.h"
+
+Stopwatch::Stopwatch()
+{
+    restart();
+}
+
+void Stopwatch::restart()
+{
+    gettimeofday(&m_start, NULL);
+}
+
+Pegasus::Uint64 Stopwatch::elapsedUs() const
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    Pegasus::Sint64 us =
+        static_cast<Pegasus::Sint64>(now.tv_sec - m_start.tv_sec) * 1000000 +
+        (now.tv_usec - m_start.tv_usec);
+
+    // Wall clock may go backwards.
+    return us > 0 ? static_cast<Pegasus::Uint64>(us) : 0;
+}
+
+// ----------------------------------------------------------------------------
+
+Histogram::Histogram()
+    : count(0)
+    , total(0)
+    , max(0)
+{
+    memset(buckets, 0, sizeof(buckets));
+}
+
+void Histogram::record(Pegasus::Uint64 us)
+{
+    std::size_t bucket = 0;
+    while (bucket < BUCKETS - 1 && us >= upperBound(bucket))
+        ++bucket;
+
+    ++buckets[bucket];
+    ++count;
+    total += us;
+    if (us > max)
+        max = us;
+}
+
+void Histogram::add(const Histogram &histogram)
+{
+    for (std::size_t i = 0; i < BUCKETS; ++i)
+        buckets[i] += histogram.buckets[i];
+    count += histogram.count;
+    total += histogram.total;
+    if (histogram.max > max)
+        max = histogram.max;
+}
+
+Pegasus::Uint64 Histogram::upperBound(std::size_t bucket)
+{
+    return static_cast<Pegasus::Uint64>(1) << bucket;
+}
+
+// ----------------------------------------------------------------------------
+
+bp::object histogramAsPyDict(const Histogram &histogram)
+{
+    bp::list py_buckets;
+    for (std::size_t i = 0; i < Histogram::BUCKETS; ++i) {
+        bp::object py_bound;
+        if (i < Histogram::BUCKETS - 1)
+            py_bound = bp::object(Histogram::upperBound(i));
+        py_buckets.append(bp::make_tuple(py_bound, histogram.buckets[i]));
+    }
+
+    bp::dict py_histogram;
+    py_histogram["count"] = histogram.count;
+    py_histogram["total_us"] = histogram.total;
+    py_histogram["max_us"] = histogram.max;
+    py_histogram["buckets"] = py_buckets;
+    return py_histogram;
+}
@@ -0,0 +1,73 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_HISTOGRAM_H
+#  define LMIWBEM_HISTOGRAM_H
+
+#  include <cstddef>
+#  include <sys/time.h>
+#  include <Pegasus/Common/Config.h>
+#  include "lmiwbem.h"
+
+BOOST_PYTHON_BEGIN
+class object;
+BOOST_PYTHON_END
+
+namespace bp = boost::python;
+
+// Measures elapsed time in microseconds.
+class Stopwatch
+{
+public:
+    Stopwatch();
+
+    void restart();
+    Pegasus::Uint64 elapsedUs() const;
+
+private:
+    struct timeval m_start;
+};
+
+// Histogram of durations with power-of-two buckets: bucket i counts
+// durations below 2^i microseconds, the last bucket counts the rest.
+class Histogram
+{
+public:
+    static const std::size_t BUCKETS = 25;
+
+    Histogram();
+
+    void record(Pegasus::Uint64 us);
+    void add(const Histogram &histogram);
+
+    static Pegasus::Uint64 upperBound(std::size_t bucket);
+
+    Pegasus::Uint64 count;
+    Pegasus::Uint64 total;
+    Pegasus::Uint64 max;
+    Pegasus::Uint64 buckets[BUCKETS];
+};
+
+// Returns dictionary with keys count, total_us, max_us and buckets; buckets
+// is a list of (upper bound, count) tuples, the last bound is None.
+bp::object histogramAsPyDict(const Histogram &histogram);
+
+#endif // LMIWBEM_HISTOGRAM_H
@@ -0,0 +1,105 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include <boost/python/dict.hpp>
+#include <boost/python/object.hpp>
+#include "util/lmiwbem_convert.h"
+#include "util/lmiwbem_operation_stats.h"
+
+OperationStats::OperationStats()
+    : m_mutex()
+    , m_stats()
+{
+}
+
+void OperationStats::record(
+    const String &operation,
+    const Pegasus::Uint64 durations[PHASES],
+    const bool measured[PHASES])
+{
+    ScopedMutex sm(m_mutex);
+    PhaseHistograms &histograms = m_stats[operation];
+    for (int i = 0; i < PHASES; ++i) {
+        if (measured[i])
+            histograms.phases[i].record(durations[i]);
+    }
+}
+
+OperationStats::stats_map_t OperationStats::snapshot()
+{
+    ScopedMutex sm(m_mutex);
+    return m_stats;
+}
+
+void OperationStats::reset()
+{
+    ScopedMutex sm(m_mutex);
+    m_stats.clear();
+}
+
+OperationStats &OperationStats::global()
+{
+    static OperationStats s_global;
+    return s_global;
+}
+
+const char *OperationStats::phaseName(Phase phase)
+{
+    switch (phase) {
+    case PHASE_CONVERSION:
+        return "conversion";
+    case PHASE_MUTEX_WAIT:
+        return "mutex_wait";
+    case PHASE_CALL:
+        return "call";
+    case PHASE_CONSTRUCTION:
+        return "construction";
+    default:
+        return "unknown";
+    }
+}
+
+bp::object OperationStats::asPyDict(const stats_map_t &stats)
+{
+    bp::dict py_stats;
+    stats_map_t::const_iterator it;
+    for (it = stats.begin(); it != stats.end(); ++it) {
+        bp::dict py_phases;
+        for (int i = 0; i < PHASES; ++i) {
+            py_phases[phaseName(static_cast<Phase>(i))] =
+                histogramAsPyDict(it->second.phases[i]);
+        }
+        py_stats[StringConv::asPyUnicode(it->first)] = py_phases;
+    }
+
+    return py_stats;
+}
+
+bp::object operation_stats()
+{
+    return OperationStats::asPyDict(OperationStats::global().snapshot());
+}
+
+void reset_operation_stats()
+{
+    OperationStats::global().reset();
+}
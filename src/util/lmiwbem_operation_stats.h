@@ -0,0 +1,89 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_OPERATION_STATS_H
+#  define LMIWBEM_OPERATION_STATS_H
+
+#  include <map>
+#  include <Pegasus/Common/Config.h>
+#  include "lmiwbem.h"
+#  include "lmiwbem_mutex.h"
+#  include "util/lmiwbem_histogram.h"
+#  include "util/lmiwbem_string.h"
+
+BOOST_PYTHON_BEGIN
+class object;
+BOOST_PYTHON_END
+
+namespace bp = boost::python;
+
+// Durations of phases of WBEMConnection operations measured by lmiwbem
+// itself, kept per operation. Every connection has its own statistics; all
+// of them are also aggregated process-wide.
+class OperationStats
+{
+public:
+    enum Phase {
+        // Conversion of Python arguments to Pegasus types
+        PHASE_CONVERSION,
+        // Waiting for the CIMClient transaction mutex
+        PHASE_MUTEX_WAIT,
+        // Pegasus call, including connecting, if necessary
+        PHASE_CALL,
+        // Construction of returned Python objects
+        PHASE_CONSTRUCTION,
+        PHASES
+    };
+
+    struct PhaseHistograms
+    {
+        Histogram phases[PHASES];
+    };
+
+    typedef std::map<String, PhaseHistograms> stats_map_t;
+
+    OperationStats();
+
+    // Records durations of the measured phases of one operation.
+    void record(
+        const String &operation,
+        const Pegasus::Uint64 durations[PHASES],
+        const bool measured[PHASES]);
+
+    stats_map_t snapshot();
+    void reset();
+
+    static OperationStats &global();
+    static const char *phaseName(Phase phase);
+
+    // Returns dictionary keyed by operation names; values are dictionaries
+    // keyed by phase names.
+    static bp::object asPyDict(const stats_map_t &stats);
+
+private:
+    Mutex m_mutex;
+    stats_map_t m_stats;
+};
+
+bp::object operation_stats();
+void reset_operation_stats();
+
+#endif // LMIWBEM_OPERATION_STATS_H
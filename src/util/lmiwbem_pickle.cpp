@@ -0,0 +1,108 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include <sstream>
+#include <vector>
+#include <boost/python/handle.hpp>
+#include <boost/python/object.hpp>
+#include <boost/python/tuple.hpp>
+#include <Pegasus/Common/Buffer.h>
+#include <Pegasus/Common/CIMClass.h>
+#include <Pegasus/Common/CIMInstance.h>
+#include <Pegasus/Common/XmlParser.h>
+#include <Pegasus/Common/XmlReader.h>
+#include <Pegasus/Common/XmlWriter.h>
+#include "lmiwbem_exception.h"
+#include "util/lmiwbem_convert.h"
+#include "util/lmiwbem_pickle.h"
+#include "util/lmiwbem_util.h"
+
+namespace {
+
+bp::object bufferAsPyBytes(const Pegasus::Buffer &buffer)
+{
+    return bp::object(bp::handle<>(
+        PyBytes_FromStringAndSize(buffer.getData(), buffer.size())));
+}
+
+// XmlParser needs mutable null-terminated buffer.
+std::vector<char> pyBytesAsXml(const bp::object &data)
+{
+    char *ptr;
+    Py_ssize_t size;
+    if (PyBytes_AsStringAndSize(data.ptr(), &ptr, &size) < 0)
+        bp::throw_error_already_set();
+
+    std::vector<char> xml(ptr, ptr + size);
+    xml.push_back('\0');
+    return xml;
+}
+
+} // unnamed namespace
+
+bp::object PickleConv::asPyBytes(const Pegasus::CIMInstance &instance)
+{
+    Pegasus::Buffer buffer;
+    Pegasus::XmlWriter::appendInstanceElement(buffer, instance);
+    return bufferAsPyBytes(buffer);
+}
+
+bp::object PickleConv::asPyBytes(const Pegasus::CIMClass &cls)
+{
+    Pegasus::Buffer buffer;
+    Pegasus::XmlWriter::appendClassElement(buffer, cls);
+    return bufferAsPyBytes(buffer);
+}
+
+Pegasus::CIMInstance PickleConv::asPegasusCIMInstance(const bp::object &data)
+{
+    std::vector<char> xml(pyBytesAsXml(data));
+    Pegasus::XmlParser parser(&xml[0]);
+    Pegasus::CIMInstance instance;
+    if (!Pegasus::XmlReader::getInstanceElement(parser, instance))
+        throw_ValueError("Invalid CIMInstance state");
+    return instance;
+}
+
+Pegasus::CIMClass PickleConv::asPegasusCIMClass(const bp::object &data)
+{
+    std::vector<char> xml(pyBytesAsXml(data));
+    Pegasus::XmlParser parser(&xml[0]);
+    Pegasus::CIMClass cls;
+    if (!Pegasus::XmlReader::getClassElement(parser, cls))
+        throw_ValueError("Invalid CIMClass state");
+    return cls;
+}
+
+bp::tuple PickleConv::asState(
+    const bp::object &state,
+    const char *classname,
+    long size)
+{
+    if (!istuple(state) || bp::len(state) != size) {
+        std::stringstream ss;
+        ss << "Invalid " << classname << " state";
+        throw_ValueError(ss.str());
+    }
+
+    return bp::tuple(state);
+}
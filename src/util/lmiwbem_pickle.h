@@ -0,0 +1,59 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_PICKLE_H
+#  define LMIWBEM_PICKLE_H
+
+#  include <Pegasus/Common/Config.h>
+#  include "lmiwbem.h"
+
+BOOST_PYTHON_BEGIN
+class object;
+class tuple;
+BOOST_PYTHON_END
+
+PEGASUS_BEGIN
+class CIMClass;
+class CIMInstance;
+PEGASUS_END
+
+namespace bp = boost::python;
+
+// Encoding of CIM objects in pickled state. Instances and classes are
+// stored as CIM-XML bytes produced directly from Pegasus objects, so
+// unevaluated objects don't need to be converted to Python ones.
+class PickleConv
+{
+public:
+    static bp::object asPyBytes(const Pegasus::CIMInstance &instance);
+    static bp::object asPyBytes(const Pegasus::CIMClass &cls);
+
+    static Pegasus::CIMInstance asPegasusCIMInstance(const bp::object &data);
+    static Pegasus::CIMClass asPegasusCIMClass(const bp::object &data);
+
+    // Returns state tuple of expected size; raises ValueError otherwise.
+    static bp::tuple asState(
+        const bp::object &state,
+        const char *classname,
+        long size);
+};
+
+#endif // LMIWBEM_PICKLE_H
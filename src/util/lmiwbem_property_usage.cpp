@@ -0,0 +1,228 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include <algorithm>
+#include <sstream>
+#include <vector>
+#include <boost/python/handle.hpp>
+#include <boost/python/object.hpp>
+#include <frameobject.h>
+#include "lmiwbem_exception.h"
+#include "obj/cim/lmiwbem_constants.h"
+#include "util/lmiwbem_convert.h"
+#include "util/lmiwbem_property_usage.h"
+
+namespace bp = boost::python;
+
+PropertyUsage::PropertyUsage()
+    : m_properties()
+    , m_all(false)
+    , m_learned(false)
+{
+}
+
+void PropertyUsage::access(const String &property)
+{
+    m_properties.insert(lowerCase(property));
+}
+
+void PropertyUsage::accessAll()
+{
+    m_all = true;
+}
+
+Pegasus::CIMPropertyList PropertyUsage::nextPropertyList()
+{
+    if (!m_learned || m_all) {
+        // Nothing has been recorded yet or the caller iterates over the
+        // properties; we need all of them.
+        m_learned = true;
+        return Pegasus::CIMPropertyList();
+    }
+
+    Pegasus::Array<Pegasus::CIMName> peg_property_list;
+    std::set<String>::const_iterator it;
+    for (it = m_properties.begin(); it != m_properties.end(); ++it)
+        peg_property_list.append(Pegasus::CIMName(*it));
+
+    return Pegasus::CIMPropertyList(peg_property_list);
+}
+
+PropertyUsageMap::PropertyUsageMap()
+    : m_usage()
+{
+}
+
+PropertyUsagePtr PropertyUsageMap::get(
+    const String &operation,
+    const String &ns,
+    const String &classname)
+{
+    std::stringstream ss;
+    ss << operation << ' ' << lowerCase(ns) << ':' << lowerCase(classname)
+       << ' ' << callSite();
+
+    PropertyUsagePtr &usage = m_usage[ss.str()];
+    if (!usage)
+        usage.reset(new PropertyUsage);
+
+    return usage;
+}
+
+void PropertyUsageMap::clear()
+{
+    m_usage.clear();
+}
+
+String PropertyUsageMap::callSite()
+{
+    // Topmost Python frame belongs to the caller of the CIM operation.
+    PyFrameObject *frame = PyEval_GetFrame();
+    if (!frame)
+        return String();
+
+#  if PY_VERSION_HEX >= 0x03090000
+    bp::object py_code(bp::handle<>(
+        reinterpret_cast<PyObject*>(PyFrame_GetCode(frame))));
+    PyCodeObject *code = reinterpret_cast<PyCodeObject*>(py_code.ptr());
+#  else
+    PyCodeObject *code = frame->f_code;
+#  endif // PY_VERSION_HEX
+
+    std::stringstream ss;
+    ss << ObjectConv::asString(bp::object(bp::handle<>(
+        bp::borrowed(code->co_filename))))
+       << ':' << PyFrame_GetLineNumber(frame);
+
+    return ss.str();
+}
+
+InstanceRequest::InstanceRequest(
+    Type type,
+    const Pegasus::CIMNamespaceName &ns)
+    : type(type)
+    , ns(ns)
+    , path()
+    , classname()
+    , assoc_class()
+    , result_class()
+    , role()
+    , result_role()
+    , deep_inheritance(true)
+    , local_only(false)
+    , include_qualifiers(false)
+    , include_class_origin(false)
+{
+}
+
+InstanceFetcher::~InstanceFetcher()
+{
+}
+
+PropertyUsageTracker::PropertyUsageTracker(
+    const PropertyUsagePtr &usage,
+    const InstanceFetcherPtr &fetcher,
+    const Pegasus::CIMPropertyList &property_list,
+    const InstanceRequest &request)
+    : m_usage(usage)
+    , m_fetcher(fetcher)
+    , m_is_partial(!property_list.isNull())
+    , m_request(request)
+    , m_refetched(false)
+    , m_instances()
+{
+}
+
+void PropertyUsageTracker::access(const String &property)
+{
+    m_usage->access(property);
+}
+
+void PropertyUsageTracker::accessAll()
+{
+    m_usage->accessAll();
+}
+
+bool PropertyUsageTracker::isPartial() const
+{
+    return m_is_partial;
+}
+
+Pegasus::CIMInstance PropertyUsageTracker::refetch(
+    const Pegasus::CIMObjectPath &path)
+{
+    InstanceFetcherPtr fetcher(m_fetcher.lock());
+    if (!fetcher) {
+        throw_ConnectionError(
+            "Can't fetch missing properties; connection does not exist anymore",
+            CIMConstants::CON_ERR_NOT_CONNECTED);
+    }
+
+    if (!m_refetched) {
+        // First partial instance refetches all the instances of the
+        // operation.
+        Pegasus::Array<Pegasus::CIMInstance> peg_instances(
+            fetcher->fetchInstances(m_request));
+        m_refetched = true;
+
+        const Pegasus::Uint32 cnt = peg_instances.size();
+        for (Pegasus::Uint32 i = 0; i < cnt; ++i)
+            m_instances[instanceKey(peg_instances[i].getPath())] = peg_instances[i];
+    }
+
+    std::map<String, Pegasus::CIMInstance>::iterator it =
+        m_instances.find(instanceKey(path));
+    if (it != m_instances.end()) {
+        Pegasus::CIMInstance peg_instance(it->second);
+        m_instances.erase(it);
+        return peg_instance;
+    }
+
+    // The instance was not returned by the operation this time.
+    return fetcher->fetchInstance(
+        path,
+        m_request.local_only,
+        m_request.include_qualifiers,
+        m_request.include_class_origin);
+}
+
+String PropertyUsageTracker::instanceKey(const Pegasus::CIMObjectPath &path)
+{
+    const Pegasus::Array<Pegasus::CIMKeyBinding> peg_keybindings(
+        path.getKeyBindings());
+    std::vector<String> keybindings;
+    const Pegasus::Uint32 cnt = peg_keybindings.size();
+    for (Pegasus::Uint32 i = 0; i < cnt; ++i) {
+        keybindings.push_back(
+            lowerCase(peg_keybindings[i].getName().getString()) + '=' +
+            String(peg_keybindings[i].getValue()));
+    }
+    std::sort(keybindings.begin(), keybindings.end());
+
+    std::stringstream ss;
+    ss << lowerCase(path.getClassName().getString());
+    std::vector<String>::const_iterator it;
+    for (it = keybindings.begin(); it != keybindings.end(); ++it)
+        ss << ',' << *it;
+
+    return ss.str();
+}
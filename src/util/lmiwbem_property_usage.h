@@ -0,0 +1,163 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_PROPERTY_USAGE_H
+#  define LMIWBEM_PROPERTY_USAGE_H
+
+#  include <map>
+#  include <set>
+#  include <boost/shared_ptr.hpp>
+#  include <boost/weak_ptr.hpp>
+#  include <Pegasus/Common/CIMInstance.h>
+#  include <Pegasus/Common/CIMObjectPath.h>
+#  include <Pegasus/Common/CIMPropertyList.h>
+#  include "lmiwbem.h"
+#  include "util/lmiwbem_string.h"
+
+// Set of properties read from instances returned by a single call site.
+// First request of a call site retrieves all the properties; subsequent
+// requests ask only for the properties recorded so far.
+class PropertyUsage
+{
+public:
+    PropertyUsage();
+
+    void access(const String &property);
+    void accessAll();
+
+    // Returns property list for the next request. Null list means all the
+    // properties.
+    Pegasus::CIMPropertyList nextPropertyList();
+
+private:
+    std::set<String> m_properties;
+    bool m_all;
+    bool m_learned;
+};
+
+typedef boost::shared_ptr<PropertyUsage> PropertyUsagePtr;
+
+// Map of PropertyUsage keyed by operation, namespace, class name and Python
+// call site (file and line of the caller).
+class PropertyUsageMap
+{
+public:
+    PropertyUsageMap();
+
+    PropertyUsagePtr get(
+        const String &operation,
+        const String &ns,
+        const String &classname);
+    void clear();
+
+private:
+    static String callSite();
+
+    std::map<String, PropertyUsagePtr> m_usage;
+};
+
+// CIM operation, which returned instances with restricted PropertyList.
+struct InstanceRequest
+{
+    enum Type {
+        GET_INSTANCE,
+        ENUMERATE_INSTANCES,
+        ASSOCIATORS
+    };
+
+    InstanceRequest(Type type, const Pegasus::CIMNamespaceName &ns);
+
+    Type type;
+    Pegasus::CIMNamespaceName ns;
+    // Instance of GetInstance or source object of Associators
+    Pegasus::CIMObjectPath path;
+    // Class of EnumerateInstances
+    Pegasus::CIMName classname;
+    Pegasus::CIMName assoc_class;
+    Pegasus::CIMName result_class;
+    String role;
+    String result_role;
+    bool deep_inheritance;
+    bool local_only;
+    bool include_qualifiers;
+    bool include_class_origin;
+};
+
+// Both methods raise Python exception on failure.
+class InstanceFetcher
+{
+public:
+    virtual ~InstanceFetcher();
+
+    // Runs the request once more without PropertyList.
+    virtual Pegasus::Array<Pegasus::CIMInstance> fetchInstances(
+        const InstanceRequest &request) = 0;
+
+    virtual Pegasus::CIMInstance fetchInstance(
+        const Pegasus::CIMObjectPath &path,
+        const bool local_only,
+        const bool include_qualifiers,
+        const bool include_class_origin) = 0;
+};
+
+typedef boost::shared_ptr<InstanceFetcher> InstanceFetcherPtr;
+
+// Shared by all the instances returned from one CIM operation. Records
+// property access and refetches the instances with all the properties, if
+// the operation was restricted by the PropertyList inferred from previous
+// calls. The operation is run once for all its instances.
+class PropertyUsageTracker
+{
+public:
+    PropertyUsageTracker(
+        const PropertyUsagePtr &usage,
+        const InstanceFetcherPtr &fetcher,
+        const Pegasus::CIMPropertyList &property_list,
+        const InstanceRequest &request);
+
+    void access(const String &property);
+    void accessAll();
+
+    // Returns true, if the operation did not retrieve all the properties.
+    bool isPartial() const;
+
+    // Returns instance with all the properties. Raises Python exception, if
+    // the instance can't be fetched or the connection does not exist
+    // anymore.
+    Pegasus::CIMInstance refetch(const Pegasus::CIMObjectPath &path);
+
+private:
+    // Identifies an instance regardless of host, namespace and order of
+    // keybindings.
+    static String instanceKey(const Pegasus::CIMObjectPath &path);
+
+    PropertyUsagePtr m_usage;
+    boost::weak_ptr<InstanceFetcher> m_fetcher;
+    bool m_is_partial;
+    InstanceRequest m_request;
+    bool m_refetched;
+    // Refetched instances not yet taken by their partial counterparts
+    std::map<String, Pegasus::CIMInstance> m_instances;
+};
+
+typedef boost::shared_ptr<PropertyUsageTracker> PropertyUsageTrackerPtr;
+
+#endif // LMIWBEM_PROPERTY_USAGE_H
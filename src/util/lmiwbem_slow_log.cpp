@@ -0,0 +1,158 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include <boost/python/dict.hpp>
+#include <boost/python/list.hpp>
+#include "lmiwbem_exception.h"
+#include "util/lmiwbem_convert.h"
+#include "util/lmiwbem_slow_log.h"
+#include "util/lmiwbem_util.h"
+
+SlowOperationLog::Record::Record()
+    : operation()
+    , classname()
+    , ns()
+    , hostname()
+    , timestamp(0)
+    , duration(0)
+    , phases()
+    , object_count(0)
+    , response_size(0)
+{
+}
+
+SlowOperationLog::SlowOperationLog()
+    : m_mutex()
+    , m_threshold(0)
+    , m_size(DEFAULT_SIZE)
+    , m_records()
+    , m_callback()
+{
+}
+
+Pegasus::Uint64 SlowOperationLog::getThreshold() const
+{
+    return m_threshold;
+}
+
+void SlowOperationLog::setThreshold(Pegasus::Uint64 threshold)
+{
+    m_threshold = threshold;
+}
+
+bool SlowOperationLog::isEnabled() const
+{
+    return m_threshold > 0;
+}
+
+std::size_t SlowOperationLog::getSize() const
+{
+    return m_size;
+}
+
+void SlowOperationLog::setSize(std::size_t size)
+{
+    ScopedMutex sm(m_mutex);
+    m_size = size;
+    while (m_records.size() > m_size)
+        m_records.pop_front();
+}
+
+bp::object SlowOperationLog::getCallback() const
+{
+    return m_callback;
+}
+
+void SlowOperationLog::setCallback(const bp::object &callback)
+{
+    if (!isnone(callback) && !iscallable(callback))
+        throw_TypeError("callback must be callable or None");
+
+    m_callback = callback;
+}
+
+void SlowOperationLog::append(const Record &record)
+{
+    {
+        ScopedMutex sm(m_mutex);
+        if (m_size > 0) {
+            if (m_records.size() >= m_size)
+                m_records.pop_front();
+            m_records.push_back(record);
+        }
+    }
+
+    if (isnone(m_callback))
+        return;
+
+    // The operation may be failing with a Python exception set; keep it
+    // aside while the callback runs.
+    PyObject *type, *value, *traceback;
+    PyErr_Fetch(&type, &value, &traceback);
+    try {
+        m_callback(recordAsPyDict(record));
+    } catch (const bp::error_already_set &) {
+        // Callback's exceptions must not replace the operation's result.
+        PyErr_Print();
+        PyErr_Clear();
+    }
+    PyErr_Restore(type, value, traceback);
+}
+
+bp::object SlowOperationLog::getPyRecords()
+{
+    ScopedMutex sm(m_mutex);
+    bp::list py_records;
+    std::deque<Record>::const_iterator it;
+    for (it = m_records.begin(); it != m_records.end(); ++it)
+        py_records.append(recordAsPyDict(*it));
+    return py_records;
+}
+
+void SlowOperationLog::clear()
+{
+    ScopedMutex sm(m_mutex);
+    m_records.clear();
+}
+
+bp::object SlowOperationLog::recordAsPyDict(const Record &record)
+{
+    bp::dict py_phases;
+    for (int i = 0; i < OperationStats::PHASES; ++i) {
+        py_phases[OperationStats::phaseName(
+            static_cast<OperationStats::Phase>(i))] = record.phases[i];
+    }
+
+    bp::dict py_record;
+    py_record["operation"] = StringConv::asPyUnicode(record.operation);
+    py_record["classname"] = record.classname.empty() ?
+        None : StringConv::asPyUnicode(record.classname);
+    py_record["namespace"] = record.ns.empty() ?
+        None : StringConv::asPyUnicode(record.ns);
+    py_record["hostname"] = StringConv::asPyUnicode(record.hostname);
+    py_record["time"] = static_cast<long>(record.timestamp);
+    py_record["duration"] = record.duration;
+    py_record["phases"] = py_phases;
+    py_record["object_count"] = record.object_count;
+    py_record["response_size"] = record.response_size;
+    return py_record;
+}
@@ -0,0 +1,91 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_SLOW_LOG_H
+#  define LMIWBEM_SLOW_LOG_H
+
+#  include <cstddef>
+#  include <ctime>
+#  include <deque>
+#  include <boost/python/object.hpp>
+#  include <Pegasus/Common/Config.h>
+#  include "lmiwbem.h"
+#  include "lmiwbem_mutex.h"
+#  include "util/lmiwbem_operation_stats.h"
+#  include "util/lmiwbem_string.h"
+
+namespace bp = boost::python;
+
+// Bounded log of WBEMConnection operations, which took longer than a
+// threshold. Records are kept in a ring of limited size and optionally
+// passed to a Python callback.
+class SlowOperationLog
+{
+public:
+    struct Record
+    {
+        Record();
+
+        String operation;
+        String classname;
+        String ns;
+        String hostname;
+        time_t timestamp;
+        Pegasus::Uint64 duration;
+        Pegasus::Uint64 phases[OperationStats::PHASES];
+        Pegasus::Uint64 object_count;
+        Pegasus::Uint64 response_size;
+    };
+
+    static const std::size_t DEFAULT_SIZE = 100;
+
+    SlowOperationLog();
+
+    // Threshold in microseconds; 0 disables the log.
+    Pegasus::Uint64 getThreshold() const;
+    void setThreshold(Pegasus::Uint64 threshold);
+    bool isEnabled() const;
+
+    std::size_t getSize() const;
+    void setSize(std::size_t size);
+
+    // Python callable called with a dictionary for every slow operation.
+    // None disables the callback.
+    bp::object getCallback() const;
+    void setCallback(const bp::object &callback);
+
+    // Stores the record and calls the callback; needs the GIL.
+    void append(const Record &record);
+
+    bp::object getPyRecords();
+    void clear();
+
+private:
+    static bp::object recordAsPyDict(const Record &record);
+
+    Mutex m_mutex;
+    Pegasus::Uint64 m_threshold;
+    std::size_t m_size;
+    std::deque<Record> m_records;
+    bp::object m_callback;
+};
+
+#endif // LMIWBEM_SLOW_LOG_H
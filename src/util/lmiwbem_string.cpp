@@ -19,6 +19,7 @@
  *
  * ***** END LICENSE BLOCK ***** */
 
+#include <cctype>
 #include "util/lmiwbem_string.h"
 
 String::String()
@@ -96,3 +97,12 @@ String &String::operator+=(const Pegasus::String &rhs)
     std::string::operator+=(rhs.getCString());
     return *this;
 }
+
+String lowerCase(const String &str)
+{
+    // Plain char may be negative; <cctype> functions need unsigned char.
+    String low(str);
+    for (String::iterator it = low.begin(); it != low.end(); ++it)
+        *it = static_cast<char>(tolower(static_cast<unsigned char>(*it)));
+    return low;
+}
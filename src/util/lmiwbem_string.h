@@ -50,4 +50,7 @@ public:
     using std::string::npos;
 };
 
+// Returns copy of the string converted to lower case.
+String lowerCase(const String &str);
+
 #endif // LMIWBEM_STRING_H
@@ -20,8 +20,8 @@
  * ***** END LICENSE BLOCK ***** */
 
 #include <config.h>
-#include <algorithm>
 #include <cstring>
+#include <strings.h>
 #include <boost/python/borrowed.hpp>
 #include <boost/python/handle.hpp>
 #include <boost/python/list.hpp>
@@ -145,10 +145,6 @@ bool cim_issubclass(
 
     String c_subclass;
     String c_subsuperclass;
-    String c_lsubclass;
-    String c_lsuperclass(c_superclass);
-    std::transform(c_lsuperclass.begin(), c_lsuperclass.end(),
-        c_lsuperclass.begin(), ::tolower);
 
     if (isinstance(subclass, CIMClass::type())) {
         const CIMClass &cim_subclass = CIMClass::asNative(subclass);
@@ -158,13 +154,20 @@ bool cim_issubclass(
         c_subclass = StringConv::asString(subclass, "subclass");
     }
 
+    // Answer from the class hierarchy, if it was already retrieved by the
+    // connection; classes created since then are looked up by GetClass.
+    ClassHierarchyPtr hierarchy(c_conn.classHierarchy(c_ns, false));
+    if (hierarchy) {
+        bool known;
+        const bool is_subclass = hierarchy->isSubclass(
+            c_superclass, c_subclass, known);
+        if (known)
+            return is_subclass;
+    }
+
     while (1) {
         // Matching is case insensitive.
-        c_lsubclass = c_subclass;
-        std::transform(c_lsubclass.begin(), c_lsubclass.end(),
-            c_lsubclass.begin(), ::tolower);
-
-        if (c_lsubclass == c_lsuperclass) {
+        if (strcasecmp(c_subclass.c_str(), c_superclass.c_str()) == 0) {
             // Do subclass and superclass match?
             return true;
         } else if (c_subsuperclass.empty()) {
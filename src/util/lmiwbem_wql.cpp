@@ -0,0 +1,852 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <config.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <Pegasus/Common/CIMDateTime.h>
+#include <Pegasus/Common/CIMObjectPath.h>
+#include <Pegasus/Common/CIMProperty.h>
+#include <Pegasus/Common/CIMValue.h>
+#include <Pegasus/Common/Char16.h>
+#include "lmiwbem_exception.h"
+#include "util/lmiwbem_wql.h"
+
+namespace {
+
+enum CompareOp {
+    OP_EQ,
+    OP_NE,
+    OP_LT,
+    OP_LE,
+    OP_GT,
+    OP_GE
+};
+
+// Used, when literal is on the left side of the comparison.
+CompareOp swapCompareOp(CompareOp op)
+{
+    switch (op) {
+    case OP_LT:
+        return OP_GT;
+    case OP_LE:
+        return OP_GE;
+    case OP_GT:
+        return OP_LT;
+    case OP_GE:
+        return OP_LE;
+    default:
+        return op;
+    }
+}
+
+template <typename T>
+T getCIMValue(const Pegasus::CIMValue &value)
+{
+    T result;
+    value.get(result);
+    return result;
+}
+
+// Character classification of <cctype> is undefined for negative values;
+// query may contain non-ASCII characters.
+inline bool isSpace(char c)
+{
+    return isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+inline bool isAlpha(char c)
+{
+    return isalpha(static_cast<unsigned char>(c)) != 0;
+}
+
+inline bool isDigit(char c)
+{
+    return isdigit(static_cast<unsigned char>(c)) != 0;
+}
+
+inline bool isAlnum(char c)
+{
+    return isalnum(static_cast<unsigned char>(c)) != 0;
+}
+
+inline char toUpper(char c)
+{
+    return static_cast<char>(toupper(static_cast<unsigned char>(c)));
+}
+
+inline char toLower(char c)
+{
+    return static_cast<char>(tolower(static_cast<unsigned char>(c)));
+}
+
+String upperCase(const String &str)
+{
+    String up(str);
+    std::transform(up.begin(), up.end(), up.begin(), toUpper);
+    return up;
+}
+
+} // unnamed namespace
+
+// -----------------------------------------------------------------------------
+// Value
+// -----------------------------------------------------------------------------
+
+class WQLQuery::Value
+{
+public:
+    enum Type {
+        NULL_VALUE,
+        BOOLEAN,
+        INTEGER,
+        REAL,
+        STRING,
+        UNSUPPORTED
+    };
+
+    Value();
+
+    static Value fromBoolean(bool value);
+    static Value fromInteger(Pegasus::Sint64 value);
+    static Value fromReal(double value);
+    static Value fromString(const String &value);
+    static Value fromCIMValue(const Pegasus::CIMValue &value);
+
+    bool isNull() const { return m_type == NULL_VALUE; }
+    bool compare(const Value &rhs, CompareOp op) const;
+
+private:
+    bool isNumeric() const { return m_type == INTEGER || m_type == REAL; }
+    double asReal() const { return m_type == INTEGER ? m_int : m_real; }
+
+    Type m_type;
+    bool m_bool;
+    Pegasus::Sint64 m_int;
+    double m_real;
+    String m_str;
+};
+
+WQLQuery::Value::Value()
+    : m_type(NULL_VALUE)
+    , m_bool(false)
+    , m_int(0)
+    , m_real(0.0)
+    , m_str()
+{
+}
+
+WQLQuery::Value WQLQuery::Value::fromBoolean(bool value)
+{
+    Value v;
+    v.m_type = BOOLEAN;
+    v.m_bool = value;
+    return v;
+}
+
+WQLQuery::Value WQLQuery::Value::fromInteger(Pegasus::Sint64 value)
+{
+    Value v;
+    v.m_type = INTEGER;
+    v.m_int = value;
+    return v;
+}
+
+WQLQuery::Value WQLQuery::Value::fromReal(double value)
+{
+    Value v;
+    v.m_type = REAL;
+    v.m_real = value;
+    return v;
+}
+
+WQLQuery::Value WQLQuery::Value::fromString(const String &value)
+{
+    Value v;
+    v.m_type = STRING;
+    v.m_str = value;
+    return v;
+}
+
+WQLQuery::Value WQLQuery::Value::fromCIMValue(const Pegasus::CIMValue &value)
+{
+    if (value.isNull())
+        return Value();
+
+    if (value.isArray()) {
+        // Arrays can't be compared with a scalar literal.
+        Value v;
+        v.m_type = UNSUPPORTED;
+        return v;
+    }
+
+    switch (value.getType()) {
+    case Pegasus::CIMTYPE_BOOLEAN:
+        return fromBoolean(getCIMValue<Pegasus::Boolean>(value));
+    case Pegasus::CIMTYPE_UINT8:
+        return fromInteger(getCIMValue<Pegasus::Uint8>(value));
+    case Pegasus::CIMTYPE_SINT8:
+        return fromInteger(getCIMValue<Pegasus::Sint8>(value));
+    case Pegasus::CIMTYPE_UINT16:
+        return fromInteger(getCIMValue<Pegasus::Uint16>(value));
+    case Pegasus::CIMTYPE_SINT16:
+        return fromInteger(getCIMValue<Pegasus::Sint16>(value));
+    case Pegasus::CIMTYPE_UINT32:
+        return fromInteger(getCIMValue<Pegasus::Uint32>(value));
+    case Pegasus::CIMTYPE_SINT32:
+        return fromInteger(getCIMValue<Pegasus::Sint32>(value));
+    case Pegasus::CIMTYPE_UINT64: {
+        const Pegasus::Uint64 n = getCIMValue<Pegasus::Uint64>(value);
+        if (n > static_cast<Pegasus::Uint64>(
+            std::numeric_limits<Pegasus::Sint64>::max()))
+        {
+            return fromReal(static_cast<double>(n));
+        }
+        return fromInteger(static_cast<Pegasus::Sint64>(n));
+    }
+    case Pegasus::CIMTYPE_SINT64:
+        return fromInteger(getCIMValue<Pegasus::Sint64>(value));
+    case Pegasus::CIMTYPE_REAL32:
+        return fromReal(getCIMValue<Pegasus::Real32>(value));
+    case Pegasus::CIMTYPE_REAL64:
+        return fromReal(getCIMValue<Pegasus::Real64>(value));
+    case Pegasus::CIMTYPE_CHAR16:
+        // Char16 is represented as Uint16 in Python, too.
+        return fromInteger(static_cast<Pegasus::Uint16>(
+            getCIMValue<Pegasus::Char16>(value)));
+    case Pegasus::CIMTYPE_STRING:
+        return fromString(getCIMValue<Pegasus::String>(value));
+    case Pegasus::CIMTYPE_DATETIME:
+        return fromString(getCIMValue<Pegasus::CIMDateTime>(value).toString());
+    case Pegasus::CIMTYPE_REFERENCE:
+        return fromString(getCIMValue<Pegasus::CIMObjectPath>(value).toString());
+    default: {
+        Value v;
+        v.m_type = UNSUPPORTED;
+        return v;
+    }
+    }
+}
+
+bool WQLQuery::Value::compare(const Value &rhs, CompareOp op) const
+{
+    // NULL is not equal, less or greater than anything; it needs to be
+    // tested by IS NULL.
+    if (m_type == NULL_VALUE || rhs.m_type == NULL_VALUE ||
+        m_type == UNSUPPORTED || rhs.m_type == UNSUPPORTED)
+    {
+        return false;
+    }
+
+    int cmp = 0;
+    if (isNumeric() && rhs.isNumeric()) {
+        if (m_type == INTEGER && rhs.m_type == INTEGER) {
+            cmp = m_int < rhs.m_int ? -1 : m_int > rhs.m_int ? 1 : 0;
+        } else {
+            const double lhs_real = asReal();
+            const double rhs_real = rhs.asReal();
+            cmp = lhs_real < rhs_real ? -1 : lhs_real > rhs_real ? 1 : 0;
+        }
+    } else if (m_type != rhs.m_type) {
+        return false;
+    } else if (m_type == STRING) {
+        cmp = m_str.compare(rhs.m_str);
+    } else {
+        cmp = static_cast<int>(m_bool) - static_cast<int>(rhs.m_bool);
+    }
+
+    switch (op) {
+    case OP_EQ:
+        return cmp == 0;
+    case OP_NE:
+        return cmp != 0;
+    case OP_LT:
+        return cmp < 0;
+    case OP_LE:
+        return cmp <= 0;
+    case OP_GT:
+        return cmp > 0;
+    case OP_GE:
+        return cmp >= 0;
+    }
+
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Conditions
+// -----------------------------------------------------------------------------
+
+class WQLQuery::Condition
+{
+public:
+    virtual ~Condition() { }
+    virtual bool evaluate(const Pegasus::CIMInstance &instance) const = 0;
+
+protected:
+    static WQLQuery::Value propertyValue(
+        const Pegasus::CIMInstance &instance,
+        const Pegasus::CIMName &property);
+};
+
+WQLQuery::Value WQLQuery::Condition::propertyValue(
+    const Pegasus::CIMInstance &instance,
+    const Pegasus::CIMName &property)
+{
+    const Pegasus::Uint32 idx = instance.findProperty(property);
+    if (idx == PEG_NOT_FOUND)
+        return Value();
+    return Value::fromCIMValue(instance.getProperty(idx).getValue());
+}
+
+namespace {
+
+class ComparisonCondition: public WQLQuery::Condition
+{
+public:
+    ComparisonCondition(
+        const Pegasus::CIMName &property,
+        CompareOp op,
+        const WQLQuery::Value &literal)
+        : m_property(property)
+        , m_op(op)
+        , m_literal(literal)
+    {
+    }
+
+    bool evaluate(const Pegasus::CIMInstance &instance) const
+    {
+        return propertyValue(instance, m_property).compare(m_literal, m_op);
+    }
+
+private:
+    Pegasus::CIMName m_property;
+    CompareOp m_op;
+    WQLQuery::Value m_literal;
+};
+
+class NullCondition: public WQLQuery::Condition
+{
+public:
+    NullCondition(const Pegasus::CIMName &property, bool negate)
+        : m_property(property)
+        , m_negate(negate)
+    {
+    }
+
+    bool evaluate(const Pegasus::CIMInstance &instance) const
+    {
+        return propertyValue(instance, m_property).isNull() != m_negate;
+    }
+
+private:
+    Pegasus::CIMName m_property;
+    bool m_negate;
+};
+
+class NotCondition: public WQLQuery::Condition
+{
+public:
+    NotCondition(const WQLQuery::ConditionPtr &condition)
+        : m_condition(condition)
+    {
+    }
+
+    bool evaluate(const Pegasus::CIMInstance &instance) const
+    {
+        return !m_condition->evaluate(instance);
+    }
+
+private:
+    WQLQuery::ConditionPtr m_condition;
+};
+
+class AndCondition: public WQLQuery::Condition
+{
+public:
+    AndCondition(
+        const WQLQuery::ConditionPtr &lhs,
+        const WQLQuery::ConditionPtr &rhs)
+        : m_lhs(lhs)
+        , m_rhs(rhs)
+    {
+    }
+
+    bool evaluate(const Pegasus::CIMInstance &instance) const
+    {
+        return m_lhs->evaluate(instance) && m_rhs->evaluate(instance);
+    }
+
+private:
+    WQLQuery::ConditionPtr m_lhs;
+    WQLQuery::ConditionPtr m_rhs;
+};
+
+class OrCondition: public WQLQuery::Condition
+{
+public:
+    OrCondition(
+        const WQLQuery::ConditionPtr &lhs,
+        const WQLQuery::ConditionPtr &rhs)
+        : m_lhs(lhs)
+        , m_rhs(rhs)
+    {
+    }
+
+    bool evaluate(const Pegasus::CIMInstance &instance) const
+    {
+        return m_lhs->evaluate(instance) || m_rhs->evaluate(instance);
+    }
+
+private:
+    WQLQuery::ConditionPtr m_lhs;
+    WQLQuery::ConditionPtr m_rhs;
+};
+
+} // unnamed namespace
+
+// -----------------------------------------------------------------------------
+// Parser
+// -----------------------------------------------------------------------------
+
+class WQLQuery::Parser
+{
+public:
+    Parser(const String &query);
+
+    void parse(WQLQuery &query);
+
+private:
+    enum TokenType {
+        TOKEN_END,
+        TOKEN_IDENTIFIER,
+        TOKEN_STRING,
+        TOKEN_NUMBER,
+        TOKEN_OPERATOR,
+        TOKEN_LPAREN,
+        TOKEN_RPAREN,
+        TOKEN_COMMA,
+        TOKEN_STAR
+    };
+
+    struct Token
+    {
+        TokenType type;
+        String text;
+    };
+
+    void tokenize();
+    void addToken(TokenType type, const String &text);
+
+    const Token &peek() const;
+    Token next();
+    bool isKeyword(const Token &token, const char *keyword) const;
+    bool acceptKeyword(const char *keyword);
+    void expectKeyword(const char *keyword);
+    Pegasus::CIMName expectIdentifier();
+
+    WQLQuery::ConditionPtr parseOr();
+    WQLQuery::ConditionPtr parseAnd();
+    WQLQuery::ConditionPtr parseNot();
+    WQLQuery::ConditionPtr parsePrimary();
+    bool isLiteral(const Token &token) const;
+    WQLQuery::Value parseLiteral();
+    CompareOp parseOperator();
+
+    void error(const String &message) const;
+
+    String m_query;
+    std::vector<Token> m_tokens;
+    size_t m_pos;
+};
+
+WQLQuery::Parser::Parser(const String &query)
+    : m_query(query)
+    , m_tokens()
+    , m_pos(0)
+{
+}
+
+void WQLQuery::Parser::parse(WQLQuery &query)
+{
+    tokenize();
+
+    expectKeyword("SELECT");
+    if (peek().type == TOKEN_STAR) {
+        next();
+        query.m_select_all = true;
+    } else {
+        query.m_select_all = false;
+        query.m_select_list.push_back(expectIdentifier());
+        while (peek().type == TOKEN_COMMA) {
+            next();
+            query.m_select_list.push_back(expectIdentifier());
+        }
+    }
+
+    expectKeyword("FROM");
+    query.m_classname = expectIdentifier().getString();
+
+    if (acceptKeyword("WHERE"))
+        query.m_condition = parseOr();
+
+    if (peek().type != TOKEN_END)
+        error("unexpected '" + peek().text + "'");
+}
+
+void WQLQuery::Parser::tokenize()
+{
+    const String &q = m_query;
+    size_t i = 0;
+    while (i < q.size()) {
+        const char c = q[i];
+        if (isSpace(c)) {
+            ++i;
+        } else if (isAlpha(c) || c == '_') {
+            size_t j = i;
+            while (j < q.size() && (isAlnum(q[j]) || q[j] == '_'))
+                ++j;
+            addToken(TOKEN_IDENTIFIER, q.substr(i, j - i));
+            i = j;
+        } else if (isDigit(c) || ((c == '-' || c == '+' || c == '.') &&
+            i + 1 < q.size() && (isDigit(q[i + 1]) || q[i + 1] == '.')))
+        {
+            size_t j = i + 1;
+            while (j < q.size() && (isAlnum(q[j]) || q[j] == '.' ||
+                ((q[j] == '-' || q[j] == '+') && toLower(q[j - 1]) == 'e')))
+            {
+                ++j;
+            }
+            addToken(TOKEN_NUMBER, q.substr(i, j - i));
+            i = j;
+        } else if (c == '\'' || c == '"') {
+            // Quote character is escaped by doubling it or by backslash.
+            String str;
+            size_t j = i + 1;
+            for (;; ++j) {
+                if (j >= q.size())
+                    error("unterminated string literal");
+                if (q[j] == '\\' && j + 1 < q.size()) {
+                    str.push_back(q[++j]);
+                } else if (q[j] == c) {
+                    if (j + 1 < q.size() && q[j + 1] == c)
+                        str.push_back(q[++j]);
+                    else
+                        break;
+                } else {
+                    str.push_back(q[j]);
+                }
+            }
+            addToken(TOKEN_STRING, str);
+            i = j + 1;
+        } else if (c == '<' || c == '>' || c == '!' || c == '=') {
+            size_t len = 1;
+            if (i + 1 < q.size() &&
+                (q[i + 1] == '=' || (c == '<' && q[i + 1] == '>')))
+            {
+                len = 2;
+            }
+            const String op(q.substr(i, len));
+            if (op == "!")
+                error("unexpected '!'");
+            addToken(TOKEN_OPERATOR, op);
+            i += len;
+        } else if (c == '(') {
+            addToken(TOKEN_LPAREN, "(");
+            ++i;
+        } else if (c == ')') {
+            addToken(TOKEN_RPAREN, ")");
+            ++i;
+        } else if (c == ',') {
+            addToken(TOKEN_COMMA, ",");
+            ++i;
+        } else if (c == '*') {
+            addToken(TOKEN_STAR, "*");
+            ++i;
+        } else {
+            error(String("unexpected character '") + c + "'");
+        }
+    }
+
+    addToken(TOKEN_END, String());
+}
+
+void WQLQuery::Parser::addToken(TokenType type, const String &text)
+{
+    Token token;
+    token.type = type;
+    token.text = text;
+    m_tokens.push_back(token);
+}
+
+const WQLQuery::Parser::Token &WQLQuery::Parser::peek() const
+{
+    return m_tokens[m_pos];
+}
+
+WQLQuery::Parser::Token WQLQuery::Parser::next()
+{
+    const Token &token = m_tokens[m_pos];
+    if (token.type != TOKEN_END)
+        ++m_pos;
+    return token;
+}
+
+bool WQLQuery::Parser::isKeyword(const Token &token, const char *keyword) const
+{
+    return token.type == TOKEN_IDENTIFIER && upperCase(token.text) == keyword;
+}
+
+bool WQLQuery::Parser::acceptKeyword(const char *keyword)
+{
+    if (!isKeyword(peek(), keyword))
+        return false;
+    next();
+    return true;
+}
+
+void WQLQuery::Parser::expectKeyword(const char *keyword)
+{
+    if (!acceptKeyword(keyword))
+        error(String("expected ") + keyword);
+}
+
+Pegasus::CIMName WQLQuery::Parser::expectIdentifier()
+{
+    const Token token = next();
+    if (token.type != TOKEN_IDENTIFIER)
+        error("expected identifier");
+    return Pegasus::CIMName(token.text);
+}
+
+WQLQuery::ConditionPtr WQLQuery::Parser::parseOr()
+{
+    WQLQuery::ConditionPtr condition = parseAnd();
+    while (acceptKeyword("OR"))
+        condition.reset(new OrCondition(condition, parseAnd()));
+    return condition;
+}
+
+WQLQuery::ConditionPtr WQLQuery::Parser::parseAnd()
+{
+    WQLQuery::ConditionPtr condition = parseNot();
+    while (acceptKeyword("AND"))
+        condition.reset(new AndCondition(condition, parseNot()));
+    return condition;
+}
+
+WQLQuery::ConditionPtr WQLQuery::Parser::parseNot()
+{
+    if (acceptKeyword("NOT"))
+        return WQLQuery::ConditionPtr(new NotCondition(parseNot()));
+    return parsePrimary();
+}
+
+WQLQuery::ConditionPtr WQLQuery::Parser::parsePrimary()
+{
+    if (peek().type == TOKEN_LPAREN) {
+        next();
+        WQLQuery::ConditionPtr condition = parseOr();
+        if (next().type != TOKEN_RPAREN)
+            error("expected ')'");
+        return condition;
+    }
+
+    if (isLiteral(peek())) {
+        // literal op property
+        const WQLQuery::Value literal = parseLiteral();
+        const CompareOp op = parseOperator();
+        const Pegasus::CIMName property = expectIdentifier();
+        return WQLQuery::ConditionPtr(
+            new ComparisonCondition(property, swapCompareOp(op), literal));
+    }
+
+    const Pegasus::CIMName property = expectIdentifier();
+    if (acceptKeyword("IS")) {
+        const bool negate = acceptKeyword("NOT");
+        expectKeyword("NULL");
+        return WQLQuery::ConditionPtr(new NullCondition(property, negate));
+    }
+
+    const CompareOp op = parseOperator();
+    if (!isLiteral(peek()))
+        error("expected literal");
+
+    const WQLQuery::Value literal = parseLiteral();
+    if (literal.isNull()) {
+        // "prop = NULL" is never true in SQL; treat it as IS NULL, which is
+        // what the users usually mean.
+        if (op != OP_EQ && op != OP_NE)
+            error("NULL can be compared only by = or <>");
+        return WQLQuery::ConditionPtr(new NullCondition(property, op == OP_NE));
+    }
+
+    return WQLQuery::ConditionPtr(
+        new ComparisonCondition(property, op, literal));
+}
+
+bool WQLQuery::Parser::isLiteral(const Token &token) const
+{
+    return token.type == TOKEN_STRING ||
+        token.type == TOKEN_NUMBER ||
+        isKeyword(token, "TRUE") ||
+        isKeyword(token, "FALSE") ||
+        isKeyword(token, "NULL");
+}
+
+WQLQuery::Value WQLQuery::Parser::parseLiteral()
+{
+    const Token token = next();
+    if (token.type == TOKEN_STRING)
+        return WQLQuery::Value::fromString(token.text);
+    if (isKeyword(token, "TRUE"))
+        return WQLQuery::Value::fromBoolean(true);
+    if (isKeyword(token, "FALSE"))
+        return WQLQuery::Value::fromBoolean(false);
+    if (isKeyword(token, "NULL"))
+        return WQLQuery::Value();
+
+    // Numeric literal; integers may be also hexadecimal. Leading zeros
+    // don't make the integer octal.
+    const char *str = token.text.c_str();
+    const char *digits = (*str == '+' || *str == '-') ? str + 1 : str;
+    const bool is_hex = digits[0] == '0' &&
+        (digits[1] == 'x' || digits[1] == 'X');
+    char *end = NULL;
+    errno = 0;
+    const long long n = strtoll(str, &end, is_hex ? 16 : 10);
+    if (end != str && *end == '\0') {
+        if (errno != ERANGE)
+            return WQLQuery::Value::fromInteger(n);
+        if (is_hex)
+            error("number out of range '" + token.text + "'");
+        // Decimal integer out of range is compared as real.
+    } else if (is_hex) {
+        error("invalid number '" + token.text + "'");
+    }
+
+    errno = 0;
+    const double d = strtod(str, &end);
+    if (end == str || *end != '\0')
+        error("invalid number '" + token.text + "'");
+    if (errno == ERANGE && (d == HUGE_VAL || d == -HUGE_VAL))
+        error("number out of range '" + token.text + "'");
+    return WQLQuery::Value::fromReal(d);
+}
+
+CompareOp WQLQuery::Parser::parseOperator()
+{
+    const Token token = next();
+    if (token.type != TOKEN_OPERATOR)
+        error("expected comparison operator");
+
+    if (token.text == "=")
+        return OP_EQ;
+    else if (token.text == "<>" || token.text == "!=")
+        return OP_NE;
+    else if (token.text == "<")
+        return OP_LT;
+    else if (token.text == "<=")
+        return OP_LE;
+    else if (token.text == ">")
+        return OP_GT;
+    else if (token.text == ">=")
+        return OP_GE;
+
+    error("unknown operator '" + token.text + "'");
+    return OP_EQ;
+}
+
+void WQLQuery::Parser::error(const String &message) const
+{
+    throw_ValueError("Invalid query '" + m_query + "': " + message);
+}
+
+// -----------------------------------------------------------------------------
+// WQLQuery
+// -----------------------------------------------------------------------------
+
+WQLQuery::WQLQuery(const String &query)
+    : m_query(query)
+    , m_classname()
+    , m_select_all(true)
+    , m_select_list()
+    , m_condition()
+{
+    Parser parser(query);
+    parser.parse(*this);
+}
+
+bool WQLQuery::evaluate(const Pegasus::CIMInstance &instance) const
+{
+    return !m_condition || m_condition->evaluate(instance);
+}
+
+void WQLQuery::applyProjection(Pegasus::CIMInstance &instance) const
+{
+    if (m_select_all)
+        return;
+
+    // Iterate backwards, so the indices stay valid while removing.
+    for (Pegasus::Uint32 i = instance.getPropertyCount(); i > 0; --i) {
+        const Pegasus::CIMName name = instance.getProperty(i - 1).getName();
+
+        std::vector<Pegasus::CIMName>::const_iterator it;
+        for (it = m_select_list.begin(); it != m_select_list.end(); ++it) {
+            if (it->equal(name))
+                break;
+        }
+
+        if (it == m_select_list.end())
+            instance.removeProperty(i - 1);
+    }
+}
+
+Pegasus::Array<Pegasus::CIMInstance> WQLQuery::apply(
+    const Pegasus::Array<Pegasus::CIMInstance> &instances) const
+{
+    Pegasus::Array<Pegasus::CIMInstance> result;
+    const Pegasus::Uint32 cnt = instances.size();
+    for (Pegasus::Uint32 i = 0; i < cnt; ++i) {
+        if (!evaluate(instances[i]))
+            continue;
+
+        Pegasus::CIMInstance instance(instances[i]);
+        applyProjection(instance);
+        result.append(instance);
+    }
+
+    return result;
+}
+
+String WQLQuery::getQuery() const
+{
+    return m_query;
+}
+
+String WQLQuery::getClassName() const
+{
+    return m_classname;
+}
@@ -0,0 +1,74 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ *
+ *   Copyright (C) 2014, Peter Hatina <phatina@redhat.com>
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation, either version 2.1 of the
+ *   License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *   MA 02110-1301 USA
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef   LMIWBEM_WQL_H
+#  define LMIWBEM_WQL_H
+
+#  include <vector>
+#  include <boost/shared_ptr.hpp>
+#  include <Pegasus/Common/Array.h>
+#  include <Pegasus/Common/CIMInstance.h>
+#  include <Pegasus/Common/CIMName.h>
+#  include "lmiwbem.h"
+#  include "util/lmiwbem_string.h"
+
+PEGASUS_BEGIN
+class CIMValue;
+PEGASUS_END
+
+// Client-side evaluator of a WQL/CQL subset:
+//
+//     SELECT * | prop[, prop ...] FROM class [WHERE condition]
+//
+// Condition may contain comparisons of a property and a literal (=, <>, !=,
+// <, <=, >, >=), IS [NOT] NULL, AND, OR, NOT and parentheses. Literals are
+// quoted strings, numbers, TRUE, FALSE and NULL. The class in FROM clause is
+// not checked; it is given by the enumeration the query is attached to.
+class WQLQuery
+{
+public:
+    WQLQuery(const String &query);
+
+    bool evaluate(const Pegasus::CIMInstance &instance) const;
+    void applyProjection(Pegasus::CIMInstance &instance) const;
+
+    // Returns only matching instances with projection applied.
+    Pegasus::Array<Pegasus::CIMInstance> apply(
+        const Pegasus::Array<Pegasus::CIMInstance> &instances) const;
+
+    String getQuery() const;
+    String getClassName() const;
+
+    class Value;
+    class Condition;
+    typedef boost::shared_ptr<Condition> ConditionPtr;
+
+private:
+    class Parser;
+
+    String m_query;
+    String m_classname;
+    bool m_select_all;
+    std::vector<Pegasus::CIMName> m_select_list;
+    ConditionPtr m_condition;
+};
+
+#endif // LMIWBEM_WQL_H